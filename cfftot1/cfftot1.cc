@@ -19,8 +19,9 @@
 #include <efont/t1item.hh>
 #include <lcdf/clp.h>
 #include <lcdf/error.hh>
-#include "maket1font.hh"
+#include <lcdf/mapfile.hh>
 #include <efont/cff.hh>
+#include <efont/maket1font.hh>
 #include <efont/otf.hh>
 #include <stdlib.h>
 #include <string.h>
@@ -45,11 +46,15 @@ using namespace Efont;
 #define PFA_OPT		305
 #define OUTPUT_OPT	306
 #define NAME_OPT	307
+#define JOBS_OPT	308
+#define FIND_SUBRS_OPT	309
 
 const Clp_Option options[] = {
     { "ascii", 'a', PFA_OPT, 0, 0 },
     { "binary", 'b', PFB_OPT, 0, 0 },
+    { "find-subrs", 0, FIND_SUBRS_OPT, 0, Clp_Negate },
     { "help", 'h', HELP_OPT, 0, 0 },
+    { "jobs", 'j', JOBS_OPT, Clp_ValUnsigned, 0 },
     { "name", 'n', NAME_OPT, Clp_ValString, 0 },
     { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
     { "pfa", 'a', PFA_OPT, 0, 0 },
@@ -61,6 +66,8 @@ const Clp_Option options[] = {
 
 static const char *program_name;
 static bool binary = true;
+static int jobs = 1;
+static bool find_subrs = false;
 
 
 void
@@ -92,6 +99,9 @@ Options:\n\
   -a, --pfa                    Output PFA font.\n\
   -b, --pfb                    Output PFB font. This is the default.\n\
   -n, --name=NAME              Select font NAME from CFF.\n\
+  -j, --jobs=N                 Use N processes to convert glyphs [1].\n\
+      --find-subrs             Build subroutines from repeated glyph fragments\n\
+                               instead of from the CFF%,s subroutines.\n\
   -o, --output=FILE            Write output to FILE.\n\
   -q, --quiet                  Do not generate any error messages.\n\
   -h, --help                   Print this message and exit.\n\
@@ -126,23 +136,15 @@ do_file(const char *infn, const char *outfn, PermString name, ErrorHandler *errh
     if (c != 1 && c != 'O')
 	errh->fatal("%s: not a CFF or OpenType/CFF font", infn);
 
-    StringAccum sa(150000);
-    int amt;
-    do {
-	if (char *x = sa.reserve(32768)) {
-	    amt = fread(x, 1, 32768, f);
-	    sa.adjust_length(amt);
-	} else
-	    amt = 0;
-    } while (amt != 0);
-    if (!feof(f) || ferror(f))
-	errh->lerror(infn, "%s", strerror(errno));
+    int f_errno;
+    String data = read_file_data(f, &f_errno);
+    if (f_errno)
+	errh->lerror(infn, "%s", strerror(f_errno));
     if (f != stdin)
 	fclose(f);
 
     ContextErrorHandler cerrh(errh, "While processing %s:", infn);
     cerrh.set_indent(0);
-    String data = sa.take_string();
     unsigned units_per_em = 0;
     if (c == 'O') {
         Efont::OpenType::Font font(data, &cerrh);
@@ -159,7 +161,7 @@ do_file(const char *infn, const char *outfn, PermString name, ErrorHandler *errh
     if (errh->nerrors() > 0)
 	return;
 
-    Type1Font *font1 = create_type1_font(font, &cerrh);
+    Type1Font *font1 = create_type1_font(font, &cerrh, jobs, find_subrs);
 
     if (!outfn || strcmp(outfn, "-") == 0) {
 	f = stdout;
@@ -212,6 +214,14 @@ main(int argc, char *argv[])
 	    font_name = clp->vstr;
 	    break;
 
+	  case FIND_SUBRS_OPT:
+	    find_subrs = !clp->negated;
+	    break;
+
+	  case JOBS_OPT:
+	    jobs = (clp->val.u ? clp->val.u : 1);
+	    break;
+
 	  case QUIET_OPT:
 	    if (clp->negated)
 		errh = ErrorHandler::default_handler();
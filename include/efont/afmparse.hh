@@ -22,9 +22,18 @@ class AfmParser { public:
     void clear_message()                { _message = PermString(); }
 
     PermString keyword() const;
+    int keyword_length() const;
+    void keyword_mismatch();
     bool is(const char *, ...);
     bool isall(const char *, ...);
 
+    // Specialized equivalents of common formats; they fall back to the
+    // general formats for unusual input.
+    bool is_char_metric(int &c, double &wx, PermString &n,
+                        double &bllx, double &blly, double &burx, double &bury);
+    bool isall_kern(const char *format, PermString &left, PermString &right,
+                    double &kx);
+
     inline bool next_line();
     void save_line()                    { _slurper.save_line(); }
     void skip_until(unsigned char);
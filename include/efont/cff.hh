@@ -108,6 +108,29 @@ class Cff { public:
 
     };
 
+    // Allocates Type 2 charstrings that view the CFF data directly. Blocks
+    // double in size, so touching every glyph of a large font costs a
+    // handful of allocations instead of one per glyph.
+    class CharstringArena { public:
+
+        CharstringArena()       : _used(0) { }
+        ~CharstringArena();
+
+        Type2Charstring *make(const uint8_t *data, int len);
+
+      private:
+
+        Vector<Type2Charstring *> _blocks;
+        int _used;              // charstrings constructed in last block
+
+        enum { MIN_BLOCK = 64, MAX_BLOCK = 8192 };
+        static inline int block_size(int i);
+
+        CharstringArena(const CharstringArena &);
+        CharstringArena &operator=(const CharstringArena &);
+
+    };
+
   private:
 
     String _data_string;
@@ -126,6 +149,7 @@ class Cff { public:
 
     IndexIterator _gsubrs_index;
     Vector<Charstring *> _gsubrs_cs;
+    CharstringArena _gsubrs_arena;
 
     unsigned _units_per_em;
 
@@ -239,6 +263,8 @@ class Cff::FontParent : public CharstringProgram { public:
     int _charstring_type;
     int _error;
 
+    mutable CharstringArena _arena; // for Type 2 glyphs and subrs
+
     FontParent(const FontParent &);
     FontParent &operator=(const FontParent &);
 
@@ -333,8 +359,6 @@ class Cff::ChildFont : public Cff::FontParent { public:
     ChildFont(const ChildFont &); // does not exist
     ChildFont &operator=(const ChildFont &); // does not exist
 
-    Charstring *charstring(const IndexIterator &, int) const;
-
     friend class Cff::Font;
 
 };
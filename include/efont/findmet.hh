@@ -4,6 +4,7 @@
 #include <lcdf/hashmap.hh>
 #include <lcdf/vector.hh>
 #include <lcdf/permstr.hh>
+#include <lcdf/string.hh>
 class Filename;
 class ErrorHandler;
 namespace Efont {
@@ -30,6 +31,8 @@ class MetricsFinder { public:
     virtual void record(Metrics *, PermString);
     virtual void record(AmfmMetrics *);
 
+    static void set_compiled_metrics(bool, const String &directory = String());
+
   private:
 
     MetricsFinder *_next;
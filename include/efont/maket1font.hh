@@ -0,0 +1,12 @@
+// -*- related-file-name: "../../libefont/maket1font.cc" -*-
+#ifndef EFONT_MAKET1FONT_HH
+#define EFONT_MAKET1FONT_HH
+#include <efont/cff.hh>
+namespace Efont {
+class Type1Font;
+
+Type1Font *create_type1_font(const Cff::Font *, ErrorHandler *, int nprocs = 1,
+                             bool find_subrs = false);
+
+}
+#endif
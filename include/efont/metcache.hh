@@ -0,0 +1,19 @@
+// -*- related-file-name: "../../libefont/metcache.cc" -*-
+#ifndef EFONT_METCACHE_HH
+#define EFONT_METCACHE_HH
+#include <lcdf/string.hh>
+class Filename;
+namespace Efont {
+class Metrics;
+
+class MetricsCache { public:
+
+    static String cache_filename(const Filename &source, const String &directory);
+
+    static Metrics *read(const String &filename, const Filename &source);
+    static bool write(const Metrics *, const String &filename, const Filename &source);
+
+};
+
+}
+#endif
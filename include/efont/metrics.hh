@@ -115,6 +115,8 @@ class Metrics { public:
 
     unsigned _uses;
 
+    friend class MetricsCache;
+
 };
 
 
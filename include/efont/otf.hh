@@ -48,7 +48,7 @@ inline hashcode_t hashcode(const Tag& t) {
 
 class Font {
   public:
-    Font(const String& str, ErrorHandler* errh = 0);
+    Font(const String& str, ErrorHandler* errh = 0, int face = 0);
     // default destructor
 
     bool ok() const                     { return _error >= 0; }
@@ -59,6 +59,10 @@ class Font {
     const uint8_t* data() const         { return _str.udata(); }
     int length() const                  { return _str.length(); }
 
+    int face() const                    { return _face; }
+    static bool is_collection(const String& str);
+    static int nfaces(const String& str);
+
     unsigned units_per_em() const       { return _units_per_em; }
 
     int ntables() const;
@@ -71,14 +75,24 @@ class Font {
     static uint32_t checksum(const String &);
     static Font make(bool truetype, const Vector<Tag>& tags, const Vector<String>& data);
 
-    enum { HEADER_SIZE = 12, TABLE_DIR_ENTRY_SIZE = 16 };
+    enum { HEADER_SIZE = 12, TABLE_DIR_ENTRY_SIZE = 16,
+           COLLECTION_HEADER_SIZE = 12 };
 
   private:
     String _str;
     int _error;
+    int _face;
+    uint32_t _offset;
     unsigned _units_per_em;
 
+    // table directory index, sorted by tag
+    Vector<uint32_t> _tags;
+    Vector<uint32_t> _checksums;
+    Vector<String> _tables;
+
     int parse_header(ErrorHandler*);
+    const uint8_t* directory() const    { return data() + _offset; }
+    inline int table_index(Tag tag) const;
 };
 
 class ScriptList {
@@ -144,14 +158,14 @@ class Coverage {
   public:
     Coverage() throw ();                // empty coverage
     Coverage(Glyph first, Glyph last) throw (); // range coverage
-    Coverage(const Vector<bool> &gmap) throw (); // used-bytemap coverage
+    Coverage(const Vector<bool> &gmap) throw (); // used-bitset coverage
     Coverage(const String &str, ErrorHandler *errh = 0, bool check = true) throw ();
     // default destructor
 
     bool ok() const throw ()            { return _str.length() > 0; }
     int size() const throw ();
     bool has_fast_covers() const throw () {
-        return _str.length() > 0 && _str.data()[1] == T_X_BYTEMAP;
+        return _str.length() > 0 && _str.data()[1] == T_X_BITSET;
     }
 
     int coverage_index(Glyph) const throw ();
@@ -190,19 +204,33 @@ class Coverage {
         Glyph _value;
         friend class Coverage;
         iterator(const String &str, bool is_end);
+        void bitset_scan(uint64_t bits);
     };
 
     iterator begin() const              { return iterator(_str, false); }
     iterator end() const                { return iterator(_str, true); }
     Glyph operator[](int) const throw ();
 
-    enum { T_LIST = 1, T_RANGES = 2, T_X_BYTEMAP = 3,
-           HEADERSIZE = 4, LIST_RECSIZE = 2, RANGES_RECSIZE = 6 };
+    enum { T_LIST = 1, T_RANGES = 2, T_X_BITSET = 3,
+           HEADERSIZE = 4, LIST_RECSIZE = 2, RANGES_RECSIZE = 6,
+           BITSET_HEADERSIZE = 8 };
 
   private:
     String _str;
 
     int check(ErrorHandler*);
+
+    // T_X_BITSET coverages are private: a header with the word count and
+    // glyph count, then a popcount prefix (rank) per word, then the
+    // 64-bit words themselves
+    uint64_t *make_bitset(int nwords);
+    void finish_bitset();
+    static inline int bitset_nwords(const uint8_t *data);
+    static inline int bitset_words_offset(int nwords);
+
+    friend Coverage operator&(const Coverage&, const Coverage&);
+    friend bool operator<=(const Coverage&, const Coverage&);
+    friend class GlyphSet;
 };
 
 Coverage operator&(const Coverage&, const Coverage&);
@@ -216,24 +244,59 @@ class GlyphSet {
   public:
     GlyphSet();
     GlyphSet(const GlyphSet&);
+    explicit GlyphSet(const Coverage&);
     ~GlyphSet();
 
+    bool empty() const;
+    int size() const;
+
     inline bool covers(Glyph g) const;
     inline bool operator[](Glyph g) const;
+    bool covers(const Coverage&) const;
     int change(Glyph, bool);
     void insert(Glyph g)                { change(g, true); }
     void remove(Glyph g)                { change(g, false); }
+    void clear();
 
     GlyphSet& operator=(const GlyphSet&);
+    GlyphSet& operator|=(const GlyphSet&);
+    GlyphSet& operator&=(const GlyphSet&);
+    GlyphSet& operator-=(const GlyphSet&);
+    bool operator<=(const GlyphSet&) const;
+
+    Glyph next(Glyph g) const;          // least member >= g, or -1
+    Coverage coverage() const;
+
+    class iterator { public:
+        // private constructor
+        // default destructor
+        bool ok() const                 { return _value >= 0; }
+        operator bool() const           { return ok(); }
+        Glyph operator*() const         { return _value; }
+        Glyph value() const             { return _value; }
+        void operator++(int)            { _value = _gs->next(_value + 1); }
+        void operator++()               { (*this)++; }
+      private:
+        const GlyphSet *_gs;
+        Glyph _value;
+        friend class GlyphSet;
+        iterator(const GlyphSet *gs, Glyph g) : _gs(gs), _value(g) { }
+    };
+
+    iterator begin() const              { return iterator(this, next(0)); }
 
   private:
+    // a two-level bitmap: VLEN pages of PAGEWORDS 64-bit words, allocated
+    // on first insert
     enum { GLYPHBITS = 16, SHIFT = 8,
            MAXGLYPH = (1 << GLYPHBITS) - 1, UNSHIFT = GLYPHBITS - SHIFT,
            MASK = (1 << UNSHIFT) - 1, VLEN = (1 << SHIFT),
-           VULEN = (1 << UNSHIFT) >> 5
+           PAGEWORDS = (1 << UNSHIFT) >> 6
     };
 
-    uint32_t* _v[VLEN];
+    uint64_t* _v[VLEN];
+
+    uint64_t *page(int i);
 };
 
 class ClassDef {
@@ -355,8 +418,8 @@ inline void FeatureList::filter(Vector<int>& fids, Tag ftag) const {
 inline bool GlyphSet::covers(Glyph g) const {
     if ((unsigned)g > MAXGLYPH)
         return false;
-    else if (const uint32_t* u = _v[g >> SHIFT])
-        return (u[(g & MASK) >> 5] & (1 << (g & 0x1F))) != 0;
+    else if (const uint64_t* u = _v[g >> SHIFT])
+        return (u[(g & MASK) >> 6] & ((uint64_t) 1 << (g & 0x3F))) != 0;
     else
         return false;
 }
@@ -16,7 +16,7 @@ class Cmap { public:
 
     inline Glyph map_uni(uint32_t c) const;
     int map_uni(const Vector<uint32_t> &in, Vector<Glyph> &out) const;
-    inline void unmap_all(Vector<std::pair<uint32_t, Glyph> > &ugp) const;
+    void unmap_all(Vector<std::pair<uint32_t, Glyph> > &ugp) const;
 
   private:
 
@@ -26,6 +26,19 @@ class Cmap { public:
     mutable int _first_unicode_table;
     mutable Vector<int> _table_error;
 
+    // Flat index of the first Unicode table, built on first use: a
+    // two-level page table for the BMP, whose entries are glyphs or -1
+    // for unmapped code points, and sorted ranges above the BMP.
+    enum { I_UNBUILT = 0, I_OK = 1, I_NONE = 2,
+           PAGE_SHIFT = 8, PAGE_SIZE = 1 << PAGE_SHIFT,
+           NPAGES = 0x10000 >> PAGE_SHIFT };
+    mutable int _index_state;
+    mutable Vector<int> _bmp_page;
+    mutable Vector<Glyph> _bmp_glyph;
+    mutable Vector<uint32_t> _range_first;
+    mutable Vector<uint32_t> _range_last;
+    mutable Vector<Glyph> _range_glyph;
+
     enum { HEADER_SIZE = 4, ENCODING_SIZE = 8,
            HIBYTE_SUBHEADERS = 524 };
     enum Format { F_BYTE = 0, F_HIBYTE = 2, F_SEGMENTED = 4, F_TRIMMED = 6,
@@ -40,15 +53,28 @@ class Cmap { public:
     void dump_table(int t, Vector<std::pair<uint32_t, Glyph> > &ugp, ErrorHandler * = 0) const;
     inline const uint8_t* table_data(int t) const;
 
+    void build_index(ErrorHandler *) const;
+    void index_set(uint32_t u, Glyph g) const;
+    inline Glyph index_lookup(uint32_t u) const;
+    Glyph index_lookup_range(uint32_t u) const;
+
 };
 
 
-inline Glyph Cmap::map_uni(uint32_t c) const {
-    return map_table(USE_FIRST_UNICODE_TABLE, c, ErrorHandler::default_handler());
+inline Glyph Cmap::index_lookup(uint32_t u) const {
+    if (u < 0x10000) {
+        Glyph g = _bmp_glyph[_bmp_page[u >> PAGE_SHIFT] + (u & (PAGE_SIZE - 1))];
+        return g < 0 ? 0 : g;
+    } else
+        return index_lookup_range(u);
 }
 
-inline void Cmap::unmap_all(Vector<std::pair<uint32_t, Glyph> > &ugp) const {
-    dump_table(USE_FIRST_UNICODE_TABLE, ugp, ErrorHandler::default_handler());
+inline Glyph Cmap::map_uni(uint32_t c) const {
+    if (_index_state == I_UNBUILT)
+        build_index(ErrorHandler::default_handler());
+    if (_index_state == I_OK)
+        return index_lookup(c);
+    return map_table(USE_FIRST_UNICODE_TABLE, c, ErrorHandler::default_handler());
 }
 
 inline const uint8_t* Cmap::table_data(int t) const {
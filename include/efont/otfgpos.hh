@@ -5,6 +5,7 @@
 #include <efont/otfdata.hh>
 namespace Efont { namespace OpenType {
 class GposLookup;
+class GposPairMatrix;
 class Positioning;
 
 class Gpos { public:
@@ -33,6 +34,7 @@ class GposLookup { public:
     int type() const                    { return _type; }
     uint16_t flags() const              { return _d.u16(2); }
     bool unparse_automatics(Vector<Positioning> &, ErrorHandler * = 0) const;
+    bool unparse_automatics(Vector<Positioning> &, const Coverage &limit, ErrorHandler * = 0) const;
     enum {
         HEADERSIZE = 6, RECSIZE = 2,
         L_SINGLE = 1, L_PAIR = 2, L_CURSIVE = 3, L_MARKTOBASE = 4,
@@ -43,6 +45,7 @@ class GposLookup { public:
     Data _d;
     int _type;
     Data subtable(int i) const;
+    bool unparse_automatics(Vector<Positioning> &, const Coverage *limit, ErrorHandler *) const;
 };
 
 class GposValue { public:
@@ -70,6 +73,7 @@ class GposSingle { public:
     // default destructor
     Coverage coverage() const throw ();
     void unparse(Vector<Positioning> &) const;
+    void unparse(Vector<Positioning> &, const Coverage &limit) const;
     enum { F2_HEADERSIZE = 8 };
   private:
     Data _d;
@@ -79,12 +83,15 @@ class GposPair { public:
     GposPair(const Data &) throw (Error);
     // default destructor
     Coverage coverage() const throw ();
+    bool class_matrix(GposPairMatrix &) const;
     void unparse(Vector<Positioning> &) const;
+    void unparse(Vector<Positioning> &, const Coverage &limit) const;
     enum { F1_HEADERSIZE = 10, F1_RECSIZE = 2,
            PAIRSET_HEADERSIZE = 2, PAIRVALUE_HEADERSIZE = 2,
            F2_HEADERSIZE = 16 };
   private:
     Data _d;
+    void unparse_classes(Vector<Positioning> &, const Coverage *limit) const;
 };
 
 struct Position {
@@ -133,6 +140,10 @@ class Positioning { public:
     void unparse(StringAccum &, const Vector<PermString> * = 0) const;
     String unparse(const Vector<PermString> * = 0) const;
 
+    // compact binary form, for caches
+    void serialize(StringAccum &) const;
+    bool deserialize(const uint8_t *&s, const uint8_t *end);
+
   private:
 
     Position _left;
@@ -140,6 +151,41 @@ class Positioning { public:
 
 };
 
+/* A format 2 (class-based) pair positioning subtable, viewed as a matrix:
+   left glyphs map to rows via the coverage and first ClassDef, right
+   glyphs map to columns via the second ClassDef, and each cell holds the
+   adjustments for that class pair. Unlike GposPair::unparse(), which
+   expands every nonempty cell into one Positioning per glyph pair, this
+   can be queried pair by pair or expanded over a limited glyph set. */
+class GposPairMatrix { public:
+
+    inline GposPairMatrix();
+    // default destructor
+
+    bool ok() const                     { return _nclass1 > 0 && _nclass2 > 0; }
+    int nclass1() const                 { return _nclass1; }
+    int nclass2() const                 { return _nclass2; }
+
+    inline int left_class(Glyph) const throw ();
+    inline int right_class(Glyph) const throw ();
+    const Position &left_value(int c1, int c2) const { return _values[2 * (c1 * _nclass2 + c2)]; }
+    const Position &right_value(int c1, int c2) const { return _values[2 * (c1 * _nclass2 + c2) + 1]; }
+
+    void unparse(Vector<Positioning> &, const Coverage &limit) const;
+
+  private:
+
+    Coverage _coverage;
+    ClassDef _class1;
+    ClassDef _class2;
+    int _nclass1;
+    int _nclass2;
+    Vector<Position> _values;   // left, right for each cell, row-major
+
+    friend class GposPair;
+
+};
+
 inline int GposValue::size(uint16_t format)
 {
     return (nibble_bitcount_x2[format & 15] + nibble_bitcount_x2[(format>>4) & 15]);
@@ -206,6 +252,25 @@ inline Position::Position(Glyph g_, int pdx_, int pdy_, int adx_, int ady_)
 {
 }
 
+inline GposPairMatrix::GposPairMatrix()
+    : _class1(String()), _class2(String()), _nclass1(0), _nclass2(0)
+{
+}
+
+inline int GposPairMatrix::left_class(Glyph g) const throw ()
+{
+    if (!_coverage.covers(g))
+        return -1;
+    int c = _class1.lookup(g);
+    return (c < _nclass1 ? c : -1);
+}
+
+inline int GposPairMatrix::right_class(Glyph g) const throw ()
+{
+    int c = _class2.lookup(g);
+    return (c < _nclass2 ? c : -1);
+}
+
 inline Positioning::Positioning(const Position &left)
     : _left(left)
 {
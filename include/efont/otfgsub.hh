@@ -34,7 +34,7 @@ class GsubLookup { public:
     GsubLookup(const Data &) throw (Error);
     int type() const                    { return _type; }
     uint16_t flags() const              { return _d.u16(2); }
-    void mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const;
+    void mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const;
     bool unparse_automatics(const Gsub &gsub, Vector<Substitution> &subs, const Coverage &limit) const;
     bool apply(const Glyph *, int pos, int n, Substitution &) const;
     enum {
@@ -53,7 +53,7 @@ class GsubSingle { public:
     // default destructor
     Coverage coverage() const throw ();
     Glyph map(Glyph) const;
-    void mark_out_glyphs(Vector<bool> &gmap) const;
+    void mark_out_glyphs(GlyphSet &gmap) const;
     void unparse(Vector<Substitution> &subs, const Coverage &limit) const;
     bool apply(const Glyph *, int pos, int n, Substitution &) const;
     enum { HEADERSIZE = 6, FORMAT2_RECSIZE = 2 };
@@ -66,8 +66,8 @@ class GsubMultiple { public:
     // default destructor
     Coverage coverage() const throw ();
     bool map(Glyph, Vector<Glyph> &) const;
-    void mark_out_glyphs(Vector<bool> &gmap) const;
-    void unparse(Vector<Substitution> &, bool alternate = false) const;
+    void mark_out_glyphs(GlyphSet &gmap) const;
+    void unparse(Vector<Substitution> &, const Coverage &limit, bool alternate = false) const;
     bool apply(const Glyph *, int pos, int n, Substitution &, bool alternate = false) const;
     enum { HEADERSIZE = 6, RECSIZE = 2,
            SEQ_HEADERSIZE = 2, SEQ_RECSIZE = 2 };
@@ -80,8 +80,8 @@ class GsubLigature { public:
     // default destructor
     Coverage coverage() const throw ();
     bool map(const Vector<Glyph> &, Glyph &, int &) const;
-    void mark_out_glyphs(Vector<bool> &gmap) const;
-    void unparse(Vector<Substitution> &) const;
+    void mark_out_glyphs(GlyphSet &gmap) const;
+    void unparse(Vector<Substitution> &, const Coverage &limit) const;
     bool apply(const Glyph *, int pos, int n, Substitution &) const;
     enum { HEADERSIZE = 6, RECSIZE = 2,
            SET_HEADERSIZE = 2, SET_RECSIZE = 2,
@@ -94,12 +94,12 @@ class GsubContext { public:
     GsubContext(const Data &) throw (Error);
     // default destructor
     Coverage coverage() const throw ();
-    void mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const;
+    void mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const;
     bool unparse(const Gsub &gsub, Vector<Substitution> &out_subs, const Coverage &limit) const;
     enum { F3_HSIZE = 6, SUBRECSIZE = 4 };
   private:
     Data _d;
-    static void subruleset_mark_out_glyphs(const Data &data, int nsub, int subtab_offset, const Gsub &gsub, Vector<bool> &gmap);
+    static void subruleset_mark_out_glyphs(const Data &data, int nsub, int subtab_offset, const Gsub &gsub, GlyphSet &gmap);
     static bool f1_unparse(const Data& data,
                            int nsub, int subtab_offset,
                            const Gsub& gsub, Vector<Substitution>& outsubs,
@@ -116,7 +116,7 @@ class GsubChainContext { public:
     GsubChainContext(const Data &) throw (Error);
     // default destructor
     Coverage coverage() const throw ();
-    void mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const;
+    void mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const;
     bool unparse(const Gsub &gsub, Vector<Substitution> &subs, const Coverage &limit) const;
     enum { F1_HEADERSIZE = 6, F1_RECSIZE = 2,
            F1_SRS_HSIZE = 2, F1_SRS_RSIZE = 2,
@@ -206,6 +206,10 @@ class Substitution { public:
     void unparse(StringAccum &, const Vector<PermString> * = &debug_glyph_names) const;
     String unparse(const Vector<PermString> * = &debug_glyph_names) const;
 
+    // compact binary form, for caches
+    void serialize(StringAccum &) const;
+    bool deserialize(const uint8_t *&s, const uint8_t *end);
+
   private:
 
     enum { T_NONE = 0, T_GLYPH, T_GLYPHS, T_COVERAGE };
@@ -246,6 +250,8 @@ class Substitution { public:
     static bool matches(const Substitute &, uint8_t, int pos, Glyph) throw ();
 
     static void unparse_glyphids(StringAccum &, const Substitute &, uint8_t, const Vector<PermString> *) throw ();
+    static void serialize(StringAccum &, const Substitute &, uint8_t);
+    static bool deserialize(const uint8_t *&, const uint8_t *, Substitute &, uint8_t &);
 
 };
 
@@ -54,12 +54,14 @@ class PairOp { public:
 
     PairOpIndex _next_left;
 
+    friend class MetricsCache;
+
 };
 
 
 class PairProgram { public:
 
-    PairProgram()                               : _reversed(false) { }
+    PairProgram()                               : _reversed(false), _pair_count(0) { }
     PairProgram(const PairProgram &);
 
     void reserve_glyphs(int);
@@ -86,10 +88,22 @@ class PairProgram { public:
     Vector<PairOpIndex> _left_map;
     Vector<PairOp> _op;
 
+    // Open-addressed table of op indices, hashed on (left, right); built on
+    // the first find() and empty when not built.  Each pair maps to the op
+    // that heads its left list, as the list walk would find it.
+    mutable Vector<PairOpIndex> _pair_table;
+    mutable int _pair_count;
+
+    static inline unsigned pair_hash(GlyphIndex, GlyphIndex);
+    void build_pair_table() const;
+    void insert_pair(PairOpIndex, bool replace) const;
+
     inline const char *print_name(GlyphIndex) const;
 
     PairProgram &operator=(const PairProgram &) { assert(0); return *this; }
 
+    friend class MetricsCache;
+
 };
 
 
@@ -1,11 +1,11 @@
 // -*- related-file-name: "../../libefont/t1bounds.cc" -*-
 #ifndef EFONT_T1BOUNDS_HH
 #define EFONT_T1BOUNDS_HH
-#include <efont/t1interp.hh>
+#include <efont/t2interp.hh>
 #include <lcdf/transform.hh>
 namespace Efont {
 
-class CharstringBounds : public CharstringInterp { public:
+class CharstringBounds : public Type2Interp<CharstringBounds> { public:
 
     CharstringBounds();
     CharstringBounds(const Transform&);
@@ -25,6 +25,9 @@ class CharstringBounds : public CharstringInterp { public:
     void act_width(int, const Point&);
     void act_line(int, const Point&, const Point&);
     void act_curve(int, const Point&, const Point&, const Point&, const Point&);
+    void act_hstem(int, double, double)         { }
+    void act_vstem(int, double, double)         { }
+    void act_hintmask(int, const uint8_t*, int) { }
     inline void mark(const Point&);
 
     void clear();
@@ -43,6 +46,7 @@ class CharstringBounds : public CharstringInterp { public:
     Point _lb;
     Point _rt;
     Point _width;
+    Point _last;                // last endpoint marked, untransformed
     Transform _xf;
     Transform _nonfont_xf;
     const CharstringProgram* _last_xf_program;
@@ -50,13 +54,52 @@ class CharstringBounds : public CharstringInterp { public:
     void set_xf(const CharstringProgram*);
 
     inline void xf_mark(const Point&);
-    void xf_mark(const Bezier&);
+    void xf_mark_extrema(const Point&, const Point&, const Point&, const Point&);
 
     inline bool xf_inside(const Point&) const;
-    inline bool xf_controls_inside(const Bezier&) const;
 
 };
 
+class GlyphBoundsTable { public:
+
+    GlyphBoundsTable(const CharstringProgram *program,
+                     const Transform &nonfont_xf = Transform());
+
+    const CharstringProgram *program() const    { return _program; }
+    const Transform &transform() const          { return _nonfont_xf; }
+    int nglyphs() const                         { return _state.size(); }
+
+    inline bool known(int g) const;
+    bool get(int g, double bounds[4], double &width);
+    void set(int g, const double bounds[4], double width, bool ok);
+
+    void compute(const Vector<int> &glyphs, int nprocs = 1);
+    void compute_all(int nprocs = 1);
+
+  private:
+
+    enum { s_unknown = 0, s_ok = 1, s_error = 2 };
+
+    const CharstringProgram *_program;
+    Transform _nonfont_xf;
+
+    Vector<uint8_t> _state;
+    Vector<double> _xmin;
+    Vector<double> _ymin;
+    Vector<double> _xmax;
+    Vector<double> _ymax;
+    Vector<double> _width;
+
+    void compute_one(int g);
+    bool compute_parallel(const Vector<int> &glyphs, int nprocs);
+
+};
+
+inline bool GlyphBoundsTable::known(int g) const
+{
+    return g >= 0 && g < _state.size() && _state[g] != s_unknown;
+}
+
 inline void CharstringBounds::xf_mark(const Point& p)
 {
     if (!KNOWN(_lb.x))
@@ -81,11 +124,6 @@ inline bool CharstringBounds::xf_inside(const Point& p) const
     return p.x >= _lb.x && p.x <= _rt.x && p.y >= _lb.y && p.y <= _rt.y;
 }
 
-inline bool CharstringBounds::xf_controls_inside(const Bezier& b) const
-{
-    return xf_inside(b.point(1)) && xf_inside(b.point(2));
-}
-
 inline Point CharstringBounds::transform(const Point& p) const
 {
     return p * _xf;
@@ -164,20 +164,23 @@ class Type1Charstring : public Charstring { public:
 
 class Type2Charstring : public Charstring { public:
 
-    Type2Charstring()                           { }
+    Type2Charstring()                           : _data(0), _len(0) { }
     inline Type2Charstring(const String &);
+    inline Type2Charstring(const uint8_t *data, int len); // not owned
     // default copy constructor
     // default destructor
     // default assignment operator
 
-    inline const uint8_t *data() const;
-    int length() const                          { return _s.length(); }
+    const uint8_t *data() const                 { return _data; }
+    int length() const                          { return _len; }
 
     bool process(CharstringInterp &) const;
 
   private:
 
-    String _s;
+    String _s;                  // empty for non-owning charstrings
+    const uint8_t *_data;
+    int _len;
 
 };
 
@@ -296,13 +299,13 @@ inline bool operator==(const Type1Charstring &a, const Type1Charstring &b)
 
 
 inline Type2Charstring::Type2Charstring(const String &s)
-    : _s(s)
+    : _s(s), _data(s.udata()), _len(s.length())
 {
 }
 
-inline const uint8_t *Type2Charstring::data() const
+inline Type2Charstring::Type2Charstring(const uint8_t *data, int len)
+    : _data(data), _len(len)
 {
-    return reinterpret_cast<const uint8_t *>(_s.data());
 }
 
 
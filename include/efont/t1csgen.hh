@@ -63,6 +63,9 @@ class Type1CharstringGenInterp : public CharstringInterp { public:
     bool had_bad_flex() const           { return _had_bad_flex; }
     bool had_hr() const                 { return _had_hr; }
 
+    const String &last_hints() const    { return _last_hints; }
+    void set_last_hints(const String &s) { _last_hints = s; }
+
     const Type1CharstringGen &csgen() const     { return _csgen; }
 
     void act_width(int, const Point &);
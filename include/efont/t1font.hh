@@ -40,6 +40,7 @@ class Type1Font : public CharstringProgram { public:
     PermString glyph_name(int) const;
     Type1Charstring *glyph(int) const;
     Type1Charstring *glyph(PermString) const;
+    int glyphid(PermString name) const  { return _glyph_map[name]; }
     void add_glyph(Type1Subr *);
 
     Type1Subr *subr_x(int i) const      { return _subrs[i]; }
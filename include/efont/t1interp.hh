@@ -121,6 +121,8 @@ class CharstringInterp { public:
 
   private:
 
+    template <typename D> friend class Type2Interp;
+
     int _error;
     int _error_data;
     bool _done;
@@ -42,6 +42,11 @@ class Type1Reader { public:
     bool _binary_eexec;
     int _r;
 
+    unsigned char *_edata;      // decrypted eexec data
+    int _elen;
+    int _epos;
+    int _eraw;                  // position in _data where _edata began
+
     Type1Reader(const Type1Reader &);
     Type1Reader &operator=(const Type1Reader &);
 
@@ -49,8 +54,11 @@ class Type1Reader { public:
 
     inline int eexec(int);
     int ascii_eexec_get();
+    int eexec_fill();
+    void eexec_rewind();
     inline int get_base();
     inline int get();
+    inline void append_run(StringAccum &);
 
     void start_eexec(int ascii_chars);
 
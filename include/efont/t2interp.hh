@@ -0,0 +1,519 @@
+#ifndef EFONT_T2INTERP_HH
+#define EFONT_T2INTERP_HH
+#include <efont/t1interp.hh>
+namespace Efont {
+
+// Type2Interp<D>: a Type 2 charstring interpreter specialized at compile
+// time for the action class D, which derives from Type2Interp<D>.
+//
+// CharstringInterp decodes each byte through Type2Charstring::process and
+// type2_command(), and reports every line and curve through a virtual
+// act_* call.  Type2Interp decodes the charstring itself, dispatching on
+// each byte through a jump table (computed goto with GCC-compatible
+// compilers, a switch otherwise), and executes hints, moveto, lineto,
+// curveto, callsubr and callgsubr inline, calling D::act_hstem,
+// D::act_line, D::act_curve, and so forth directly.  A D that ignores
+// hints can define those actions as empty inline functions.  Everything
+// else -- flex, arithmetic, endchar -- goes through D::type2_command, so
+// results match CharstringInterp exactly.
+//
+// Numbers are pushed directly; D::number is not consulted.  Classes
+// derived from D should not override the act_* methods D relies on,
+// since the fast path calls D's versions.
+
+#if defined(__GNUC__) && !defined(EFONT_T2INTERP_NO_COMPUTED_GOTO)
+# define EFONT_T2INTERP_COMPUTED_GOTO 1
+#endif
+
+template <typename D>
+class Type2Interp : public CharstringInterp { public:
+
+    Type2Interp()                               { }
+    Type2Interp(const Vector<double> &weight_vec) : CharstringInterp(weight_vec) { }
+
+    bool fast_interpret(const CharstringProgram *, const Charstring *);
+    inline bool fast_interpret(const CharstringContext &);
+
+  private:
+
+    inline D *derived()                         { return static_cast<D *>(this); }
+
+    bool fast_process(const Charstring *);
+    bool fast_process(const uint8_t *data, int left);
+    bool fast_callsubr(bool g);
+    bool fast_hint_command(int cmd, const uint8_t *data, int *left);
+    bool fast_path_command(int cmd);
+
+    inline void fast_rmoveto(int cmd, double dx, double dy);
+    inline void fast_rlineto(int cmd, double dx, double dy);
+    inline void fast_rrcurveto(int cmd, double dx1, double dy1, double dx2, double dy2, double dx3, double dy3);
+
+};
+
+
+template <typename D>
+bool Type2Interp<D>::fast_interpret(const CharstringProgram *program, const Charstring *cs)
+{
+    if (cs) {
+        initialize();
+        _program = program;
+        fast_process(cs);
+        return _error == errOK;
+    } else
+        return error(errGlyph, 0);
+}
+
+template <typename D>
+inline bool Type2Interp<D>::fast_interpret(const CharstringContext &g)
+{
+    return fast_interpret(g.program, g.cs);
+}
+
+template <typename D>
+bool Type2Interp<D>::fast_process(const Charstring *cs)
+{
+    if (const Type2Charstring *t2cs = dynamic_cast<const Type2Charstring *>(cs))
+        return fast_process(t2cs->data(), t2cs->length());
+    else
+        return cs->process(*this);
+}
+
+template <typename D>
+inline void Type2Interp<D>::fast_rmoveto(int cmd, double dx, double dy)
+{
+    if (_state == S_PATH)
+        derived()->D::act_closepath(cmd);
+    _state = S_IPATH;
+    _cp.shift(dx, dy);
+}
+
+template <typename D>
+inline void Type2Interp<D>::fast_rlineto(int cmd, double dx, double dy)
+{
+    Point p0(_cp);
+    _cp.shift(dx, dy);
+    derived()->D::act_line(cmd, p0, _cp);
+}
+
+template <typename D>
+inline void Type2Interp<D>::fast_rrcurveto(int cmd, double dx1, double dy1, double dx2, double dy2, double dx3, double dy3)
+{
+    Point p0(_cp);
+    Point p1(p0, dx1, dy1);
+    Point p2(p1, dx2, dy2);
+    _cp = p2.shifted(dx3, dy3);
+    derived()->D::act_curve(cmd, p0, p1, p2, _cp);
+}
+
+template <typename D>
+bool Type2Interp<D>::fast_callsubr(bool g)
+{
+    const int cmd = (g ? Cs::cCallgsubr : Cs::cCallsubr);
+    if (size() < 1)
+        return error(errUnderflow, cmd);
+    int which = (int) pop();
+
+    Charstring *subr_cs = get_xsubr(g, which);
+    if (!subr_cs)
+        return error(errSubr, which);
+
+    if (_subr_depth >= MAX_SUBR_DEPTH)
+        return error(errSubrDepth, which);
+    _subr_depth++;
+
+    fast_process(subr_cs);
+
+    _subr_depth--;
+    if (_error != errOK)
+        return false;
+    return !done();
+}
+
+// The hint commands, following CharstringInterp::type2_command.
+template <typename D>
+bool Type2Interp<D>::fast_hint_command(int cmd, const uint8_t *data, int *left)
+{
+    int bottom = 0;
+    int n = size();
+
+    switch (cmd) {
+
+      case Cs::cHstem:
+      case Cs::cHstemhm:
+      case Cs::cVstem:
+      case Cs::cVstemhm: {
+          if (n < 2)
+              return error(errUnderflow, cmd);
+          if (_state <= S_SEAC)
+              bottom = type2_handle_width(cmd, (n % 2) == 1);
+          bool h = (cmd == Cs::cHstem || cmd == Cs::cHstemhm);
+          State s = (h ? S_HSTEM : S_VSTEM);
+          if (_state > s)
+              return error(errOrdering, cmd);
+          _state = s;
+          for (double pos = 0; bottom + 1 < n; bottom += 2) {
+              _t2nhints++;
+              if (h)
+                  derived()->D::act_hstem(cmd, pos + at(bottom), at(bottom + 1));
+              else
+                  derived()->D::act_vstem(cmd, pos + at(bottom), at(bottom + 1));
+              pos += at(bottom) + at(bottom + 1);
+          }
+          break;
+      }
+
+      default: // hintmask, cntrmask
+        if (_state <= S_SEAC && n >= 1) {
+            bottom = type2_handle_width(cmd, (n % 2) == 1);
+            for (double pos = 0; bottom + 1 < n; bottom += 2) {
+                _t2nhints++;
+                derived()->D::act_hstem(cmd, pos + at(bottom), at(bottom + 1));
+                pos += at(bottom) + at(bottom + 1);
+            }
+        }
+        if ((_state == S_HSTEM || _state == S_VSTEM) && n >= 2)
+            for (double pos = 0; bottom + 1 < n; bottom += 2) {
+                _t2nhints++;
+                derived()->D::act_vstem(cmd, pos + at(bottom), at(bottom + 1));
+                pos += at(bottom) + at(bottom + 1);
+            }
+        if (_state < S_HINTMASK)
+            _state = S_HINTMASK;
+        if (_t2nhints == 0)
+            return error(errHintmask, cmd);
+        if (((_t2nhints - 1) >> 3) + 1 > *left)
+            return error(errRunoff, cmd);
+        derived()->D::act_hintmask(cmd, data, _t2nhints);
+        *left -= ((_t2nhints - 1) >> 3) + 1;
+        break;
+
+    }
+
+    clear();
+    return error() >= 0;
+}
+
+// The path commands, following CharstringInterp::type2_command.
+template <typename D>
+bool Type2Interp<D>::fast_path_command(int cmd)
+{
+    int bottom = 0;
+    int n = size();
+
+    switch (cmd) {
+
+      case Cs::cRmoveto:
+        if (n < 2)
+            return error(errUnderflow, cmd);
+        if (_state <= S_SEAC)
+            bottom = type2_handle_width(cmd, n > 2);
+        fast_rmoveto(cmd, at(bottom), at(bottom + 1));
+        break;
+
+      case Cs::cHmoveto:
+        if (n < 1)
+            return error(errUnderflow, cmd);
+        if (_state <= S_SEAC)
+            bottom = type2_handle_width(cmd, n > 1);
+        fast_rmoveto(cmd, at(bottom), 0);
+        break;
+
+      case Cs::cVmoveto:
+        if (n < 1)
+            return error(errUnderflow, cmd);
+        if (_state <= S_SEAC)
+            bottom = type2_handle_width(cmd, n > 1);
+        fast_rmoveto(cmd, 0, at(bottom));
+        break;
+
+      case Cs::cRlineto:
+        if (n < 2)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        for (; bottom + 1 < n; bottom += 2)
+            fast_rlineto(cmd, at(bottom), at(bottom + 1));
+        break;
+
+      case Cs::cHlineto:
+      case Cs::cVlineto: {
+          if (n < 1)
+              return error(errUnderflow, cmd);
+          if (_state < S_IPATH)
+              return error(errOrdering, cmd);
+          _state = S_PATH;
+          bool horiz = (cmd == Cs::cHlineto);
+          for (; bottom < n; bottom++, horiz = !horiz)
+              if (horiz)
+                  fast_rlineto(cmd, at(bottom), 0);
+              else
+                  fast_rlineto(cmd, 0, at(bottom));
+          break;
+      }
+
+      case Cs::cRrcurveto:
+        if (n < 6)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        for (; bottom + 5 < n; bottom += 6)
+            fast_rrcurveto(cmd, at(bottom), at(bottom + 1), at(bottom + 2), at(bottom + 3), at(bottom + 4), at(bottom + 5));
+        break;
+
+      case Cs::cHhcurveto:
+        if (n < 4)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        if (n % 2 == 1) {
+            fast_rrcurveto(cmd, at(bottom + 1), at(bottom), at(bottom + 2), at(bottom + 3), at(bottom + 4), 0);
+            bottom += 5;
+        }
+        for (; bottom + 3 < n; bottom += 4)
+            fast_rrcurveto(cmd, at(bottom), 0, at(bottom + 1), at(bottom + 2), at(bottom + 3), 0);
+        break;
+
+      case Cs::cVvcurveto:
+        if (n < 4)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        if (n % 2 == 1) {
+            fast_rrcurveto(cmd, at(bottom), at(bottom + 1), at(bottom + 2), at(bottom + 3), 0, at(bottom + 4));
+            bottom += 5;
+        }
+        for (; bottom + 3 < n; bottom += 4)
+            fast_rrcurveto(cmd, 0, at(bottom), at(bottom + 1), at(bottom + 2), 0, at(bottom + 3));
+        break;
+
+      case Cs::cHvcurveto:
+      case Cs::cVhcurveto: {
+          if (n < 4)
+              return error(errUnderflow, cmd);
+          if (_state < S_IPATH)
+              return error(errOrdering, cmd);
+          _state = S_PATH;
+          bool horiz = (cmd == Cs::cHvcurveto);
+          for (; bottom + 3 < n; bottom += 4, horiz = !horiz) {
+              double d3 = (bottom + 5 == n ? at(bottom + 4) : 0);
+              if (horiz)
+                  fast_rrcurveto(cmd, at(bottom), 0, at(bottom + 1), at(bottom + 2), d3, at(bottom + 3));
+              else
+                  fast_rrcurveto(cmd, 0, at(bottom), at(bottom + 1), at(bottom + 2), at(bottom + 3), d3);
+          }
+          break;
+      }
+
+      case Cs::cRcurveline:
+        if (n < 8)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        for (; bottom + 7 < n; bottom += 6)
+            fast_rrcurveto(cmd, at(bottom), at(bottom + 1), at(bottom + 2), at(bottom + 3), at(bottom + 4), at(bottom + 5));
+        fast_rlineto(cmd, at(bottom), at(bottom + 1));
+        break;
+
+      case Cs::cRlinecurve:
+        if (n < 8)
+            return error(errUnderflow, cmd);
+        if (_state < S_IPATH)
+            return error(errOrdering, cmd);
+        _state = S_PATH;
+        for (; bottom + 7 < n; bottom += 2)
+            fast_rlineto(cmd, at(bottom), at(bottom + 1));
+        fast_rrcurveto(cmd, at(bottom), at(bottom + 1), at(bottom + 2), at(bottom + 3), at(bottom + 4), at(bottom + 5));
+        break;
+
+      default:
+        return derived()->D::type2_command(cmd, 0, 0);
+
+    }
+
+    clear();
+    return error() >= 0;
+}
+
+// The decoding loop, following Type2Charstring::process.
+template <typename D>
+bool Type2Interp<D>::fast_process(const uint8_t *data, int left)
+{
+    bool more;
+    int ahead;
+
+#if EFONT_T2INTERP_COMPUTED_GOTO
+# define T2_X4(l)       &&l, &&l, &&l, &&l
+# define T2_X16(l)      T2_X4(l), T2_X4(l), T2_X4(l), T2_X4(l)
+# define T2_X32(l)      T2_X16(l), T2_X16(l)
+    static const void * const dispatch[256] = {
+        &&op_other, &&op_hint, &&op_other, &&op_hint,   // 0-3
+        &&op_path, &&op_path, &&op_path, &&op_path,     // 4-7
+        &&op_path, &&op_other, &&op_callsubr, &&op_return, // 8-11
+        &&op_escape, &&op_other, &&op_other, &&op_other, // 12-15
+        &&op_other, &&op_other, &&op_hint, &&op_mask,   // 16-19
+        &&op_mask, &&op_path, &&op_path, &&op_hint,     // 20-23
+        &&op_path, &&op_path, &&op_path, &&op_path,     // 24-27
+        &&op_shortint, &&op_callgsubr, &&op_path, &&op_path, // 28-31
+        T2_X32(op_small), T2_X32(op_small), T2_X32(op_small), // 32-127
+        T2_X32(op_small), T2_X32(op_small), T2_X32(op_small), // 128-223
+        T2_X16(op_small), T2_X4(op_small), &&op_small, &&op_small, // 224-245
+        &&op_small,                                     // 246
+        T2_X4(op_medium), T2_X4(op_negmedium), &&op_huge // 247-255
+    };
+# undef T2_X4
+# undef T2_X16
+# undef T2_X32
+# define T2_DISPATCH()  goto *dispatch[*data]
+#else
+# define T2_DISPATCH()  goto dispatch_switch
+#endif
+
+  next:
+    if (left <= 0)
+        goto runoff_error;
+    T2_DISPATCH();
+
+#if !EFONT_T2INTERP_COMPUTED_GOTO
+  dispatch_switch:
+    switch (*data) {
+      case Cs::cHstem: case Cs::cVstem: case Cs::cHstemhm: case Cs::cVstemhm:
+        goto op_hint;
+      case Cs::cRmoveto: case Cs::cHmoveto: case Cs::cVmoveto:
+      case Cs::cRlineto: case Cs::cHlineto: case Cs::cVlineto:
+      case Cs::cRrcurveto: case Cs::cRcurveline: case Cs::cRlinecurve:
+      case Cs::cVvcurveto: case Cs::cHhcurveto:
+      case Cs::cVhcurveto: case Cs::cHvcurveto:
+        goto op_path;
+      case Cs::cCallsubr:
+        goto op_callsubr;
+      case Cs::cCallgsubr:
+        goto op_callgsubr;
+      case Cs::cReturn:
+        goto op_return;
+      case Cs::cEscape:
+        goto op_escape;
+      case Cs::cHintmask: case Cs::cCntrmask:
+        goto op_mask;
+      case Cs::cShortint:
+        goto op_shortint;
+      default:
+        if (*data < 32)
+            goto op_other;
+        else if (*data <= 246)
+            goto op_small;
+        else if (*data <= 250)
+            goto op_medium;
+        else if (*data <= 254)
+            goto op_negmedium;
+        else
+            goto op_huge;
+    }
+#endif
+#undef T2_DISPATCH
+
+  op_small:
+    // runs of small numbers are common; decode them without dispatching
+    do {
+        push(data[0] - 139);
+        data++;
+        left--;
+    } while (left > 0 && *data >= 32 && *data <= 246);
+    goto next;
+
+  op_medium:
+    if (left < 2)
+        goto runoff_error;
+    push(((data[0] - 247) << 8) + 108 + data[1]);
+    data += 2;
+    left -= 2;
+    goto next;
+
+  op_negmedium:
+    if (left < 2)
+        goto runoff_error;
+    push(-((data[0] - 251) << 8) - 108 - data[1]);
+    data += 2;
+    left -= 2;
+    goto next;
+
+  op_shortint: {
+        if (left < 3)
+            goto runoff_error;
+        int16_t val = (data[1] << 8) | data[2];
+        push(val);
+        data += 3;
+        left -= 3;
+        goto next;
+    }
+
+  op_huge: {
+        if (left < 5)
+            goto runoff_error;
+        int32_t val = (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+        push(val / 65536.);
+        data += 5;
+        left -= 5;
+        goto next;
+    }
+
+  op_hint:
+    more = fast_hint_command(data[0], 0, 0);
+    ahead = 1;
+    goto advance;
+
+  op_path:
+    more = fast_path_command(data[0]);
+    ahead = 1;
+    goto advance;
+
+  op_callsubr:
+    more = fast_callsubr(false);
+    ahead = 1;
+    goto advance;
+
+  op_callgsubr:
+    more = fast_callsubr(true);
+    ahead = 1;
+    goto advance;
+
+  op_return:
+    return _error == errOK;
+
+  op_escape:
+    if (left < 2)
+        goto runoff_error;
+    more = derived()->D::type2_command(Cs::cEscapeDelta + data[1], 0, 0);
+    ahead = 2;
+    goto advance;
+
+  op_mask: {
+        int left_ptr = left - 1;
+        more = fast_hint_command(data[0], data + 1, &left_ptr);
+        ahead = 1 + (left - 1) - left_ptr;
+        goto advance;
+    }
+
+  op_other:
+    more = derived()->D::type2_command(data[0], 0, 0);
+    ahead = 1;
+    goto advance;
+
+  advance:
+    if (!more)
+        return _error == errOK;
+    data += ahead;
+    left -= ahead;
+    goto next;
+
+  runoff_error:
+    error(errRunoff);
+    return false;
+}
+
+}
+#endif
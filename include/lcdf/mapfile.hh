@@ -0,0 +1,15 @@
+// -*- related-file-name: "../../liblcdf/mapfile.cc" -*-
+#ifndef LCDF_MAPFILE_HH
+#define LCDF_MAPFILE_HH
+#include <lcdf/string.hh>
+#include <stdio.h>
+
+String read_file_data(FILE *f, int *errp = 0);
+
+#if HAVE_UNISTD_H
+bool write_fd_data(int fd, const char *s, size_t len);
+size_t read_fd_data(int fd, char *s, size_t len);
+String read_fd_data(int fd);
+#endif
+
+#endif
@@ -148,6 +148,22 @@ class String { public:
     }
     static String make_fill(int c, int n); // n copies of c
 
+    /** @brief Return a String that directly references the first @a len
+     * characters of @a data, which is owned by some external allocator.
+     * @param data pointer to the character data
+     * @param len number of characters
+     * @param free_function function called to free @a data
+     * @param free_argument extra argument for @a free_function
+     *
+     * When the last String referencing @a data is destroyed, the String
+     * implementation calls @a free_function(@a data, @a len, @a
+     * free_argument).  The data is treated as immutable: mutable_data() and
+     * c_str() always make private copies.  This is useful for memory-mapped
+     * files. */
+    static String make_external(void *data, int len,
+				void (*free_function)(void *, int, void *),
+				void *free_argument);
+
 
     /** @brief Return the string's length. */
     inline int length() const {
@@ -254,12 +270,15 @@ class String { public:
      * pointer.  The returned pointer is semi-temporary; it will persist until
      * the string is destroyed or appended to. */
     inline const char *c_str() const {
-	// We may already have a '\0' in the right place.  If _memo has no
-	// capacity, then this is one of the special strings (null or
-	// stable). We are guaranteed, in these strings, that _data[_length]
-	// exists. Otherwise must check that _data[_length] exists.
+	// We may already have a '\0' in the right place.  If _memo is null,
+	// then this is one of the special strings (null or stable). We are
+	// guaranteed, in these strings, that _data[_length] exists. If _memo
+	// has no capacity, then this is an external string, and
+	// _data[_length] might not exist. Otherwise must check that
+	// _data[_length] exists.
 	const char *end_data = _r.data + _r.length;
-	if ((_r.memo && end_data >= _r.memo->real_data + _r.memo->dirty)
+	if ((_r.memo && (!_r.memo->capacity
+			 || end_data >= _r.memo->real_data + _r.memo->dirty))
 	    || *end_data != '\0') {
 	    if (char *x = const_cast<String *>(this)->append_uninitialized(1)) {
 		*x = '\0';
@@ -563,7 +582,7 @@ class String { public:
 
     /** @brief Return true iff the String's data is shared or immutable. */
     inline bool data_shared() const {
-	return !_r.memo || _r.memo->refcount != 1;
+	return !_r.memo || _r.memo->refcount != 1 || !_r.memo->capacity;
     }
 
     /** @brief Return a compact version of this String.
@@ -630,6 +649,15 @@ class String { public:
 	MEMO_SPACE = sizeof(memo_t) - 8
     };
 
+    // An external memo has capacity 0 and is never appended to in place.
+    struct external_memo_t {
+	memo_t memo;
+	void *data;
+	int length;
+	void (*free_function)(void *, int, void *);
+	void *free_argument;
+    };
+
     struct rep_t {
 	const char *data;
 	int length;
@@ -21,15 +21,94 @@
 #include <efont/t1cs.hh>        /* for UNKDOUBLE */
 #include <lcdf/error.hh>
 #include <ctype.h>
+#include <string.h>
 #include <assert.h>
 namespace Efont {
 
+// AFM keywords are dispatched through a hash table rather than by trying
+// each possible format in turn.
+
+enum {
+    kwNone = 0,
+    kwAscender, kwB, kwC, kwCapHeight, kwCC, kwCH, kwCharacters,
+    kwCharacterSet, kwCharWidth, kwComment, kwDescender, kwEncodingScheme,
+    kwEndCharMetrics, kwEndComposites, kwEndDirection, kwEndFontMetrics,
+    kwEndKernData, kwEndKernPairs, kwEndTrackKern, kwEscChar, kwFamilyName,
+    kwFontBBox, kwFontName, kwFullName, kwIsBaseFont, kwIsFixedPitch,
+    kwIsFixedV, kwItalicAngle, kwKP, kwKPH, kwKPX, kwKPY, kwL,
+    kwMappingScheme, kwMetricsSets, kwN, kwNotice, kwStartCharMetrics,
+    kwStartComposites, kwStartDirection, kwStartFontMetrics, kwStartKernData,
+    kwStartKernPairs, kwStartKernPairs0, kwStartKernPairs1, kwStartTrackKern,
+    kwStdHW, kwStdVW, kwTrackKern, kwUnderlinePosition, kwUnderlineThickness,
+    kwVersion, kwVVector, kwW, kwW0, kwW0X, kwW0Y, kwW1, kwW1X, kwW1Y,
+    kwWeight, kwWX, kwXHeight, nKeywords
+};
+
+static const char * const keyword_names[] = {
+    0,
+    "Ascender", "B", "C", "CapHeight", "CC", "CH", "Characters",
+    "CharacterSet", "CharWidth", "Comment", "Descender", "EncodingScheme",
+    "EndCharMetrics", "EndComposites", "EndDirection", "EndFontMetrics",
+    "EndKernData", "EndKernPairs", "EndTrackKern", "EscChar", "FamilyName",
+    "FontBBox", "FontName", "FullName", "IsBaseFont", "IsFixedPitch",
+    "IsFixedV", "ItalicAngle", "KP", "KPH", "KPX", "KPY", "L",
+    "MappingScheme", "MetricsSets", "N", "Notice", "StartCharMetrics",
+    "StartComposites", "StartDirection", "StartFontMetrics", "StartKernData",
+    "StartKernPairs", "StartKernPairs0", "StartKernPairs1", "StartTrackKern",
+    "StdHW", "StdVW", "TrackKern", "UnderlinePosition", "UnderlineThickness",
+    "Version", "VVector", "W", "W0", "W0X", "W0Y", "W1", "W1X", "W1Y",
+    "Weight", "WX", "XHeight"
+};
+
+enum { KEYWORD_TABSIZE = 256 };
+static unsigned char keyword_table[KEYWORD_TABSIZE];
+
+static inline unsigned
+keyword_hash(const unsigned char *s, int len)
+{
+    unsigned h = 2166136261U;
+    for (int i = 0; i < len; i++)
+        h = (h ^ s[i]) * 16777619U;
+    return h & (KEYWORD_TABSIZE - 1);
+}
+
+static void
+initialize_keyword_table()
+{
+    if (keyword_table[keyword_hash((const unsigned char *) "KPX", 3)])
+        return;
+    for (int k = 1; k < nKeywords; k++) {
+        const char *name = keyword_names[k];
+        unsigned h = keyword_hash((const unsigned char *) name, strlen(name));
+        while (keyword_table[h])
+            h = (h + 1) & (KEYWORD_TABSIZE - 1);
+        keyword_table[h] = k;
+    }
+}
+
+static int
+find_keyword(const AfmParser &l)
+{
+    const unsigned char *s = l.cur_line();
+    int len = l.keyword_length();
+    unsigned h = keyword_hash(s, len);
+    while (int k = keyword_table[h]) {
+        const char *name = keyword_names[k];
+        if (memcmp(name, s, len) == 0 && name[len] == 0)
+            return k;
+        h = (h + 1) & (KEYWORD_TABSIZE - 1);
+    }
+    return kwNone;
+}
+
+
 AfmReader::AfmReader(AfmParser &parser, Metrics *afm, AfmMetricsXt *afm_xt,
                      ErrorHandler *errh)
     : _afm(afm), _afm_xt(afm_xt), _l(parser),
       _composite_warned(false), _metrics_sets_warned(false), _y_width_warned(0)
 {
     _errh = errh ? errh : ErrorHandler::silent_handler();
+    initialize_keyword_table();
 }
 
 Metrics *
@@ -159,84 +238,126 @@ AfmReader::read()
     int direction;
 
     while (l.next_line())
-        switch (l.first()) {
+        switch (find_keyword(l)) {
 
-          case 'A':
+          case kwAscender:
             if (l.isall("Ascender %g", &fd( fdAscender )))
                 break;
             goto invalid;
 
-          case 'C':
+          case kwCharacters:
             if (l.isall("Characters %d", (int *)0))
                 break;
+            goto invalid;
+
+          case kwCapHeight:
             if (l.isall("CapHeight %g", &fd( fdCapHeight )))
                 break;
+            goto invalid;
+
+          case kwCharacterSet:
             if (l.isall("CharacterSet %+s", (PermString *) 0))
                 break;
+            goto invalid;
+
+          case kwCharWidth:
             if (l.isall("CharWidth %g %g", (double *)0, (double *)0))
                 break;
+            goto invalid;
+
+          case kwComment:
             if (l.isall("Comment %+s", (PermString *) 0))
                 break;
             goto invalid;
 
-          case 'D':
+          case kwDescender:
             if (l.isall("Descender %g", &fd( fdDescender )))
                 break;
             goto invalid;
 
-          case 'E':
+          case kwEncodingScheme:
             if (l.isall("EncodingScheme %+s", &_afm_xt->encoding_scheme))
                 break;
+            goto invalid;
+
+          case kwEndDirection:
             if (l.isall("EndDirection"))
                 break;
+            goto invalid;
+
+          case kwEndFontMetrics:
             if (l.isall("EndFontMetrics"))
                 goto done;
+            goto invalid;
+
+          case kwEscChar:
             if (l.isall("EscChar %d", (int *)0)) {
                 composite_warning();
                 break;
             }
             goto invalid;
 
-          case 'F':
+          case kwFontName:
             if (l.isall("FontName %+s", &s)) {
                 _afm->set_font_name(s);
                 break;
             }
+            goto invalid;
+
+          case kwFullName:
             if (l.isall("FullName %+s", &s)) {
                 _afm->set_full_name(s);
                 break;
             }
+            goto invalid;
+
+          case kwFamilyName:
             if (l.isall("FamilyName %+s", &s)) {
                 _afm->set_family(s);
                 break;
             }
+            goto invalid;
+
+          case kwFontBBox:
             if (l.isall("FontBBox %g %g %g %g",
                         &fd( fdFontBBllx ), &fd( fdFontBBlly ),
                         &fd( fdFontBBurx ), &fd( fdFontBBury )))
                 break;
             goto invalid;
 
-          case 'I':
+          case kwItalicAngle:
             if (l.isall("ItalicAngle %g", &fd( fdItalicAngle )))
                 break;
+            goto invalid;
+
+          case kwIsBaseFont:
             if (l.isall("IsBaseFont %b", &isbasefont)) {
                 if (isbasefont == 0)
                     composite_warning();
                 break;
             }
+            goto invalid;
+
+          case kwIsFixedV:
             if (l.isall("IsFixedV %b", (bool *)0)) {
                 metrics_sets_warning();
                 break;
             }
+            goto invalid;
+
+          case kwIsFixedPitch:
             if (l.isall("IsFixedPitch %b", (bool *)0))
                 break;
             goto invalid;
 
-          case 'M':
+          case kwMappingScheme:
             if (l.isall("MappingScheme %d", (int *)0)) {
                 composite_warning();
                 break;
             }
+            goto invalid;
+
+          case kwMetricsSets:
             if (l.isall("MetricsSets %d", &metrics_sets)) {
                 if (metrics_sets != 0)
                     metrics_sets_warning();
@@ -244,68 +365,93 @@ AfmReader::read()
             }
             goto invalid;
 
-          case 'N':
+          case kwNotice:
             if (l.isall("Notice %+s", &_afm_xt->notice))
                 break;
             goto invalid;
 
-          case 'S':
+          case kwStartDirection:
             if (l.isall("StartDirection %d", &direction)) {
                 if (direction != 0)
                     metrics_sets_warning();
                 break;
             }
+            goto invalid;
+
+          case kwStartCharMetrics:
             if (l.isall("StartCharMetrics %d", (int *)0)) {
                 read_char_metrics();
                 break;
             }
+            goto invalid;
+
+          case kwStartKernData:
             if (l.isall("StartKernData")) {
                 read_kerns();
                 break;
             }
+            goto invalid;
+
+          case kwStartComposites:
             if (l.isall("StartComposites %d", (int *)0)) {
                 read_composites();
                 break;
             }
+            goto invalid;
+
+          case kwStdHW:
             if (l.isall("StdHW %g", &fd( fdStdHW )))
                 break;
+            goto invalid;
+
+          case kwStdVW:
             if (l.isall("StdVW %g", &fd( fdStdVW )))
                 break;
+            goto invalid;
+
+          case kwStartFontMetrics:
             if (l.isall("StartFontMetrics %g", (double *)0))
                 break;
             goto invalid;
 
-          case 'U':
+          case kwUnderlinePosition:
             if (l.isall("UnderlinePosition %g", &fd( fdUnderlinePosition )))
                 break;
+            goto invalid;
+
+          case kwUnderlineThickness:
             if (l.isall("UnderlineThickness %g", &fd( fdUnderlineThickness )))
                 break;
             goto invalid;
 
-          case 'V':
+          case kwVersion:
             if (l.isall("Version %+s", &s)) {
                 _afm->set_version(s);
                 break;
             }
+            goto invalid;
+
+          case kwVVector:
             if (l.isall("VVector %g %g", (double *)0, (double *)0)) {
                 metrics_sets_warning();
                 break;
             }
             goto invalid;
 
-          case 'W':
+          case kwWeight:
             if (l.isall("Weight %+s", &s)) {
                 _afm->set_weight(s);
                 break;
             }
             goto invalid;
 
-          case 'X':
+          case kwXHeight:
             if (l.isall("XHeight %g", &fd( fdXHeight )))
                 break;
             goto invalid;
 
           default:
+            l.keyword_mismatch();
           invalid:
             invalid_lines++;
             no_match_warning();
@@ -335,31 +481,33 @@ AfmReader::read_char_metric_data() const
 
     AfmParser &l = _l;
 
-    l.is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;",
-         &c, &wx, &n, &bllx, &blly, &burx, &bury);
+    l.is_char_metric(c, wx, n, bllx, blly, burx, bury);
 
     while (l.left()) {
 
-        switch (l.first()) {
+        switch (find_keyword(l)) {
 
-          case 'B':
+          case kwB:
             if (l.is("B %g %g %g %g", &bllx, &blly, &burx, &bury))
                 break;
             goto invalid;
 
-          case 'C':
+          case kwC:
             if (l.is("C %d", &c))
                 break;
+            goto invalid;
+
+          case kwCH:
             if (l.is("CH <%x>", &c))
                 break;
             goto invalid;
 
-          case 'E':
+          case kwEndCharMetrics:
             if (l.isall("EndCharMetrics"))
                 return;
             goto invalid;
 
-          case 'L':
+          case kwL:
             if (l.is("L %/s %/s", &ligright, &ligresult)) {
                 if (!n)
                     lerror("ligature given, but character has no name");
@@ -372,30 +520,65 @@ AfmReader::read_char_metric_data() const
             }
             goto invalid;
 
-          case 'N':
+          case kwN:
             if (l.is("N %/s", &n))
                 break;
             goto invalid;
 
-          case 'W':
-            if (l.is("WX %g", &wx) ||
-                l.is("W0X %g", &wx))
+          case kwWX:
+            if (l.is("WX %g", &wx))
+                break;
+            goto invalid;
+
+          case kwW0X:
+            if (l.is("W0X %g", &wx))
+                break;
+            goto invalid;
+
+          case kwW:
+            if (l.is("W %g %g", &wx, (double *)0)) {
+                y_width_warning();
+                break;
+            }
+            goto invalid;
+
+          case kwW0:
+            if (l.is("W0 %g %g", &wx, (double *)0)) {
+                y_width_warning();
                 break;
-            if (l.is("W %g %g", &wx, (double *)0) ||
-                l.is("W0 %g %g", &wx, (double *)0) ||
-                l.is("W0Y %g", (double *)0)) {
+            }
+            goto invalid;
+
+          case kwW0Y:
+            if (l.is("W0Y %g", (double *)0)) {
                 y_width_warning();
                 break;
             }
-            if (l.is("W1X %g", (double *)0) ||
-                l.is("W1Y %g", (double *)0) ||
-                l.is("W1 %g %g", (double *)0, (double *)0)) {
+            goto invalid;
+
+          case kwW1X:
+            if (l.is("W1X %g", (double *)0)) {
+                metrics_sets_warning();
+                break;
+            }
+            goto invalid;
+
+          case kwW1Y:
+            if (l.is("W1Y %g", (double *)0)) {
+                metrics_sets_warning();
+                break;
+            }
+            goto invalid;
+
+          case kwW1:
+            if (l.is("W1 %g %g", (double *)0, (double *)0)) {
                 metrics_sets_warning();
                 break;
             }
             goto invalid;
 
           default:
+            l.keyword_mismatch();
           invalid:
             // always warn about unknown directives here!
             no_match_warning("character metrics");
@@ -476,43 +659,57 @@ AfmReader::read_char_metrics() const
 void
 AfmReader::read_kerns() const
 {
-    double kx;
-    PermString left, right;
-    GlyphIndex leftgi, rightgi;
+    double kx, ky;
+    PermString left, right, last_left;
+    GlyphIndex leftgi = -1, rightgi;
 
     AfmParser &l = _l;
     // AFM files have reversed pair programs when read.
     _afm->pair_program()->set_reversed(true);
 
     while (l.next_line())
-        switch (l.first()) {
+        switch (find_keyword(l)) {
 
-          case 'C':
+          case kwComment:
             if (l.is("Comment"))
                 break;
             goto invalid;
 
-          case 'E':
+          case kwEndKernPairs:
             if (l.isall("EndKernPairs"))
                 break;
+            goto invalid;
+
+          case kwEndKernData:
             if (l.isall("EndKernData"))
                 return;
+            goto invalid;
+
+          case kwEndTrackKern:
             if (l.isall("EndTrackKern"))
                 break;
             goto invalid;
 
-          case 'K':
-            if (l.isall("KPX %/s %/s %g", &left, &right, &kx)) {
+          case kwKPX:
+            if (l.isall_kern("KPX %/s %/s %g", left, right, kx))
                 goto validkern;
-            }
+            goto invalid;
+
+          case kwKP:
             if (l.isall("KP %/s %/s %g %g", &left, &right, &kx, (double *)0)) {
                 y_width_warning();
                 goto validkern;
             }
-            if (l.isall("KPY %/s %/s %g", &left, &right, (double *)0)) {
+            goto invalid;
+
+          case kwKPY:
+            if (l.isall_kern("KPY %/s %/s %g", left, right, ky)) {
                 y_width_warning();
                 break;
             }
+            goto invalid;
+
+          case kwKPH:
             if (l.isall("KPH <%x> <%x> %g %g", (int *)0, (int *)0,
                         (double *)0, (double *)0)) {
                 lwarning("KPH not supported");
@@ -521,7 +718,11 @@ AfmReader::read_kerns() const
             goto invalid;
 
           validkern:
-            leftgi = find_err(left, "kern");
+            // pairs usually come grouped by left character
+            if (left != last_left || leftgi < 0) {
+                leftgi = find_err(left, "kern");
+                last_left = left;
+            }
             rightgi = find_err(right, "kern");
             if (leftgi >= 0 && rightgi >= 0)
                 // A kern with 0 amount is NOT useless!
@@ -530,25 +731,36 @@ AfmReader::read_kerns() const
                     lwarning("duplicate kern; first pair ignored");
             break;
 
-          case 'S':
-            if (l.isall("StartKernPairs %d", (int *)0) ||
-                l.isall("StartKernPairs0 %d", (int *)0))
+          case kwStartKernPairs:
+            if (l.isall("StartKernPairs %d", (int *)0))
                 break;
+            goto invalid;
+
+          case kwStartKernPairs0:
+            if (l.isall("StartKernPairs0 %d", (int *)0))
+                break;
+            goto invalid;
+
+          case kwStartKernPairs1:
             if (l.isall("StartKernPairs1 %d", (int *)0)) {
                 metrics_sets_warning();
                 break;
             }
+            goto invalid;
+
+          case kwStartTrackKern:
             if (l.isall("StartTrackKern %d", (int *)0))
                 break;
             goto invalid;
 
-          case 'T':
+          case kwTrackKern:
             if (l.isall("TrackKern %g %g %g %g %g", (double *)0, (double *)0,
                         (double *)0, (double *)0, (double *)0))
                 break; // FIXME: implement TrackKern
             goto invalid;
 
           default:
+            l.keyword_mismatch();
           invalid:
             no_match_warning();
             break;
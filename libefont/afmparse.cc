@@ -342,6 +342,167 @@ AfmParser::is(const char *format, ...)
 }
 
 
+// Non-varargs scanners for the common records. Each matches like the
+// corresponding vis() format element, and returns false on mismatch.
+
+static inline bool
+scan_space(unsigned char *&str)
+{
+    if (!isspace(*str))
+        return false;
+    do {
+        str++;
+    } while (isspace(*str));
+    return true;
+}
+
+static inline bool
+scan_char(unsigned char *&str, unsigned char c)
+{
+    // format " c": whitespace, then c
+    if (!scan_space(str) || *str != c)
+        return false;
+    str++;
+    return true;
+}
+
+static inline bool
+scan_name(unsigned char *&str, PermString &s)
+{
+    // format " %/s"
+    if (!scan_space(str))
+        return false;
+    int len;
+    for (len = 0; !name_enders[ str[len] ]; len++)
+        ;
+    if (len == 0)
+        return false;
+    s = PermString((char *)str, len);
+    str += len;
+    return true;
+}
+
+static inline bool
+scan_integer(unsigned char *&str, int &v)
+{
+    // format " %d"
+    if (!scan_space(str))
+        return false;
+    unsigned char *s = str + (*str == '-');
+    unsigned char *d = s;
+    int x = 0;
+    while (isdigit(*s) && s - d < 9)
+        x = 10 * x + *s++ - '0';
+    if (s != d && !isdigit(*s)) {
+        v = (*str == '-' ? -x : x);
+        str = s;
+        return true;
+    }
+    union { unsigned char *uc; char *c; } new_str;
+    v = strtol((char *)str, &new_str.c, 10);
+    if (new_str.uc == str)
+        return false;
+    str = new_str.uc;
+    return true;
+}
+
+static inline bool
+scan_number(unsigned char *&str, double &v)
+{
+    // format " %g"; strtonumber() only calls strtod() for fractions
+    if (!scan_space(str))
+        return false;
+    unsigned char *s = str + (*str == '-');
+    unsigned char *d = s;
+    int x = 0;
+    while (isdigit(*s) && s - d < 9)
+        x = 10 * x + *s++ - '0';
+    if (s != d && !isdigit(*s) && *s != '.' && *s != 'E' && *s != 'e') {
+        v = (*str == '-' ? -x : x);
+        str = s;
+        return true;
+    }
+    union { unsigned char *uc; char *c; } new_str;
+    v = strtonumber((char *)str, &new_str.c);
+    if (v < MIN_KNOWN_DOUBLE)
+        v = MIN_KNOWN_DOUBLE;
+    if (new_str.uc == str)
+        return false;
+    str = new_str.uc;
+    return true;
+}
+
+bool
+AfmParser::is_char_metric(int &c, double &wx, PermString &n,
+                          double &bllx, double &blly, double &burx, double &bury)
+{
+    // is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;", ...)
+    unsigned char *str = _pos;
+    int xc;
+    double xwx, xb[4];
+    PermString xn;
+    if (str[0] == 'C' && !isalnum(str[1])
+        && scan_integer(++str, xc)
+        && scan_char(str, ';')
+        && scan_char(str, 'W') && *str++ == 'X'
+        && scan_number(str, xwx)
+        && scan_char(str, ';')
+        && scan_char(str, 'N')
+        && scan_name(str, xn)
+        && scan_char(str, ';')
+        && scan_char(str, 'B')
+        && scan_number(str, xb[0]) && scan_number(str, xb[1])
+        && scan_number(str, xb[2]) && scan_number(str, xb[3])
+        && scan_char(str, ';')) {
+        while (isspace(*str))
+            str++;
+        c = xc;
+        wx = xwx;
+        n = xn;
+        bllx = xb[0];
+        blly = xb[1];
+        burx = xb[2];
+        bury = xb[3];
+        _pos = str;
+        _fail_field = 7;
+        _message = PermString();
+        return true;
+    } else
+        return is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;",
+                  &c, &wx, &n, &bllx, &blly, &burx, &bury);
+}
+
+bool
+AfmParser::isall_kern(const char *format, PermString &left, PermString &right,
+                      double &kx)
+{
+    // isall(format, ...), where format is "<keyword> %/s %/s %g"
+    unsigned char *str = _pos;
+    const char *k = format;
+    while (*k != ' ' && *str == (unsigned char) *k)
+        k++, str++;
+    PermString xleft, xright;
+    double xkx;
+    if (*k == ' ' && !isalnum(*str)
+        && scan_name(str, xleft)
+        && scan_name(str, xright)
+        && scan_number(str, xkx)) {
+        while (isspace(*str))
+            str++;
+        if (*str == 0) {
+            left = xleft;
+            right = xright;
+            kx = xkx;
+            _pos = str;
+            _fail_field = 3;
+            _message = PermString();
+            return true;
+        }
+    }
+    return isall(format, &left, &right, &kx);
+}
+
+
 PermString
 AfmParser::keyword() const
 {
@@ -355,6 +516,28 @@ AfmParser::keyword() const
 }
 
 
+int
+AfmParser::keyword_length() const
+{
+    // length of the keyword at the current position, as vis() sees it
+    const unsigned char *l = _pos;
+    while (isalnum(*l))
+        l++;
+    return l - _pos;
+}
+
+
+void
+AfmParser::keyword_mismatch()
+{
+    // record an unknown keyword the way vis() does
+    if (!_message) {
+        _fail_field = -1;
+        _message = "keyword mismatch";
+    }
+}
+
+
 void
 AfmParser::skip_until(unsigned char c)
 {
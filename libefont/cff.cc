@@ -25,6 +25,7 @@
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#include <new>
 #include <efont/t1unparser.hh>
 
 #ifndef static_assert
@@ -358,8 +359,7 @@ Cff::Cff(const String& s, unsigned units_per_em, ErrorHandler* errh)
 
 Cff::~Cff()
 {
-    for (int i = 0; i < _gsubrs_cs.size(); i++)
-        delete _gsubrs_cs[i];
+    // _gsubrs_cs all come from _gsubrs_arena
 }
 
 /*
@@ -571,16 +571,47 @@ Cff::gsubr(int i)
     if (!_gsubrs_cs[i]) {
         const uint8_t *s1 = _gsubrs_index[i];
         int slen = _gsubrs_index[i + 1] - s1;
-        String cs = data_string().substring(s1 - data(), slen);
         if (slen == 0)
             return 0;
         else
-            _gsubrs_cs[i] = new Type2Charstring(cs);
+            _gsubrs_cs[i] = _gsubrs_arena.make(s1, slen);
     }
     return _gsubrs_cs[i];
 }
 
 
+/*****
+ * Cff::CharstringArena
+ **/
+
+inline int
+Cff::CharstringArena::block_size(int i)
+{
+    return (i < 8 ? MIN_BLOCK << i : MAX_BLOCK);
+}
+
+Cff::CharstringArena::~CharstringArena()
+{
+    for (int i = 0; i < _blocks.size(); i++) {
+        int n = (i == _blocks.size() - 1 ? _used : block_size(i));
+        for (int j = 0; j < n; j++)
+            _blocks[i][j].~Type2Charstring();
+        operator delete(_blocks[i]);
+    }
+}
+
+Type2Charstring *
+Cff::CharstringArena::make(const uint8_t *data, int len)
+{
+    if (!_blocks.size() || _used == block_size(_blocks.size() - 1)) {
+        int n = block_size(_blocks.size());
+        _blocks.push_back(static_cast<Type2Charstring *>(operator new(n * sizeof(Type2Charstring))));
+        _used = 0;
+    }
+    return new(static_cast<void *>(_blocks.back() + _used++)) Type2Charstring(data, len);
+}
+
+
 /*****
  * Cff::Charset
  **/
@@ -1205,22 +1236,23 @@ handle_private(Cff *cff, const Cff::Dict &top_dict, Cff::Dict &private_dict,
 
 
 Cff::FontParent::FontParent(Cff* cff)
-    : CharstringProgram(cff->units_per_em()), _cff(cff), _error(-1)
+    : CharstringProgram(cff->units_per_em()), _cff(cff), _charstring_type(2),
+      _error(-1)
 {
 }
 
 Charstring *
 Cff::FontParent::charstring(const IndexIterator &iiter, int which) const
 {
+    // Type 2 charstrings come from _arena and must not be deleted
     const uint8_t *s1 = iiter[which];
     int slen = iiter[which + 1] - s1;
-    String cs = _cff->data_string().substring(s1 - _cff->data(), slen);
     if (slen == 0)
         return 0;
     else if (_charstring_type == 1)
-        return new Type1Charstring(cs);
+        return new Type1Charstring(_cff->data_string().substring(s1 - _cff->data(), slen));
     else
-        return new Type2Charstring(cs);
+        return _arena.make(s1, slen);
 }
 
 Charstring *
@@ -1278,8 +1310,9 @@ Cff::Font::Font(Cff *cff, PermString font_name, const Dict &top_dict, ErrorHandl
 
 Cff::Font::~Font()
 {
-    for (int i = 0; i < _charstrings_cs.size(); i++)
-        delete _charstrings_cs[i];
+    if (_charstring_type == 1)
+        for (int i = 0; i < _charstrings_cs.size(); i++)
+            delete _charstrings_cs[i];
     delete _t1encoding;
 }
 
@@ -1544,8 +1577,9 @@ Cff::CIDFont::CIDFont(Cff *cff, PermString font_name, const Dict &top_dict, Erro
 
 Cff::CIDFont::~CIDFont()
 {
-    for (int i = 0; i < _charstrings_cs.size(); i++)
-        delete _charstrings_cs[i];
+    if (_charstring_type == 1)
+        for (int i = 0; i < _charstrings_cs.size(); i++)
+            delete _charstrings_cs[i];
     for (int i = 0; i < _child_fonts.size(); i++)
         delete _child_fonts[i];
 }
@@ -1649,22 +1683,9 @@ Cff::ChildFont::ChildFont(Cff *cff, Cff::CIDFont *parent, int charstring_type, c
 
 Cff::ChildFont::~ChildFont()
 {
-    for (int i = 0; i < _subrs_cs.size(); i++)
-        delete _subrs_cs[i];
-}
-
-Charstring *
-Cff::ChildFont::charstring(const IndexIterator &iiter, int which) const
-{
-    const uint8_t *s1 = iiter[which];
-    int slen = iiter[which + 1] - s1;
-    String cs = _cff->data_string().substring(s1 - _cff->data(), slen);
-    if (slen == 0)
-        return 0;
-    else if (_charstring_type == 1)
-        return new Type1Charstring(cs);
-    else
-        return new Type2Charstring(cs);
+    if (_charstring_type == 1)
+        for (int i = 0; i < _subrs_cs.size(); i++)
+            delete _subrs_cs[i];
 }
 
 Charstring *
@@ -20,11 +20,40 @@
 #include <efont/afmparse.hh>
 #include <efont/afm.hh>
 #include <efont/amfm.hh>
+#include <efont/metcache.hh>
 #include <efont/psres.hh>
+#include <lcdf/error.hh>
 #include <string.h>
 #include <stdlib.h>
 namespace Efont {
 
+static bool compiled_metrics = false;
+static String compiled_metrics_directory;
+
+namespace {
+// Counts the messages reported while reading an AFM file.  Only files that
+// read cleanly are compiled, since loading a compiled file can't repeat
+// their warnings.
+class MessageCountErrorHandler : public ErrorVeneer { public:
+
+    MessageCountErrorHandler(ErrorHandler *errh)
+        : ErrorVeneer(errh), _nmessages(0) {
+    }
+
+    int nmessages() const               { return _nmessages; }
+
+    void account(int level) {
+        _nmessages++;
+        ErrorVeneer::account(level);
+    }
+
+  private:
+
+    int _nmessages;
+
+};
+}
+
 MetricsFinder::~MetricsFinder()
 {
     if (_next)
@@ -87,6 +116,21 @@ MetricsFinder::record(AmfmMetrics *amfm)
     if (_next) _next->record(amfm);
 }
 
+/** @brief Set whether AFM files are compiled.
+ * @param on true iff compiled metrics should be used
+ * @param directory directory for compiled files
+ *
+ * When on, try_metrics_file() saves a compiled binary form of each AFM file
+ * it reads, and later loads that form instead of parsing the AFM text while
+ * the AFM file's size and modification time are unchanged.  Compiled files
+ * go in @a directory, or beside their AFM files if @a directory is empty. */
+void
+MetricsFinder::set_compiled_metrics(bool on, const String &directory)
+{
+    compiled_metrics = on;
+    compiled_metrics_directory = directory;
+}
+
 Metrics *
 MetricsFinder::find_metrics_x(PermString, MetricsFinder *, ErrorHandler *)
 {
@@ -104,7 +148,18 @@ MetricsFinder::try_metrics_file(const Filename &fn, MetricsFinder *finder,
                                 ErrorHandler *errh)
 {
     if (fn.readable()) {
-        Metrics *afm = AfmReader::read(fn, errh);
+        Metrics *afm = 0;
+        String cache_fn;
+        if (compiled_metrics && !fn.fake()) {
+            cache_fn = MetricsCache::cache_filename(fn, compiled_metrics_directory);
+            afm = MetricsCache::read(cache_fn, fn);
+        }
+        if (!afm) {
+            MessageCountErrorHandler cerrh(errh);
+            afm = AfmReader::read(fn, &cerrh);
+            if (afm && cache_fn && cerrh.nmessages() == 0)
+                MetricsCache::write(afm, cache_fn, fn);
+        }
         if (afm) finder->record(afm);
         return afm;
     } else
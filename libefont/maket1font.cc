@@ -0,0 +1,1367 @@
+// -*- related-file-name: "../include/efont/maket1font.hh" -*-
+
+/* maket1font.{cc,hh} -- translate CFF fonts to Type 1 fonts
+ *
+ * Copyright (c) 2002-2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/maket1font.hh>
+#include <efont/t1interp.hh>
+#include <efont/t1csgen.hh>
+#include <lcdf/point.hh>
+#include <lcdf/error.hh>
+#include <efont/t1font.hh>
+#include <efont/t1item.hh>
+#include <efont/t1unparser.hh>
+#include <lcdf/hashmap.hh>
+#include <lcdf/mapfile.hh>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#if HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+#if HAVE_UNISTD_H && HAVE_SYS_WAIT_H && HAVE_WAITPID
+# define MAKET1FONT_PARALLEL 1
+#endif
+
+namespace Efont {
+
+typedef unsigned CsRef;
+enum { CSR_GLYPH = 0x00000000, CSR_SUBR = 0x80000000,
+       CSR_GSUBR = 0xC0000000,
+       CSR_TYPE = 0xC0000000, CSR_NUM = 0x3FFFFFFF };
+
+class MakeType1CharstringInterp : public Type1CharstringGenInterp { public:
+
+    MakeType1CharstringInterp(int precision = 5);
+    ~MakeType1CharstringInterp();
+
+    Type1Font *output() const			{ return _output; }
+
+    void set_find_subrs(bool fs)		{ _find_subrs = fs; }
+
+    void run(const CharstringProgram *, Type1Font *, PermString glyph_definer, ErrorHandler *, int nprocs = 1);
+    void run(const CharstringContext &, Type1Charstring &, ErrorHandler *);
+
+    bool type2_command(int, const uint8_t *, int *);
+    void act_hintmask(int, const uint8_t *, int);
+
+    String landmark(ErrorHandler *errh) const;
+
+    class Subr;
+
+  private:
+
+    // output
+    Type1Font *_output;
+    int _flex_message;
+
+    // subroutines
+    bool _find_subrs;
+    int _subr_bias;
+    int _gsubr_bias;
+    mutable Vector<Subr *> _glyphs;
+    mutable Vector<Subr *> _subrs;
+    mutable Vector<Subr *> _gsubrs;
+
+    Subr *_cur_subr;
+    int _cur_glyph;
+
+    // parallel conversion
+    Vector<CsRef> *_caller_log;
+    int _settle_glyph;
+    HashMap<String, int> _hr_subrs;
+    int _hr_first;
+    int _hr_mapped;
+
+    Subr *csr_subr(CsRef, bool force) const;
+    Type1Charstring *csr_charstring(CsRef) const;
+
+    int flex_flags() const;
+    void report_flex(int flags, ErrorHandler *);
+    void add_glyph(const CharstringProgram *, int, const Type1Charstring &, PermString glyph_definer, ErrorHandler *);
+    void convert_glyph(const CharstringProgram *, int, Type1Charstring &, PermString glyph_definer, ErrorHandler *);
+
+    bool run_parallel(const CharstringProgram *, PermString glyph_definer, ErrorHandler *, int nprocs);
+    String run_slice(const CharstringProgram *, int first, int last);
+    bool merge_slice(const String &, const CharstringProgram *, int first, int last, bool apply, PermString glyph_definer, ErrorHandler *);
+    int hr_subr(const String &);
+
+};
+
+class MakeType1CharstringInterp::Subr { public:
+
+    Subr(CsRef csr)			: _csr(csr), _output_subrno(-1), _stamp(0) { }
+
+    bool up_to_date() const		{ return _stamp == max_stamp; }
+    void update()			{ _stamp = max_stamp; }
+    static void bump_date()		{ max_stamp++; }
+
+    //String name(const MakeType1CharstringInterp *) const;
+    Type1Charstring *charstring(const MakeType1CharstringInterp *) const;
+
+    int ncalls() const			{ return _calls.size(); }
+    Subr *call(int i) const		{ return _calls[i]; }
+    bool has_call(Subr *) const;
+
+    struct Caller {
+	Subr *subr;
+	int pos;
+	int len;
+	Caller(Subr *s, int p, int l)
+            : subr(s), pos(p), len(l) {
+        }
+	String charstring(MakeType1CharstringInterp *mcsi) const {
+	    Type1Charstring *t1cs = subr->charstring(mcsi);
+	    return t1cs->substring(pos, len);
+	}
+    };
+
+    int ncallers() const		{ return _callers.size(); }
+    const Caller &caller(int i) const	{ return _callers[i]; }
+
+    void add_call(Subr *s)		{ _calls.push_back(s); }
+    void add_caller(Subr *s, int pos, int len);
+
+    int output_subrno() const		{ return _output_subrno; }
+    void set_output_subrno(int n)	{ _output_subrno = n; }
+
+    void transfer_nested_calls(int pos, int length, Subr *new_caller) const;
+    void change_callers(Subr *, int pos, int length, int new_length);
+    bool unify(MakeType1CharstringInterp *);
+
+  private:
+
+    CsRef _csr;
+    Vector<Subr *> _calls;
+    Vector<Caller> _callers;
+
+    int _output_subrno;
+    int _stamp;
+
+    static int max_stamp;
+
+    friend class MakeType1CharstringInterp;
+
+};
+
+int MakeType1CharstringInterp::Subr::max_stamp = 1;
+
+inline void
+MakeType1CharstringInterp::Subr::add_caller(Subr *s, int pos, int len)
+{
+    _callers.push_back(Caller(s, pos, len));
+}
+
+bool
+MakeType1CharstringInterp::Subr::has_call(Subr *s) const
+{
+    for (int i = 0; i < _calls.size(); i++)
+	if (_calls[i] == s)
+	    return true;
+    return false;
+}
+
+
+/*****
+ * MakeType1CharstringInterp
+ **/
+
+MakeType1CharstringInterp::MakeType1CharstringInterp(int precision)
+    : Type1CharstringGenInterp(precision), _flex_message(0), _find_subrs(false),
+      _caller_log(0), _settle_glyph(-1), _hr_first(0), _hr_mapped(0)
+{
+}
+
+MakeType1CharstringInterp::~MakeType1CharstringInterp()
+{
+    for (int i = 0; i < _glyphs.size(); i++)
+	delete _glyphs[i];
+    for (int i = 0; i < _subrs.size(); i++)
+	delete _subrs[i];
+    for (int i = 0; i < _gsubrs.size(); i++)
+	delete _gsubrs[i];
+}
+
+String
+MakeType1CharstringInterp::landmark(ErrorHandler *errh) const
+{
+    if (_cur_glyph >= 0 && _cur_glyph < program()->nglyphs())
+	return errh->format("glyph %<%s%>", program()->glyph_name(_cur_glyph).c_str());
+    else
+	return String();
+}
+
+
+// subroutines
+
+MakeType1CharstringInterp::Subr *
+MakeType1CharstringInterp::csr_subr(CsRef csr, bool force) const
+{
+    Vector<Subr *> *vp;
+    if ((csr & CSR_TYPE) == CSR_SUBR)
+	vp = &_subrs;
+    else if ((csr & CSR_TYPE) == CSR_GSUBR)
+	vp = &_gsubrs;
+    else if ((csr & CSR_TYPE) == CSR_GLYPH)
+	vp = &_glyphs;
+    else
+	return 0;
+
+    int n = (csr & CSR_NUM);
+    if (n >= vp->size())
+	return 0;
+
+    Subr *&what = (*vp)[n];
+    if (!what && force)
+	what = new Subr(csr);
+    return what;
+}
+
+#if 0
+String
+MakeType1CharstringInterp::Subr::name(const MakeType1CharstringInterp *mcsi) const
+{
+    int n = (_csr & CSR_NUM);
+    switch (_csr & CSR_TYPE) {
+    case CSR_SUBR:
+	return "subr" + String(n);
+    case CSR_GSUBR:
+	return "gsubr" + String(n);
+    case CSR_GLYPH:
+	if (String name = mcsi->output()->glyph_name(n))
+	    return name;
+	else
+	    return "??glyph" + String(n) + "??";
+    default:
+	return "";
+    }
+}
+#endif
+
+Type1Charstring *
+MakeType1CharstringInterp::Subr::charstring(const MakeType1CharstringInterp *mcsi) const
+{
+    int n = (_csr & CSR_NUM);
+    switch (_csr & CSR_TYPE) {
+      case CSR_SUBR:
+      case CSR_GSUBR:
+	if (_output_subrno >= 0)
+	    return static_cast<Type1Charstring *>(mcsi->output()->subr(_output_subrno));
+	return 0;
+      case CSR_GLYPH:
+	return static_cast<Type1Charstring *>(mcsi->output()->glyph(n));
+      default:
+	return 0;
+    }
+}
+
+void
+MakeType1CharstringInterp::Subr::transfer_nested_calls(int pos, int length, Subr *new_caller) const
+{
+    int right = pos + length;
+    for (int i = 0; i < _calls.size(); i++) {
+	Subr *cs = _calls[i];
+	// 11.Jul.2006 - remember not to shift the new caller's records!  (Michael Zedler)
+	if (cs != new_caller)
+	    for (int j = 0; j < cs->_callers.size(); j++) {
+		Caller &c = cs->_callers[j];
+		if (c.subr == this && pos <= c.pos && c.pos + c.len <= right) {
+		    // shift caller to point at the subroutine
+		    c.subr = new_caller;
+		    c.pos -= pos;
+		    new_caller->add_call(cs);
+		}
+	    }
+    }
+}
+
+void
+MakeType1CharstringInterp::Subr::change_callers(Subr *caller, int pos, int length, int new_length)
+{
+    if (up_to_date())
+	return;
+    update();
+
+    int right = pos + length;
+    int delta = new_length - length;
+    for (int i = 0; i < _callers.size(); i++) {
+	Caller &c = _callers[i];
+	if (c.subr != caller)
+	    /* nada */;
+	else if (pos <= c.pos && c.pos + c.len <= right) {
+	    // erase
+	    //if (c.debug) fprintf(stderr, "  ERASE caller %08x:%d+%d [%d+%d]\n", c.subr->_csr, c.pos, c.len, pos, length);
+	    c.subr = 0;
+	} else if (right <= c.pos) {
+	    //if (c.debug) fprintf(stderr, "  ADJUST caller %08x:%d+%d -> %d+%d [%d+%d]\n", c.subr->_csr, c.pos, c.len, c.pos+delta, c.len, pos, length);
+	    c.pos += delta;
+	} else if (c.pos <= pos && right <= c.pos + c.len) {
+            //if (c.debug) fprintf(stderr, "  ADJUST caller %08x:%d+%d -> %d+%d [%d+%d]\n", c.subr->_csr, c.pos, c.len, c.pos, c.len+delta, pos, length);
+	    c.len += delta;
+	} else
+	    c.subr = 0;
+    }
+}
+
+bool
+MakeType1CharstringInterp::Subr::unify(MakeType1CharstringInterp *mcsi)
+{
+    // clean up caller list
+    for (int i = 0; i < _callers.size(); i++)
+	if (!_callers[i].subr) {
+	    _callers[i] = _callers.back();
+	    _callers.pop_back();
+	    i--;
+	}
+
+    if (!_callers.size())
+	return false;
+    assert(!_calls.size());	// because this hasn't been unified yet
+
+    // Find the smallest shared complete charstring.
+    String substr = _callers[0].charstring(mcsi);
+    int suboff = 0;
+    for (int i = 1; i < _callers.size(); i++) {
+	String substr1 = _callers[i].charstring(mcsi);
+	const char *d = substr.data() + suboff, *d1 = substr1.data();
+	const char *dx = substr.data() + substr.length(), *d1x = d1 + substr1.length();
+	while (dx > d && d1x > d1 && dx[-1] == d1x[-1])
+	    dx--, d1x--;
+        if (d1x != d1) {
+            // 8.13.2013 -- We might have stopped in the middle of a number
+            // or command in d1 -- even if we absorbed all of d! For
+            // example, maybe d's version is "15 rlineto" (encoded "154 5"),
+            // and our version is "518 rlineto" (encoded "248 154 5")! So
+            // whenever we stop before the end of d1, we must adjust our
+            // position to the next caret in d1, which, in the example,
+            // would be after "248 154" and before "5".
+            int suboff1 = Type1Charstring(substr1).first_caret_after(d1x - d1);
+            dx += suboff1 - (d1x - d1);
+        }
+        suboff = dx - substr.data();
+    }
+    substr = substr.substring(Type1Charstring(substr).first_caret_after(suboff));
+    if (!substr.length())
+	return false;
+    for (int i = 0; i < _callers.size(); i++) {
+	Caller &c = _callers[i];
+	if (int delta = c.len - substr.length()) {
+            //if (c.debug) fprintf(stderr, "  PREFIX caller %08x:%d+%d -> %d+%d [%s]\n", c.subr->_csr, c.pos, c.len, c.pos+delta, c.len+delta, CharstringUnparser::unparse(Type1Charstring(substr)).c_str());
+	    c.pos += delta;
+	    c.len -= delta;
+	}
+    }
+
+    // otherwise, success
+    _output_subrno = mcsi->output()->nsubrs();
+    mcsi->output()->set_subr(_output_subrno, Type1Charstring(substr + "\013"));
+
+    // This subr has become real, so it is suitable for later unifications.
+    // Mark it as having called any subroutines contained completely within itself.
+    // How to do this?  Look at one caller, and go over all its calls.
+    _callers[0].subr->transfer_nested_calls(_callers[0].pos, _callers[0].len, this);
+
+    // adapt callers
+    String callsubr_string = Type1CharstringGen::callsubr_string(_output_subrno);
+
+    for (int i = 0; i < _callers.size(); i++)
+	// 13.Jun.2003 - must check whether _callers[i].subr exists: if we
+	// called a subroutine more than once, change_callers() might have
+	// zeroed it out.
+	if (_callers[i].subr && _callers[i].subr != this) {
+	    Subr::Caller c = _callers[i];
+	    c.subr->charstring(mcsi)->assign_substring(c.pos, c.len, callsubr_string);
+	    Subr::bump_date();
+	    for (int j = 0; j < c.subr->ncalls(); j++)
+		c.subr->call(j)->change_callers(c.subr, c.pos, c.len, callsubr_string.length());
+	    assert(!_callers[i].subr);
+	}
+
+    // this subr is no longer "called"/interpolated from anywhere
+    _callers.clear();
+
+    //fprintf(stderr, "Succeeded %x\n", _csr);
+    return true;
+}
+
+
+/*****
+ * repeated fragment subroutines
+ **/
+
+// With find_subrs, subroutines are not carried over from the CFF.
+// Instead, RepeatSubrFinder looks for runs of commands that repeat across
+// the converted glyphs, using a suffix array over the glyphs' command
+// sequences, and moves the runs that save the most bytes into new Subrs.
+
+namespace {
+
+class RepeatSubrFinder { public:
+
+    RepeatSubrFinder(Type1Font *output);
+
+    void run();
+
+  private:
+
+    struct Candidate {
+	int saving;
+	int len;
+	int lb;
+	int rb;
+	Candidate(int s, int l, int lb_, int rb_)
+	    : saving(s), len(l), lb(lb_), rb(rb_) {
+	}
+	bool operator<(const Candidate &x) const {
+	    return saving > x.saving
+		|| (saving == x.saving
+		    && (lb < x.lb || (lb == x.lb && len > x.len)));
+	}
+    };
+
+    enum { SUBR_OVERHEAD = 16 };	// "dup N L RD ... NP\n"
+
+    Type1Font *_output;
+
+    // Every glyph is split into units: a command with its operands.
+    // _text holds one id per unit, with equal ids for equal units that
+    // may move into a subroutine and unique ids for everything else,
+    // including a separator after each glyph.
+    Vector<int> _text;
+    Vector<int> _unit_offset;
+    Vector<int> _bytes;		// _bytes[i]: length of units before i
+    Vector<int> _glyph_first;
+    int _nids;
+
+    Vector<int> _sa;
+    Vector<int> _lcp;
+
+    void add_glyph(const String &cs, HashMap<String, int> &ids);
+    void build_suffix_array();
+    void find_candidates(Vector<Candidate> &cands) const;
+    static int saving(int count, int bytes, int call_bytes);
+
+};
+
+RepeatSubrFinder::RepeatSubrFinder(Type1Font *output)
+    : _output(output), _nids(0)
+{
+}
+
+void
+RepeatSubrFinder::add_glyph(const String &cs, HashMap<String, int> &ids)
+{
+    const uint8_t *s = cs.udata(), *end = s + cs.length();
+    const uint8_t *p = s, *unit = s;
+    int last_number = 0;
+    bool in_flex = false;
+    _glyph_first.push_back(_text.size());
+    while (p < end) {
+	int v = *p++;
+	if (v >= 32) {
+	    if (v <= 246)
+		last_number = v - 139;
+	    else if (v <= 250 && p < end)
+		last_number = ((v - 247) << 8) + *p++ + 108;
+	    else if (v <= 254 && p < end)
+		last_number = -((v - 251) << 8) - *p++ - 108;
+	    else {
+		p = (end - p >= 4 ? p + 4 : end);
+		last_number = 0;
+	    }
+	    continue;
+	}
+
+	int cmd = v;
+	if (v == Charstring::cEscape && p < end)
+	    cmd = Charstring::cEscapeDelta + *p++;
+	if (cmd == Charstring::cDiv)
+	    continue;
+
+	// Flex sequences and calls stay where they are.
+	bool movable = !in_flex;
+	switch (cmd) {
+	  case Charstring::cCallsubr:
+	    if (last_number == 1)
+		in_flex = true;
+	    else if (last_number == 0)
+		in_flex = false;
+	    /* fallthru */
+	  case Charstring::cHsbw:
+	  case Charstring::cSbw:
+	  case Charstring::cEndchar:
+	  case Charstring::cSeac:
+	  case Charstring::cCallothersubr:
+	  case Charstring::cPop:
+	  case Charstring::cSetcurrentpoint:
+	  case Charstring::cReturn:
+	    movable = false;
+	    break;
+	}
+
+	_unit_offset.push_back(unit - s);
+	_bytes.push_back(_bytes.back() + (p - unit));
+	if (movable) {
+	    int &id = ids.find_force(cs.substring(unit - s, p - unit), -1);
+	    if (id < 0)
+		id = _nids++;
+	    _text.push_back(id);
+	} else
+	    _text.push_back(_nids++);
+	unit = p;
+    }
+    if (unit < end) {
+	_unit_offset.push_back(unit - s);
+	_bytes.push_back(_bytes.back() + (end - unit));
+	_text.push_back(_nids++);
+    }
+
+    // glyph separator
+    _unit_offset.push_back(cs.length());
+    _bytes.push_back(_bytes.back());
+    _text.push_back(_nids++);
+}
+
+void
+RepeatSubrFinder::build_suffix_array()
+{
+    // prefix doubling with counting sorts
+    int n = _text.size();
+    Vector<int> rank(_text), tmp(n, 0), cnt(std::max(_nids, n) + 1, 0);
+    _sa.assign(n, 0);
+    for (int i = 0; i < n; ++i)
+	cnt[rank[i]]++;
+    for (int r = 1; r < cnt.size(); ++r)
+	cnt[r] += cnt[r - 1];
+    for (int i = n - 1; i >= 0; --i)
+	_sa[--cnt[rank[i]]] = i;
+
+    for (int k = 1; k < n; k <<= 1) {
+	// order by second key, then stable sort by first key
+	int p = 0;
+	for (int i = n - k; i < n; ++i)
+	    tmp[p++] = i;
+	for (int j = 0; j < n; ++j)
+	    if (_sa[j] >= k)
+		tmp[p++] = _sa[j] - k;
+	cnt.assign(cnt.size(), 0);
+	for (int i = 0; i < n; ++i)
+	    cnt[rank[i]]++;
+	for (int r = 1; r < cnt.size(); ++r)
+	    cnt[r] += cnt[r - 1];
+	for (int j = n - 1; j >= 0; --j)
+	    _sa[--cnt[rank[tmp[j]]]] = tmp[j];
+
+	int r = 0;
+	tmp[_sa[0]] = 0;
+	for (int j = 1; j < n; ++j) {
+	    int a = _sa[j - 1], b = _sa[j];
+	    if (rank[a] != rank[b]
+		|| (a + k < n ? rank[a + k] : -1) != (b + k < n ? rank[b + k] : -1))
+		++r;
+	    tmp[b] = r;
+	}
+	rank.swap(tmp);
+	if (r == n - 1)
+	    break;
+    }
+
+    // Kasai's longest common prefix array: _lcp[j] compares _sa[j - 1]
+    // and _sa[j]
+    for (int j = 0; j < n; ++j)
+	rank[_sa[j]] = j;
+    _lcp.assign(n, 0);
+    for (int i = 0, h = 0; i < n; ++i)
+	if (rank[i] > 0) {
+	    int i1 = _sa[rank[i] - 1];
+	    while (i + h < n && i1 + h < n && _text[i + h] == _text[i1 + h])
+		++h;
+	    _lcp[rank[i]] = h;
+	    if (h > 0)
+		--h;
+	} else
+	    h = 0;
+}
+
+inline int
+RepeatSubrFinder::saving(int count, int bytes, int call_bytes)
+{
+    return count * (bytes - call_bytes) - (bytes + 1 + SUBR_OVERHEAD);
+}
+
+void
+RepeatSubrFinder::find_candidates(Vector<Candidate> &cands) const
+{
+    // Each LCP interval is a fragment repeated at every suffix it spans.
+    // Estimate its saving as if every occurrence could be replaced.
+    int call_bytes = Type1CharstringGen::callsubr_string(_output->nsubrs()).length();
+    Vector<int> stack_lcp, stack_lb;
+    stack_lcp.push_back(0);
+    stack_lb.push_back(0);
+    int n = _text.size();
+    for (int j = 1; j <= n; ++j) {
+	int l = (j < n ? _lcp[j] : 0);
+	int lb = j - 1;
+	while (l < stack_lcp.back()) {
+	    int len = stack_lcp.back();
+	    lb = stack_lb.back();
+	    stack_lcp.pop_back();
+	    stack_lb.pop_back();
+	    int start = _sa[lb];
+	    int bytes = _bytes[start + len] - _bytes[start];
+	    int s = saving(j - lb, bytes, call_bytes);
+	    if (s > 0)
+		cands.push_back(Candidate(s, len, lb, j - 1));
+	}
+	if (l > stack_lcp.back()) {
+	    stack_lcp.push_back(l);
+	    stack_lb.push_back(lb);
+	}
+    }
+    std::sort(cands.begin(), cands.end());
+}
+
+void
+RepeatSubrFinder::run()
+{
+    HashMap<String, int> ids(-1);
+    _bytes.push_back(0);
+    for (int g = 0; g < _output->nglyphs(); ++g)
+	add_glyph(_output->glyph(g)->data_string(), ids);
+    _glyph_first.push_back(_text.size());
+    if (_text.size() < 2)
+	return;
+
+    build_suffix_array();
+    Vector<Candidate> cands;
+    find_candidates(cands);
+
+    // Take candidates in order of estimated saving, replacing whatever
+    // occurrences are still free.
+    int n = _text.size();
+    Vector<uint8_t> used(n, 0);
+    Vector<int> repl_subr(n, -1), repl_len(n, 0);
+    Vector<int> occurrences;
+    for (Candidate *c = cands.begin(); c != cands.end(); ++c) {
+	occurrences.clear();
+	for (int j = c->lb; j <= c->rb; ++j)
+	    occurrences.push_back(_sa[j]);
+	std::sort(occurrences.begin(), occurrences.end());
+
+	int *out = occurrences.begin(), next_free = 0;
+	for (int *o = occurrences.begin(); o != occurrences.end(); ++o)
+	    if (*o >= next_free) {
+		int k = 0;
+		while (k < c->len && !used[*o + k])
+		    ++k;
+		if (k == c->len) {
+		    *out++ = *o;
+		    next_free = *o + c->len;
+		}
+	    }
+	occurrences.erase(out, occurrences.end());
+
+	int subrno = _output->nsubrs();
+	int start = occurrences.size() ? occurrences[0] : 0;
+	int bytes = _bytes[start + c->len] - _bytes[start];
+	String call = Type1CharstringGen::callsubr_string(subrno);
+	if (saving(occurrences.size(), bytes, call.length()) <= 0)
+	    continue;
+
+	int g = std::upper_bound(_glyph_first.begin(), _glyph_first.end(), start) - _glyph_first.begin() - 1;
+	String cs = _output->glyph(g)->data_string();
+	String body = cs.substring(_unit_offset[start], bytes) + "\013";
+	if (!_output->set_subr(subrno, Type1Charstring(body)))
+	    break;
+	for (int *o = occurrences.begin(); o != occurrences.end(); ++o) {
+	    memset(&used[*o], 1, c->len);
+	    repl_subr[*o] = subrno;
+	    repl_len[*o] = c->len;
+	}
+    }
+
+    // rewrite glyphs
+    StringAccum sa;
+    for (int g = 0; g + 1 < _glyph_first.size(); ++g) {
+	Type1Charstring *t1cs = _output->glyph(g);
+	String cs = t1cs->data_string();
+	bool changed = false;
+	for (int i = _glyph_first[g]; i < _glyph_first[g + 1]; ) {
+	    if (repl_subr[i] >= 0) {
+		sa << Type1CharstringGen::callsubr_string(repl_subr[i]);
+		i += repl_len[i];
+		changed = true;
+	    } else {
+		int next = i + 1;
+		sa.append(cs.data() + _unit_offset[i], _bytes[next] - _bytes[i]);
+		i = next;
+	    }
+	}
+	if (changed)
+	    t1cs->assign(sa.take_string());
+	else
+	    sa.clear();
+    }
+}
+
+}
+
+
+// running
+
+bool
+MakeType1CharstringInterp::type2_command(int cmd, const uint8_t *data, int *left)
+{
+    switch (cmd) {
+
+      case Cs::cCallsubr:
+      case Cs::cCallgsubr:
+	if (!_find_subrs && subr_depth() < MAX_SUBR_DEPTH && size() == 1) {
+	    //fprintf(stderr, "succeeded %d\n", (int) top());
+	    bool g = (cmd == Cs::cCallgsubr);
+	    CsRef csref = ((int)top() + program()->xsubr_bias(g)) | (g ? CSR_GSUBR : CSR_SUBR);
+	    Subr *callee = csr_subr(csref, true);
+	    if (callee)
+		_cur_subr->add_call(callee);
+
+	    int left = csgen().length();
+
+	    bool more = callxsubr_command(g);
+
+	    int right = csgen().length();
+	    if (error() >= 0 && callee) {
+		if (_caller_log) {
+		    _caller_log->push_back(csref);
+		    _caller_log->push_back(left);
+		    _caller_log->push_back(right - left);
+		} else
+		    callee->add_caller(_cur_subr, left, right - left);
+	    }
+	    return more;
+	} else {
+	    //fprintf(stderr, "failed %d\n", (int) top());
+	    goto normal;
+	}
+
+      normal:
+      default:
+	return CharstringInterp::type2_command(cmd, data, left);
+
+    }
+}
+
+void
+MakeType1CharstringInterp::act_hintmask(int cmd, const uint8_t *data, int nhints)
+{
+    // Hint replacement compares against the last hints of the previous
+    // glyph, so a slice converted in a child process can differ from a
+    // serial conversion up to its first hintmask.  Remember that glyph.
+    if (_settle_glyph < 0 && cmd != Cs::cCntrmask
+	&& nhints <= Type1CharstringGenInterp::nhints())
+	_settle_glyph = _cur_glyph;
+    Type1CharstringGenInterp::act_hintmask(cmd, data, nhints);
+}
+
+int
+MakeType1CharstringInterp::flex_flags() const
+{
+    return (had_bad_flex() ? 1 : 0) | (had_flex() ? 2 : 0) | (had_hr() ? 4 : 0);
+}
+
+void
+MakeType1CharstringInterp::report_flex(int flags, ErrorHandler *errh)
+{
+    if ((flags & 1) && !(_flex_message & 1)) {
+	errh->lwarning(landmark(errh), "complex flex hint replaced with curves");
+	errh->message("(This font contains flex hints prohibited by Type 1. They%,ve been\nreplaced by ordinary curves.)");
+	_flex_message |= 1;
+    }
+#if !HAVE_ADOBE_CODE
+    if ((flags & 2) && !(_flex_message & 2)) {
+        errh->lwarning(landmark(errh), "flex hints required");
+        errh->message("(This program was compiled without Adobe code for flex hint support,\nso its output may not work on all devices.)");
+        _flex_message |= 2;
+    }
+    if ((flags & 4) && !(_flex_message & 4)) {
+        errh->lwarning(landmark(errh), "hint replacement required");
+        errh->message("(This program was compiled without Adobe code for hint replacement,\nso its output may not work on all devices.)");
+        _flex_message |= 4;
+    }
+#endif
+}
+
+void
+MakeType1CharstringInterp::run(const CharstringContext &g, Type1Charstring &out, ErrorHandler *errh)
+{
+    Type1CharstringGenInterp::run(g, out);
+    report_flex(flex_flags(), errh);
+}
+
+void
+MakeType1CharstringInterp::add_glyph(const CharstringProgram *program, int gi, const Type1Charstring &cs, PermString glyph_definer, ErrorHandler *errh)
+{
+    PermString name = program->glyph_name(gi);
+    if (_output->glyph(name)) {
+	errh->warning("glyph %<%s%> defined more than once", name.c_str());
+	int i = 1;
+	do {
+	    name = program->glyph_name(i) + String(".") + String(i);
+	    ++i;
+	} while (_output->glyph(name));
+    }
+    _output->add_glyph(Type1Subr::make_glyph(name, cs, glyph_definer));
+}
+
+void
+MakeType1CharstringInterp::convert_glyph(const CharstringProgram *program, int gi, Type1Charstring &receptacle, PermString glyph_definer, ErrorHandler *errh)
+{
+    _cur_subr = _glyphs[gi] = new Subr(CSR_GLYPH | gi);
+    _cur_glyph = gi;
+    run(program->glyph_context(gi), receptacle, errh);
+#if 0
+    PermString n = program->glyph_name(gi);
+    if (gi == 408 || gi == 20) {
+	fprintf(stderr, "%d: %s was %s\n", gi, n.c_str(), CharstringUnparser::unparse(*program->glyph(gi)).c_str());
+	fprintf(stderr, "  now %s\n", CharstringUnparser::unparse(receptacle).c_str());
+	fprintf(stderr, "  *** %d.%d: %s\n", 134, 30, CharstringUnparser::unparse(Type1Charstring(receptacle.data_string().substring(134, 30))).c_str());
+    }
+#endif
+    add_glyph(program, gi, receptacle, glyph_definer, errh);
+}
+
+void
+MakeType1CharstringInterp::run(const CharstringProgram *program, Type1Font *output, PermString glyph_definer, ErrorHandler *errh, int nprocs)
+{
+    _output = output;
+    set_hint_replacement_storage(output);
+
+    _glyphs.assign(program->nglyphs(), 0);
+    _subrs.assign(program->nsubrs(), 0);
+    _subr_bias = program->subr_bias();
+    _gsubrs.assign(program->ngsubrs(), 0);
+    _gsubr_bias = program->gsubr_bias();
+
+    // run over the glyphs
+    if (nprocs <= 1 || !run_parallel(program, glyph_definer, errh, nprocs)) {
+	int nglyphs = program->nglyphs();
+	Type1Charstring receptacle;
+	for (int i = 0; i < nglyphs; i++)
+	    convert_glyph(program, i, receptacle, glyph_definer, errh);
+    }
+
+    if (_find_subrs) {
+	RepeatSubrFinder finder(output);
+	finder.run();
+	return;
+    }
+
+    // unify Subrs
+    for (int i = 0; i < _subrs.size(); i++)
+	if (_subrs[i])
+	    _subrs[i]->unify(this);
+
+    for (int i = 0; i < _gsubrs.size(); i++)
+	if (_gsubrs[i])
+	    _gsubrs[i]->unify(this);
+}
+
+
+/*****
+ * parallel conversion
+ **/
+
+// Glyphs convert independently, except that hint replacement subroutines
+// are shared and numbered in order of first use, and that the previous
+// glyph's hints can leak into the next one.  Child processes convert
+// slices of the font using private subroutine numbers; the parent merges
+// their results in glyph order, renumbering hint replacement calls and
+// reconverting each slice's first hint-sensitive glyph itself, so that the
+// result is byte-for-byte what a serial run would produce.  Subroutine
+// unification happens afterwards in the parent.
+
+#if MAKET1FONT_PARALLEL
+namespace {
+
+inline void
+append_u32(StringAccum &sa, uint32_t v)
+{
+    sa.append(reinterpret_cast<const char *>(&v), 4);
+}
+
+inline void
+append_string(StringAccum &sa, const String &s)
+{
+    append_u32(sa, s.length());
+    sa << s;
+}
+
+class SliceReader { public:
+
+    SliceReader(const String &s)	: _s(s), _pos(0), _ok(true) { }
+
+    bool ok() const			{ return _ok; }
+    bool done() const			{ return _ok && _pos == _s.length(); }
+
+    uint32_t u32() {
+	uint32_t v = 0;
+	if (_ok && _s.length() - _pos >= 4) {
+	    memcpy(&v, _s.data() + _pos, 4);
+	    _pos += 4;
+	} else
+	    _ok = false;
+	return v;
+    }
+
+    String string() {
+	uint32_t len = u32();
+	if (_ok && len <= (uint32_t) (_s.length() - _pos)) {
+	    _pos += len;
+	    return _s.substring(_pos - len, len);
+	} else {
+	    _ok = false;
+	    return String();
+	}
+    }
+
+  private:
+
+    String _s;
+    int _pos;
+    bool _ok;
+
+};
+
+// Return the position of the next hint replacement call, "N 4 callsubr"
+// with N >= hr_first, in a Type 1 charstring at or after pos.
+bool
+find_hr_call(const String &cs, int hr_first, int &pos, int &len, int &subrno)
+{
+    const uint8_t *s = cs.udata(), *end = s + cs.length();
+    const uint8_t *p = s + pos;
+    const uint8_t *num0 = 0, *num1 = 0;
+    int val0 = 0, val1 = 0;
+    while (p < end) {
+	const uint8_t *start = p;
+	int v = *p++, val;
+	if (v < 32) {
+	    if (v == Charstring::cEscape)
+		p++;
+	    else if (v == Charstring::cCallsubr && num0 && num1 && val1 == 4
+		     && val0 >= hr_first) {
+		pos = num0 - s;
+		len = num1 - num0;
+		subrno = val0;
+		return true;
+	    }
+	    num0 = num1 = 0;
+	    continue;
+	} else if (v <= 246)
+	    val = v - 139;
+	else if (v <= 250 && p < end)
+	    val = ((v - 247) << 8) + *p++ + 108;
+	else if (v <= 254 && p < end)
+	    val = -((v - 251) << 8) - *p++ - 108;
+	else if (v == 255 && end - p >= 4) {
+	    val = (int32_t) ((p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+	    p += 4;
+	} else
+	    break;
+	num0 = num1, val0 = val1;
+	num1 = start, val1 = val;
+    }
+    return false;
+}
+
+}
+#endif
+
+String
+MakeType1CharstringInterp::run_slice(const CharstringProgram *program, int first, int last)
+{
+    // Record layout: settle glyph, last hints, hint replacement
+    // subroutines, then for each glyph its charstring, flex flags, calls,
+    // callers, and hint replacement calls.
+    StringAccum body;
+#if MAKET1FONT_PARALLEL
+    int hr_first = _output->nsubrs();
+    Vector<CsRef> log;
+    Vector<uint32_t> hr;
+    Type1Charstring receptacle;
+    _caller_log = &log;
+    _settle_glyph = -1;
+
+    for (int i = first; i < last; i++) {
+	_cur_subr = _glyphs[i] = new Subr(CSR_GLYPH | i);
+	_cur_glyph = i;
+	log.clear();
+	Type1CharstringGenInterp::run(program->glyph_context(i), receptacle);
+
+	const String &cs = receptacle.data_string();
+	append_string(body, cs);
+	append_u32(body, flex_flags());
+	append_u32(body, _cur_subr->_calls.size());
+	for (int j = 0; j < _cur_subr->_calls.size(); j++)
+	    append_u32(body, _cur_subr->_calls[j]->_csr);
+	append_u32(body, log.size());
+	for (int j = 0; j < log.size(); j++)
+	    append_u32(body, log[j]);
+
+	hr.clear();
+	int pos = 0, len, subrno;
+	while (had_hr() && find_hr_call(cs, hr_first, pos, len, subrno)) {
+	    hr.push_back(pos);
+	    hr.push_back(len);
+	    hr.push_back(subrno - hr_first);
+	    pos += len;
+	}
+	append_u32(body, hr.size());
+	for (int j = 0; j < hr.size(); j++)
+	    append_u32(body, hr[j]);
+    }
+    _caller_log = 0;
+
+    StringAccum sa;
+    append_u32(sa, _settle_glyph);
+    append_string(sa, last_hints());
+    append_u32(sa, _output->nsubrs() - hr_first);
+    for (int k = hr_first; k < _output->nsubrs(); k++) {
+	Type1Subr *s = _output->subr_x(k);
+	append_string(sa, s ? s->t1cs().data_string() : String());
+    }
+    sa << body;
+    return sa.take_string();
+#else
+    (void) program, (void) first, (void) last;
+    return body.take_string();
+#endif
+}
+
+int
+MakeType1CharstringInterp::hr_subr(const String &hints)
+{
+    for (; _hr_mapped < _output->nsubrs(); _hr_mapped++)
+	if (Type1Subr *s = _output->subr_x(_hr_mapped))
+	    _hr_subrs.insert(s->t1cs().data_string(), _hr_mapped);
+    if (int *subrno = _hr_subrs.findp(hints))
+	return *subrno;
+    int subrno = _output->nsubrs();
+    if (!hints || !_output->set_subr(subrno, Type1Charstring(hints)))
+	return -1;
+    return subrno;
+}
+
+bool
+MakeType1CharstringInterp::merge_slice(const String &result, const CharstringProgram *program, int first, int last, bool apply, PermString glyph_definer, ErrorHandler *errh)
+{
+#if MAKET1FONT_PARALLEL
+    SliceReader r(result);
+    int settle_glyph = r.u32();
+    String settled_hints = r.string();
+    Vector<String> hr_hints;
+    for (uint32_t n = r.u32(); r.ok() && n > 0; n--)
+	hr_hints.push_back(r.string());
+
+    int hr_first = _hr_first;
+    Type1CharstringGen gen(precision());
+    Type1Charstring receptacle;
+    Vector<int> ends, deltas;
+    for (int i = first; i < last && r.ok(); i++) {
+	String cs = r.string();
+	int flags = r.u32();
+	Vector<CsRef> calls;
+	for (uint32_t n = r.u32(); r.ok() && n > 0; n--)
+	    calls.push_back(r.u32());
+	Vector<CsRef> log;
+	for (uint32_t n = r.u32(); r.ok() && n > 0; n--)
+	    log.push_back(r.u32());
+	Vector<uint32_t> hr;
+	for (uint32_t n = r.u32(); r.ok() && n > 0; n--)
+	    hr.push_back(r.u32());
+
+	if (!apply) {
+	    // validate
+	    if (log.size() % 3 != 0 || hr.size() % 3 != 0)
+		return false;
+	    for (int j = 0; j < log.size(); j += 3)
+		if (log[j + 1] > (uint32_t) cs.length()
+		    || log[j + 2] > (uint32_t) cs.length() - log[j + 1])
+		    return false;
+	    for (int j = 0, pos = 0; j < hr.size(); j += 3) {
+		if (hr[j] < (uint32_t) pos || hr[j + 1] > (uint32_t) cs.length() - hr[j]
+		    || hr[j + 2] >= (uint32_t) hr_hints.size())
+		    return false;
+		pos = hr[j] + hr[j + 1];
+	    }
+	    continue;
+	} else if (i == settle_glyph) {
+	    convert_glyph(program, i, receptacle, glyph_definer, errh);
+	    continue;
+	}
+
+	// renumber hint replacement calls
+	ends.clear();
+	deltas.clear();
+	if (hr.size()) {
+	    StringAccum sa;
+	    int pos = 0, delta = 0;
+	    for (int j = 0; j < hr.size(); j += 3) {
+		int subrno = hr_subr(hr_hints[hr[j + 2]]);
+		if (subrno == (int) hr[j + 2] + hr_first)
+		    continue;
+		gen.clear();
+		gen.gen_number(subrno);
+		sa.append(cs.data() + pos, hr[j] - pos);
+		sa.append(gen.data(), gen.length());
+		pos = hr[j] + hr[j + 1];
+		delta += gen.length() - hr[j + 1];
+		ends.push_back(pos);
+		deltas.push_back(delta);
+	    }
+	    if (ends.size()) {
+		sa.append(cs.data() + pos, cs.length() - pos);
+		cs = sa.take_string();
+	    }
+	}
+
+	_cur_subr = _glyphs[i] = new Subr(CSR_GLYPH | i);
+	_cur_glyph = i;
+	for (int j = 0; j < calls.size(); j++)
+	    if (Subr *callee = csr_subr(calls[j], true))
+		_cur_subr->add_call(callee);
+	for (int j = 0; j < log.size(); j += 3)
+	    if (Subr *callee = csr_subr(log[j], true)) {
+		int left = log[j + 1], right = left + log[j + 2];
+		for (int k = ends.size() - 1; k >= 0; k--)
+		    if (ends[k] <= right) {
+			right += deltas[k];
+			break;
+		    }
+		for (int k = ends.size() - 1; k >= 0; k--)
+		    if (ends[k] <= left) {
+			left += deltas[k];
+			break;
+		    }
+		callee->add_caller(_cur_subr, left, right - left);
+	    }
+	report_flex(flags, errh);
+	add_glyph(program, i, Type1Charstring(cs), glyph_definer, errh);
+    }
+
+    if (!r.done())
+	return false;
+    if (apply && settle_glyph >= first && settle_glyph < last)
+	set_last_hints(settled_hints);
+    return true;
+#else
+    (void) result, (void) program, (void) first, (void) last, (void) apply;
+    (void) glyph_definer, (void) errh;
+    return false;
+#endif
+}
+
+bool
+MakeType1CharstringInterp::run_parallel(const CharstringProgram *program, PermString glyph_definer, ErrorHandler *errh, int nprocs)
+{
+#if MAKET1FONT_PARALLEL
+    // Forking costs more than converting a few hundred glyphs, so only
+    // split large fonts.
+    int nglyphs = program->nglyphs();
+    const int min_slice = 256;
+    if (nprocs > nglyphs / min_slice)
+	nprocs = nglyphs / min_slice;
+    if (nprocs <= 1)
+	return false;
+
+    // The parent converts the first slice itself; children convert the
+    // rest and send their results back through pipes.
+    _hr_first = _hr_mapped = _output->nsubrs();
+    Vector<int> fds(nprocs, -1);
+    Vector<pid_t> pids(nprocs, -1);
+    for (int p = 1; p < nprocs; ++p) {
+	int pipefd[2];
+	if (pipe(pipefd) != 0)
+	    break;
+	pid_t child = fork();
+	if (child < 0) {
+	    close(pipefd[0]);
+	    close(pipefd[1]);
+	    break;
+	} else if (child == 0) {
+	    close(pipefd[0]);
+	    String result = run_slice(program, nglyphs * p / nprocs, nglyphs * (p + 1) / nprocs);
+	    bool ok = write_fd_data(pipefd[1], result.data(), result.length());
+	    _exit(ok ? 0 : 1);
+	}
+	close(pipefd[1]);
+	fds[p] = pipefd[0];
+	pids[p] = child;
+    }
+
+    Type1Charstring receptacle;
+    for (int i = 0; i < nglyphs / nprocs; ++i)
+	convert_glyph(program, i, receptacle, glyph_definer, errh);
+
+    // Merge results in glyph order.  Slices whose child failed are
+    // converted here.
+    for (int p = 1; p < nprocs; ++p) {
+	int first = nglyphs * p / nprocs;
+	int last = nglyphs * (p + 1) / nprocs;
+	bool ok = false;
+	if (fds[p] >= 0) {
+	    String result = read_fd_data(fds[p]);
+	    close(fds[p]);
+	    // a failed waitpid (ECHILD if SIGCHLD is ignored) fails the slice
+	    int status = 0;
+	    pid_t w;
+	    while ((w = waitpid(pids[p], &status, 0)) < 0 && errno == EINTR)
+		/* nada */;
+	    ok = w == pids[p] && WIFEXITED(status) && WEXITSTATUS(status) == 0
+		&& merge_slice(result, program, first, last, false, glyph_definer, errh)
+		&& merge_slice(result, program, first, last, true, glyph_definer, errh);
+	}
+	if (!ok)
+	    for (int i = first; i < last; ++i)
+		convert_glyph(program, i, receptacle, glyph_definer, errh);
+    }
+    return true;
+#else
+    (void) program, (void) glyph_definer, (void) errh, (void) nprocs;
+    return false;
+#endif
+}
+
+
+/*****
+ * main
+ **/
+
+static void
+add_number_def(Type1Font *output, int dict, PermString name, const Cff::Font *font, Cff::DictOperator op)
+{
+    double v;
+    if (font->dict_value(op, &v))
+	output->add_definition(dict, Type1Definition::make(name, v, "def"));
+}
+
+static void
+add_delta_def(Type1Font *output, int dict, PermString name, const Cff::Font *font, Cff::DictOperator op)
+{
+    Vector<double> vec;
+    if (font->dict_value(op, vec)) {
+	for (int i = 1; i < vec.size(); i++)
+	    vec[i] += vec[i - 1];
+	StringAccum sa;
+	for (int i = 0; i < vec.size(); i++)
+	    sa << (i ? ' ' : '[') << vec[i];
+	sa << ']';
+	output->add_definition(dict, Type1Definition::make_literal(name, sa.take_string(), (dict == Type1Font::dP ? "|-" : "readonly def")));
+    }
+}
+
+Type1Font *
+create_type1_font(const Cff::Font *font, ErrorHandler *errh, int nprocs, bool find_subrs)
+{
+    String version = font->dict_string(Cff::oVersion);
+    Type1Font *output = Type1Font::skeleton_make(font->font_name(), version);
+    output->skeleton_comments_end();
+    StringAccum sa;
+
+    // FontInfo dictionary
+    if (version)
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("version", version, "readonly def"));
+    if (String s = font->dict_string(Cff::oNotice))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("Notice", s, "readonly def"));
+    if (String s = font->dict_string(Cff::oCopyright))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("Copyright", s, "readonly def"));
+    if (String s = font->dict_string(Cff::oFullName))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("FullName", s, "readonly def"));
+    if (String s = font->dict_string(Cff::oFamilyName))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("FamilyName", s, "readonly def"));
+    if (String s = font->dict_string(Cff::oWeight))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_string("Weight", s, "readonly def"));
+    double v;
+    if (font->dict_value(Cff::oIsFixedPitch, &v))
+	output->add_definition(Type1Font::dFI, Type1Definition::make_literal("isFixedPitch", (v ? "true" : "false"), "def"));
+    add_number_def(output, Type1Font::dFI, "ItalicAngle", font, Cff::oItalicAngle);
+    add_number_def(output, Type1Font::dFI, "UnderlinePosition", font, Cff::oUnderlinePosition);
+    add_number_def(output, Type1Font::dFI, "UnderlineThickness", font, Cff::oUnderlineThickness);
+    output->skeleton_fontinfo_end();
+
+    // Encoding, other font dictionary entries
+    output->add_item(font->type1_encoding_copy());
+    font->dict_value(Cff::oPaintType, &v);
+    output->add_definition(Type1Font::dF, Type1Definition::make("PaintType", v, "def"));
+    output->add_definition(Type1Font::dF, Type1Definition::make("FontType", 1.0, "def"));
+    Vector<double> vec;
+    if (font->dict_value(Cff::oFontMatrix, vec) && vec.size() == 6) {
+	sa << '[' << vec[0] << ' ' << vec[1] << ' ' << vec[2] << ' ' << vec[3] << ' ' << vec[4] << ' ' << vec[5] << ']';
+	output->add_definition(Type1Font::dF, Type1Definition::make_literal("FontMatrix", sa.take_string(), "readonly def"));
+    } else
+	output->add_definition(Type1Font::dF, Type1Definition::make_literal("FontMatrix", "[0.001 0 0 0.001 0 0]", "readonly def"));
+    add_number_def(output, Type1Font::dF, "StrokeWidth", font, Cff::oStrokeWidth);
+    add_number_def(output, Type1Font::dF, "UniqueID", font, Cff::oUniqueID);
+    if (font->dict_value(Cff::oXUID, vec) && vec.size()) {
+	for (int i = 0; i < vec.size(); i++)
+	    sa << (i ? ' ' : '[') << vec[i];
+	sa << ']';
+	output->add_definition(Type1Font::dF, Type1Definition::make_literal("XUID", sa.take_string(), "readonly def"));
+    }
+    if (font->dict_value(Cff::oFontBBox, vec) && vec.size() == 4) {
+	sa << '{' << vec[0] << ' ' << vec[1] << ' ' << vec[2] << ' ' << vec[3] << '}';
+	output->add_definition(Type1Font::dF, Type1Definition::make_literal("FontBBox", sa.take_string(), "readonly def"));
+    } else
+	output->add_definition(Type1Font::dF, Type1Definition::make_literal("FontBBox", "{0 0 0 0}", "readonly def"));
+    output->skeleton_fontdict_end();
+
+    // Private dictionary
+    add_delta_def(output, Type1Font::dP, "BlueValues", font, Cff::oBlueValues);
+    add_delta_def(output, Type1Font::dP, "OtherBlues", font, Cff::oOtherBlues);
+    add_delta_def(output, Type1Font::dP, "FamilyBlues", font, Cff::oFamilyBlues);
+    add_delta_def(output, Type1Font::dP, "FamilyOtherBlues", font, Cff::oFamilyOtherBlues);
+    add_number_def(output, Type1Font::dP, "BlueScale", font, Cff::oBlueScale);
+    add_number_def(output, Type1Font::dP, "BlueShift", font, Cff::oBlueShift);
+    add_number_def(output, Type1Font::dP, "BlueFuzz", font, Cff::oBlueFuzz);
+    if (font->dict_value(Cff::oStdHW, &v))
+	output->add_definition(Type1Font::dP, Type1Definition::make_literal("StdHW", String("[") + String(v) + "]", "|-"));
+    if (font->dict_value(Cff::oStdVW, &v))
+	output->add_definition(Type1Font::dP, Type1Definition::make_literal("StdVW", String("[") + String(v) + "]", "|-"));
+    add_delta_def(output, Type1Font::dP, "StemSnapH", font, Cff::oStemSnapH);
+    add_delta_def(output, Type1Font::dP, "StemSnapV", font, Cff::oStemSnapV);
+    if (font->dict_value(Cff::oForceBold, &v))
+	output->add_definition(Type1Font::dP, Type1Definition::make_literal("ForceBold", (v ? "true" : "false"), "def"));
+    add_number_def(output, Type1Font::dP, "LanguageGroup", font, Cff::oLanguageGroup);
+    add_number_def(output, Type1Font::dP, "ExpansionFactor", font, Cff::oExpansionFactor);
+    add_number_def(output, Type1Font::dP, "UniqueID", font, Cff::oUniqueID);
+    output->add_definition(Type1Font::dP, Type1Definition::make_literal("MinFeature", "{16 16}", "|-"));
+    output->add_definition(Type1Font::dP, Type1Definition::make_literal("password", "5839", "def"));
+    output->add_definition(Type1Font::dP, Type1Definition::make_literal("lenIV", "0", "def"));
+    output->skeleton_private_end();
+    output->skeleton_common_subrs();
+
+    // add glyphs
+    MakeType1CharstringInterp maker(5);
+    maker.set_find_subrs(find_subrs);
+    maker.run(font, output, " |-", errh, nprocs);
+
+    return output;
+}
+
+}
+
+#include <lcdf/vector.cc>
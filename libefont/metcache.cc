@@ -0,0 +1,411 @@
+// -*- related-file-name: "../include/efont/metcache.hh" -*-
+
+/* metcache.{cc,hh} -- compiled font metrics files
+ *
+ * Copyright (c) 2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/metcache.hh>
+#include <efont/afm.hh>
+#include <lcdf/filename.hh>
+#include <lcdf/inttypes.h>
+#include <lcdf/mapfile.hh>
+#include <lcdf/md5.h>
+#include <lcdf/straccum.hh>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+namespace Efont {
+
+// A compiled metrics file is a header line, the size, inode, and
+// modification time (to the nanosecond where available) of the AFM file it
+// was compiled from, and then the Metrics fields in
+// order: strings, glyph names and codes, dimension arrays, and the pair
+// program.  Numbers are big-endian 32-bit words; doubles are stored as their
+// exact bits.  A file with a different header, or whose source has changed,
+// is ignored.
+
+static const char cache_header[] = "efont compiled metrics 2 " VERSION "\n";
+
+static void
+append_u32(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(4));
+    s[0] = x >> 24;
+    s[1] = x >> 16;
+    s[2] = x >> 8;
+    s[3] = x;
+}
+
+static inline bool
+little_endian()
+{
+    uint32_t one = 1;
+    return *reinterpret_cast<uint8_t *>(&one) == 1;
+}
+
+static void
+append_double(StringAccum &sa, double d)
+{
+    uint32_t x[2];
+    memcpy(x, &d, sizeof(d));
+    append_u32(sa, x[little_endian()]);
+    append_u32(sa, x[!little_endian()]);
+}
+
+static void
+append_string(StringAccum &sa, PermString s)
+{
+    append_u32(sa, s.length());
+    sa.append(s.c_str(), s.length());
+}
+
+static void
+append_doubles(StringAccum &sa, const Vector<double> &v)
+{
+    append_u32(sa, v.size());
+    for (int i = 0; i < v.size(); i++)
+        append_double(sa, v[i]);
+}
+
+static void
+append_source_stat(StringAccum &sa, const struct stat &s)
+{
+    // shift twice so 32-bit off_t and time_t don't overflow the shift
+    append_u32(sa, (uint32_t) ((s.st_size >> 16) >> 16));
+    append_u32(sa, (uint32_t) s.st_size);
+    append_u32(sa, (uint32_t) ((s.st_mtime >> 16) >> 16));
+    append_u32(sa, (uint32_t) s.st_mtime);
+    // a file rewritten within the same second at the same size differs in
+    // the sub-second time or, if replaced by rename, in the inode
+#if HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+    append_u32(sa, (uint32_t) s.st_mtim.tv_nsec);
+#elif HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC
+    append_u32(sa, (uint32_t) s.st_mtimespec.tv_nsec);
+#else
+    append_u32(sa, 0);
+#endif
+    append_u32(sa, (uint32_t) ((s.st_ino >> 16) >> 16));
+    append_u32(sa, (uint32_t) s.st_ino);
+}
+
+
+namespace {
+class CacheReader { public:
+
+    CacheReader(const String &data, int pos)
+        : _s(data.udata() + pos), _end(data.udata() + data.length()),
+          _ok(true) {
+    }
+
+    bool ok() const             { return _ok; }
+    bool at_end() const         { return _s == _end; }
+    void fail()                 { _ok = false; }
+
+    inline bool check(uint32_t n, uint32_t unit);
+    inline uint32_t u32();
+    inline int index(int bound);
+    double dbl();
+    PermString str();
+    void doubles(Vector<double> &);
+
+  private:
+
+    const uint8_t *_s;
+    const uint8_t *_end;
+    bool _ok;
+
+};
+
+inline bool
+CacheReader::check(uint32_t n, uint32_t unit)
+{
+    if (_ok && (uint32_t) (_end - _s) / unit < n)
+        _ok = false;
+    return _ok;
+}
+
+inline uint32_t
+CacheReader::u32()
+{
+    if (!check(1, 4))
+        return 0;
+    uint32_t x = (_s[0] << 24) | (_s[1] << 16) | (_s[2] << 8) | _s[3];
+    _s += 4;
+    return x;
+}
+
+// Read a glyph or op index, which must be -1 or less than bound.
+inline int
+CacheReader::index(int bound)
+{
+    int x = (int) u32();
+    if (x < -1 || x >= bound)
+        _ok = false;
+    return x;
+}
+
+double
+CacheReader::dbl()
+{
+    uint32_t x[2];
+    x[little_endian()] = u32();
+    x[!little_endian()] = u32();
+    double d;
+    memcpy(&d, x, sizeof(d));
+    return d;
+}
+
+PermString
+CacheReader::str()
+{
+    uint32_t len = u32();
+    if (!check(len, 1))
+        return PermString();
+    PermString s((const char *) _s, len);
+    _s += len;
+    return s;
+}
+
+void
+CacheReader::doubles(Vector<double> &v)
+{
+    uint32_t n = u32();
+    if (!check(n, 8))
+        return;
+    v.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+        v[i] = dbl();
+}
+}
+
+
+String
+MetricsCache::cache_filename(const Filename &source, const String &directory)
+{
+    if (!directory)
+        return source.path() + ".cache";
+
+    // name the file after the source's absolute path, so AFM files with the
+    // same name in different directories don't collide
+    String path = source.path();
+#ifdef HAVE_UNISTD_H
+    if (path && path[0] != '/') {
+        char buf[BUFSIZ];
+        if (getcwd(buf, BUFSIZ))
+            path = String(buf) + "/" + path;
+    }
+#endif
+    MD5_CONTEXT md5;
+    md5_init(&md5);
+    md5_update(&md5, path.udata(), path.length());
+    char text_digest[MD5_TEXT_DIGEST_SIZE + 1];
+    md5_final_text(text_digest, &md5);
+
+    StringAccum sa;
+    sa << directory;
+    if (directory.back() != '/')
+        sa << '/';
+    sa << source.name() << '-' << text_digest << ".cache";
+    return sa.take_string();
+}
+
+
+Metrics *
+MetricsCache::read(const String &filename, const Filename &source)
+{
+    struct stat s;
+    if (stat(source.path().c_str(), &s) < 0)
+        return 0;
+
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (!f)
+        return 0;
+    String data = read_file_data(f);
+    fclose(f);
+
+    int hlen = sizeof(cache_header) - 1;
+    if (data.length() < hlen || memcmp(data.data(), cache_header, hlen) != 0)
+        return 0;
+
+    StringAccum stat_sa;
+    append_source_stat(stat_sa, s);
+    if (data.length() < hlen + stat_sa.length()
+        || memcmp(data.data() + hlen, stat_sa.data(), stat_sa.length()) != 0)
+        return 0;
+
+    CacheReader r(data, hlen + stat_sa.length());
+    Metrics *m = new Metrics;
+    m->_font_name = r.str();
+    m->_family = r.str();
+    m->_full_name = r.str();
+    m->_weight = r.str();
+    m->_version = r.str();
+
+    AfmMetricsXt *afm_xt = 0;
+    if (r.u32()) {
+        afm_xt = new AfmMetricsXt;
+        m->add_xt(afm_xt);
+        afm_xt->notice = r.str();
+        afm_xt->encoding_scheme = r.str();
+        uint32_t ncomments = r.u32();
+        for (uint32_t i = 0; r.ok() && i < ncomments; i++)
+            afm_xt->opening_comments.push_back(r.str());
+    }
+
+    m->_scale = r.dbl();
+
+    uint32_t nglyphs = r.u32(), capacity = r.u32();
+    if (r.check(capacity, 40) && nglyphs <= capacity) {
+        m->reserve_glyphs(capacity);
+        for (uint32_t gi = 0; r.ok() && gi < nglyphs; gi++)
+            m->add_glyph(r.str());
+        for (uint32_t gi = 0; r.ok() && gi < nglyphs; gi++) {
+            int c = r.index(256);
+            if (c >= 0 && r.ok())
+                m->set_code(gi, c);
+        }
+    } else
+        r.fail();
+
+    r.doubles(m->_fdv);
+    r.doubles(m->_wdv);
+    r.doubles(m->_lfv);
+    r.doubles(m->_rtv);
+    r.doubles(m->_tpv);
+    r.doubles(m->_btv);
+    r.doubles(m->_kernv);
+    if (m->_fdv.size() != fdLast || m->_wdv.size() != (int) capacity
+        || m->_lfv.size() != (int) capacity || m->_rtv.size() != (int) capacity
+        || m->_tpv.size() != (int) capacity || m->_btv.size() != (int) capacity)
+        r.fail();
+
+    PairProgram &pairp = m->_pairp;
+    pairp._reversed = r.u32() != 0;
+    uint32_t nleft = r.u32(), nops = r.u32();
+    if (r.check(nleft, 4) && r.check(nops, 20) && nleft >= nglyphs) {
+        pairp._left_map.resize(nleft);
+        for (uint32_t i = 0; i < nleft; i++)
+            pairp._left_map[i] = r.index(nops);
+        pairp._op.resize(nops, PairOp(0, 0, opNoop, -1));
+        for (uint32_t i = 0; r.ok() && i < nops; i++) {
+            PairOp &op = pairp._op[i];
+            op._left = r.index(nglyphs);
+            op._right = r.index(nglyphs);
+            op._result = (int) r.u32();
+            op._val = (int) r.u32();
+            op._next_left = r.index(nops);
+            if (op.is_kern() ? op._val >= m->_kernv.size()
+                : op.is_lig() && (op._result < 0 || op._result >= (int) nglyphs))
+                r.fail();
+        }
+    }
+
+    if (!r.ok() || !r.at_end()) {
+        delete m;
+        return 0;
+    }
+    return m;
+}
+
+
+bool
+MetricsCache::write(const Metrics *m, const String &filename,
+                    const Filename &source)
+{
+    struct stat s;
+    if (stat(source.path().c_str(), &s) < 0)
+        return false;
+
+    StringAccum sa;
+    sa << cache_header;
+    append_source_stat(sa, s);
+
+    append_string(sa, m->_font_name);
+    append_string(sa, m->_family);
+    append_string(sa, m->_full_name);
+    append_string(sa, m->_weight);
+    append_string(sa, m->_version);
+
+    const AfmMetricsXt *afm_xt = (const AfmMetricsXt *) m->find_xt("AFM");
+    append_u32(sa, afm_xt != 0);
+    if (afm_xt) {
+        append_string(sa, afm_xt->notice);
+        append_string(sa, afm_xt->encoding_scheme);
+        append_u32(sa, afm_xt->opening_comments.size());
+        for (int i = 0; i < afm_xt->opening_comments.size(); i++)
+            append_string(sa, afm_xt->opening_comments[i]);
+    }
+
+    append_double(sa, m->_scale);
+
+    append_u32(sa, m->nglyphs());
+    append_u32(sa, m->_wdv.size());
+    for (int gi = 0; gi < m->nglyphs(); gi++)
+        append_string(sa, m->_names[gi]);
+    for (int gi = 0; gi < m->nglyphs(); gi++)
+        append_u32(sa, m->code(gi));
+
+    append_doubles(sa, m->_fdv);
+    append_doubles(sa, m->_wdv);
+    append_doubles(sa, m->_lfv);
+    append_doubles(sa, m->_rtv);
+    append_doubles(sa, m->_tpv);
+    append_doubles(sa, m->_btv);
+    append_doubles(sa, m->_kernv);
+
+    const PairProgram &pairp = m->_pairp;
+    append_u32(sa, pairp._reversed);
+    append_u32(sa, pairp._left_map.size());
+    append_u32(sa, pairp._op.size());
+    for (int i = 0; i < pairp._left_map.size(); i++)
+        append_u32(sa, pairp._left_map[i]);
+    for (int i = 0; i < pairp._op.size(); i++) {
+        const PairOp &op = pairp._op[i];
+        append_u32(sa, op._left);
+        append_u32(sa, op._right);
+        append_u32(sa, op._result);
+        append_u32(sa, op._val);
+        append_u32(sa, op._next_left);
+    }
+
+    // write a temporary file and rename it into place, so readers never
+    // see a partial file
+    StringAccum tmp_sa;
+    tmp_sa << filename << '.';
+#ifdef HAVE_UNISTD_H
+    tmp_sa << (long) getpid();
+#endif
+    tmp_sa << ".tmp";
+    String tmp_filename = tmp_sa.take_string();
+
+    FILE *f = fopen(tmp_filename.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(sa.data(), 1, sa.length(), f) == (size_t) sa.length()
+        && !ferror(f);
+    if (fclose(f) != 0)
+        ok = false;
+    if (!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        remove(tmp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
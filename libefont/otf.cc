@@ -31,23 +31,62 @@ namespace Efont { namespace OpenType {
 
 Vector<PermString> debug_glyph_names;
 
-Font::Font(const String& s, ErrorHandler* errh)
-    : _str(s), _units_per_em(0) {
+Font::Font(const String& s, ErrorHandler* errh, int face)
+    : _str(s), _face(face), _offset(0), _units_per_em(0) {
     _str.align(4);
     _error = parse_header(errh ? errh : ErrorHandler::silent_handler());
 }
 
+bool
+Font::is_collection(const String& str)
+{
+    return str.length() >= COLLECTION_HEADER_SIZE
+        && memcmp(str.data(), "ttcf", 4) == 0;
+}
+
+int
+Font::nfaces(const String& str)
+{
+    if (!is_collection(str))
+        return 1;
+    uint32_t n = Data::u32(str.udata() + 8);
+    if ((uint32_t) (str.length() - COLLECTION_HEADER_SIZE) / 4 < n)
+        return 0;
+    return n;
+}
+
 int
 Font::parse_header(ErrorHandler *errh)
 {
+    // COLLECTION HEADER FORMAT:
+    // Tag      'ttcf'
+    // Fixed    version
+    // ULONG    numFonts
+    // ULONG    offsetTable[numFonts]
+    // Table offsets in a collection are relative to the start of the file,
+    // so faces share the file's data, including any tables they share.
+    int len = length();
+    const uint8_t *data = this->data();
+    if (is_collection(_str)) {
+        int nf = nfaces(_str);
+        if (nf <= 0)
+            return errh->error("font collection corrupted (too small)"), -EFAULT;
+        if (_face < 0 || _face >= nf)
+            return errh->error("font collection has no face %d (it has %d)", _face, nf), -ERANGE;
+        _offset = Data::u32(data + COLLECTION_HEADER_SIZE + 4 * _face);
+        if (_offset % 4 != 0 || _offset > (uint32_t) len)
+            return errh->error("font collection face %d out of range", _face), -EFAULT;
+    } else if (_face != 0)
+        return errh->error("not a font collection"), -ERANGE;
+
     // HEADER FORMAT:
     // Fixed    sfnt version
     // USHORT   numTables
     // USHORT   searchRange
     // USHORT   entrySelector
     // USHORT   rangeShift
-    int len = length();
-    const uint8_t *data = this->data();
+    data += _offset;
+    len -= _offset;
     if (HEADER_SIZE > len)
         return errh->error("OTF file corrupted (too small)"), -EFAULT;
     if ((data[0] != 'O' || data[1] != 'T' || data[2] != 'T' || data[3] != 'O')
@@ -65,6 +104,9 @@ Font::parse_header(ErrorHandler *errh)
     // ULONG    offset
     // ULONG    length
     uint32_t last_tag = 0U;
+    _tags.reserve(ntables);
+    _checksums.reserve(ntables);
+    _tables.reserve(ntables);
     for (int i = 0; i < ntables; i++) {
         int loc = HEADER_SIZE + TABLE_DIR_ENTRY_SIZE * i;
         uint32_t tag = Data::u32_aligned(data + loc);
@@ -72,12 +114,15 @@ Font::parse_header(ErrorHandler *errh)
         uint32_t length = Data::u32_aligned(data + loc + 12);
         if (tag <= last_tag)
             return errh->error("tags out of order"), -EINVAL;
-        if (offset + length > (uint32_t) len)
+        if (offset + length > (uint32_t) _str.length())
             return errh->error("OTF data for %<%s%> out of range", Tag(tag).text().c_str()), -EFAULT;
         if (Tag::head_tag() == tag) {
             Head head(_str.substring(offset, length));
             _units_per_em = head.units_per_em();
         }
+        _tags.push_back(tag);
+        _checksums.push_back(Data::u32_aligned(data + loc + 4));
+        _tables.push_back(_str.substring(offset, length));
         last_tag = tag;
     }
 
@@ -92,16 +137,14 @@ Font::check_checksums(ErrorHandler *errh) const
     int nt = ntables();
     bool ok = true;
     for (int i = 0; i < nt; i++) {
-        const uint8_t *entry = data() + HEADER_SIZE + TABLE_DIR_ENTRY_SIZE * i;
-        String tbl = _str.substring(Data::u32_aligned(entry + 8),
-                                    Data::u32_aligned(entry + 12));
+        const String &tbl = _tables[i];
         uint32_t sum = checksum(tbl);
-        if (Data::u32_aligned(entry) == 0x68656164      // 'head'
+        if (_tags[i] == 0x68656164      // 'head'
             && tbl.length() >= 12)
-            sum -= Data::u32_aligned(tbl.udata() + 8);
-        if (sum != Data::u32_aligned(entry + 4)) {
+            sum -= Data::u32(tbl.udata() + 8);
+        if (sum != _checksums[i]) {
             if (errh)
-                errh->error("table %<%s%> checksum error: %x vs. %x", Tag(Data::u32_aligned(entry)).text().c_str(), sum, Data::u32_aligned(entry + 4));
+                errh->error("table %<%s%> checksum error: %x vs. %x", Tag(_tags[i]).text().c_str(), sum, _checksums[i]);
             ok = false;
         }
     }
@@ -114,40 +157,43 @@ Font::ntables() const
     if (error() < 0)
         return 0;
     else
-        return Data::u16_aligned(data() + 4);
+        return _tags.size();
+}
+
+inline int
+Font::table_index(Tag tag) const
+{
+    // branch-free binary search over the sorted tags
+    if (error() < 0 || _tags.size() == 0)
+        return -1;
+    const uint32_t *base = _tags.begin();
+    uint32_t t = tag.value();
+    for (int n = _tags.size(); n > 1; ) {
+        int half = n / 2;
+        base = (base[half] <= t ? base + half : base);
+        n -= half;
+    }
+    return (*base == t ? base - _tags.begin() : -1);
 }
 
 String
 Font::table(Tag tag) const
 {
-    if (error() < 0)
-        return String();
-    const uint8_t *entry = tag.table_entry(data() + HEADER_SIZE, Data::u16_aligned(data() + 4), TABLE_DIR_ENTRY_SIZE);
-    if (entry)
-        return _str.substring(Data::u32_aligned(entry + 8), Data::u32_aligned(entry + 12));
-    else
-        return String();
+    int i = table_index(tag);
+    return (i >= 0 ? _tables[i] : String());
 }
 
 bool
 Font::has_table(Tag tag) const
 {
-    const uint8_t *entry = 0;
-    if (error() >= 0)
-        entry = tag.table_entry(data() + HEADER_SIZE, Data::u16_aligned(data() + 4), TABLE_DIR_ENTRY_SIZE);
-    return entry != 0;
+    return table_index(tag) >= 0;
 }
 
 uint32_t
 Font::table_checksum(Tag tag) const
 {
-    if (error() < 0)
-        return 0;
-    const uint8_t *entry = tag.table_entry(data() + HEADER_SIZE, Data::u16_aligned(data() + 4), TABLE_DIR_ENTRY_SIZE);
-    if (entry)
-        return Data::u32_aligned(entry + 4);
-    else
-        return 0;
+    int i = table_index(tag);
+    return (i >= 0 ? _checksums[i] : 0);
 }
 
 Tag
@@ -156,7 +202,7 @@ Font::table_tag(int i) const
     if (error() < 0 || i < 0 || i >= ntables())
         return Tag();
     else
-        return Tag(Data::u32_aligned(data() + HEADER_SIZE + TABLE_DIR_ENTRY_SIZE * i));
+        return Tag(_tags[i]);
 }
 
 uint32_t
@@ -764,29 +810,85 @@ Coverage::Coverage(Glyph first, Glyph last) throw ()
     }
 }
 
+static inline int
+popcount64(uint64_t x)
+{
+#if defined(__GNUC__) && (__GNUC__ >= 4)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline int
+ctz64(uint64_t x)
+{
+    // x must be nonzero
+#if defined(__GNUC__) && (__GNUC__ >= 4)
+    return __builtin_ctzll(x);
+#else
+    return popcount64((x & -x) - 1);
+#endif
+}
+
+inline int
+Coverage::bitset_nwords(const uint8_t *data)
+{
+    return Data::u16_aligned(data + 2);
+}
+
+inline int
+Coverage::bitset_words_offset(int nwords)
+{
+    return BITSET_HEADERSIZE + ((nwords * 4 + 7) & ~7);
+}
+
+uint64_t *
+Coverage::make_bitset(int nwords)
+{
+    int woff = bitset_words_offset(nwords);
+    _str = String::make_uninitialized(woff + nwords * 8);
+    _str.align(8);
+    uint8_t *data = _str.mutable_udata();
+    memset(data, 0, woff + nwords * 8);
+    data[1] = T_X_BITSET;
+    data[2] = nwords >> 8;
+    data[3] = nwords & 255;
+    return reinterpret_cast<uint64_t *>(data + woff);
+}
+
+void
+Coverage::finish_bitset()
+{
+    // fill in the rank of each word and the total count
+    uint8_t *data = _str.mutable_udata();
+    int nwords = bitset_nwords(data);
+    uint32_t *ranks = reinterpret_cast<uint32_t *>(data + BITSET_HEADERSIZE);
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(data + bitset_words_offset(nwords));
+    uint32_t n = 0;
+    for (int i = 0; i < nwords; ++i) {
+        ranks[i] = n;
+        n += popcount64(words[i]);
+    }
+    n = htonl(n);
+    memcpy(data + 4, &n, 4);
+}
+
 Coverage::Coverage(const Vector<bool> &gmap) throw ()
 {
     int end = gmap.size();
     while (end > 0 && !gmap[end - 1])
         --end;
     if (end > 0) {
-        _str = String::make_uninitialized(8 + end);
-        _str.align(4);
-        uint8_t *data = _str.mutable_udata();
-        memset(data, 0, 8 + end);
-        data[1] = 3;
-
-        uint32_t n = 0;
+        uint64_t *words = make_bitset((end + 63) >> 6);
         const bool *it = gmap.begin();
-        data += 8;
-        for (int i = 0; i < end; ++i, ++it, ++data)
-            if (*it) {
-                *data = 1;
-                ++n;
-            }
-
-        n = htonl(n);
-        memcpy(_str.mutable_udata() + 4, &n, 4);
+        for (int i = 0; i < end; ++i, ++it)
+            if (*it)
+                words[i >> 6] |= (uint64_t) 1 << (i & 63);
+        finish_bitset();
     }
 }
 
@@ -854,7 +956,7 @@ Coverage::size() const throw ()
     else if (data[1] == T_RANGES) {
         data += _str.length() - RANGES_RECSIZE;
         return Data::u16_aligned(data + 4) + Data::u16_aligned(data + 2) - Data::u16_aligned(data) + 1;
-    } else if (data[1] == T_X_BYTEMAP)
+    } else if (data[1] == T_X_BITSET)
         return Data::u32_aligned(data + 4);
     else
         return -1;
@@ -896,11 +998,16 @@ Coverage::coverage_index(Glyph g) const throw ()
                 l = m + 1;
         }
         return -1;
-    } else if (data[1] == T_X_BYTEMAP) {
-        if (g >= 0 && g < _str.length() - 8 && data[8 + g])
-            return g;
-        else
+    } else if (data[1] == T_X_BITSET) {
+        // rank of the word plus the bits set below g in it
+        if (g < 0 || (g >> 6) >= count)
             return -1;
+        const uint64_t *words = reinterpret_cast<const uint64_t *>(data + bitset_words_offset(count));
+        uint64_t w = words[g >> 6], bit = (uint64_t) 1 << (g & 63);
+        if (!(w & bit))
+            return -1;
+        const uint32_t *ranks = reinterpret_cast<const uint32_t *>(data + BITSET_HEADERSIZE);
+        return ranks[g >> 6] + popcount64(w & (bit - 1));
     } else
         return -1;
 }
@@ -930,6 +1037,23 @@ Coverage::operator[](int cindex) const throw ()
                 l = m + 1;
         }
         return 0;
+    } else if (data[1] == T_X_BITSET) {
+        if (cindex >= (int) Data::u32_aligned(data + 4))
+            return 0;
+        // find the last word whose rank is <= cindex, then select in it
+        const uint32_t *ranks = reinterpret_cast<const uint32_t *>(data + BITSET_HEADERSIZE);
+        int l = 0, r = count;
+        while (r - l > 1) {
+            int m = l + (r - l) / 2;
+            if (ranks[m] <= (uint32_t) cindex)
+                l = m;
+            else
+                r = m;
+        }
+        uint64_t w = reinterpret_cast<const uint64_t *>(data + bitset_words_offset(count))[l];
+        for (int n = cindex - ranks[l]; n > 0; --n)
+            w &= w - 1;
+        return (l << 6) + ctz64(w);
     } else
         return 0;
 }
@@ -940,7 +1064,12 @@ Coverage::unparse(StringAccum &sa) const throw ()
     const uint8_t *data = _str.udata();
     if (_str.length() == 0)
         sa << "@*#!";
-    else if (data[1] == T_LIST) {
+    else if (data[1] == T_X_BITSET) {
+        for (iterator i = begin(); i; i++) {
+            if (i.coverage_index()) sa << ',';
+            sa << *i;
+        }
+    } else if (data[1] == T_LIST) {
         int count = Data::u16_aligned(data + 2);
         for (int i = 0; i < count; i++) {
             if (i) sa << ',';
@@ -968,28 +1097,46 @@ Coverage::unparse() const throw ()
 Coverage
 operator&(const Coverage &a, const Coverage &b)
 {
-    StringAccum sa;
-    sa << '\000' << '\001' << '\000' << '\000';
+    if (a.has_fast_covers() && !b.has_fast_covers())
+        return b & a;
 
     if (b.has_fast_covers()) {
-        for (Coverage::iterator ai = a.begin(); ai; ++ai)
-            if (b.covers(*ai)) {
-                uint16_t x = *ai;
-                sa << (char)(x >> 8) << (char)(x & 0xFF);
+        // intersect into a bitset the size of b's
+        const uint8_t *bdata = b._str.udata();
+        int nwords = Coverage::bitset_nwords(bdata);
+        const uint64_t *bwords = reinterpret_cast<const uint64_t *>(bdata + Coverage::bitset_words_offset(nwords));
+        Coverage result;
+        uint64_t *words = result.make_bitset(nwords);
+        if (a.has_fast_covers()) {
+            const uint8_t *adata = a._str.udata();
+            int anwords = Coverage::bitset_nwords(adata);
+            const uint64_t *awords = reinterpret_cast<const uint64_t *>(adata + Coverage::bitset_words_offset(anwords));
+            for (int i = 0; i < nwords && i < anwords; ++i)
+                words[i] = awords[i] & bwords[i];
+        } else {
+            for (Coverage::iterator ai = a.begin(); ai; ++ai) {
+                Glyph g = *ai;
+                if ((g >> 6) >= nwords)
+                    break;
+                words[g >> 6] |= bwords[g >> 6] & ((uint64_t) 1 << (g & 63));
             }
-
-    } else {
-        Coverage::iterator ai = a.begin(), bi = b.begin();
-        while (ai && bi) {
-            if (*ai < *bi)
-                ai.forward_to(*bi);
-            else if (*ai == *bi) {
-                uint16_t x = *ai;
-                sa << (char)(x >> 8) << (char)(x & 0xFF);
-                ai++, bi++;
-            } else
-                bi.forward_to(*ai);
         }
+        result.finish_bitset();
+        return result;
+    }
+
+    StringAccum sa;
+    sa << '\000' << '\001' << '\000' << '\000';
+    Coverage::iterator ai = a.begin(), bi = b.begin();
+    while (ai && bi) {
+        if (*ai < *bi)
+            ai.forward_to(*bi);
+        else if (*ai == *bi) {
+            uint16_t x = *ai;
+            sa << (char)(x >> 8) << (char)(x & 0xFF);
+            ai++, bi++;
+        } else
+            bi.forward_to(*ai);
     }
 
     int n = (sa.length() - 4) / 2;
@@ -1001,6 +1148,23 @@ operator&(const Coverage &a, const Coverage &b)
 bool
 operator<=(const Coverage &a, const Coverage &b)
 {
+    if (a.has_fast_covers() && b.has_fast_covers()) {
+        const uint8_t *adata = a._str.udata(), *bdata = b._str.udata();
+        int anwords = Coverage::bitset_nwords(adata);
+        int bnwords = Coverage::bitset_nwords(bdata);
+        const uint64_t *awords = reinterpret_cast<const uint64_t *>(adata + Coverage::bitset_words_offset(anwords));
+        const uint64_t *bwords = reinterpret_cast<const uint64_t *>(bdata + Coverage::bitset_words_offset(bnwords));
+        for (int i = 0; i < anwords; ++i)
+            if (awords[i] & ~(i < bnwords ? bwords[i] : 0))
+                return false;
+        return true;
+    } else if (b.has_fast_covers()) {
+        for (Coverage::iterator ai = a.begin(); ai; ++ai)
+            if (!b.covers(*ai))
+                return false;
+        return true;
+    }
+
     Coverage::iterator ai = a.begin(), bi = b.begin();
     while (ai && bi) {
         if (*ai != *bi && !bi.forward_to(*ai))
@@ -1038,10 +1202,11 @@ Coverage::iterator::iterator(const String &str, bool is_end)
     case T_RANGES:
         _str = _str.substring(0, HEADERSIZE + n*RANGES_RECSIZE);
         goto normal_pos_setting;
-    case T_X_BYTEMAP:
-        for (_pos = 8; _pos < _str.length() && !data[_pos]; ++_pos)
-            /* do nothing */;
-        _value = _pos >= _str.length() ? 0 : _pos - 8;
+    case T_X_BITSET:
+        _pos = is_end ? _str.length() : bitset_words_offset(n);
+        _value = 0;
+        if (_pos < _str.length())
+            bitset_scan(*reinterpret_cast<const uint64_t *>(data + _pos));
         break;
     default:
         _str = String();
@@ -1060,8 +1225,30 @@ Coverage::iterator::coverage_index() const
         return (_pos - HEADERSIZE) / LIST_RECSIZE;
     else if (data[1] == T_RANGES)
         return Data::u16_aligned(data + _pos + 4) + _value - Data::u16_aligned(data + _pos);
-    else
-        return _pos - 8;
+    else {
+        const uint32_t *ranks = reinterpret_cast<const uint32_t *>(data + BITSET_HEADERSIZE);
+        uint64_t w = *reinterpret_cast<const uint64_t *>(data + _pos);
+        return ranks[_value >> 6] + popcount64(w & (((uint64_t) 1 << (_value & 63)) - 1));
+    }
+}
+
+void
+Coverage::iterator::bitset_scan(uint64_t bits)
+{
+    // _pos points at a word, and bits holds the part of that word at or
+    // after the current position; move to the next set bit
+    const uint8_t *data = _str.udata();
+    int len = _str.length();
+    while (!bits) {
+        _pos += 8;
+        if (_pos >= len) {
+            _value = 0;
+            return;
+        }
+        bits = *reinterpret_cast<const uint64_t *>(data + _pos);
+    }
+    int woff = bitset_words_offset(bitset_nwords(data));
+    _value = ((_pos - woff) << 3) + ctz64(bits);
 }
 
 void
@@ -1081,12 +1268,13 @@ Coverage::iterator::operator++(int)
     case T_RANGES:
         _pos += RANGES_RECSIZE;
         goto normal_pos_setting;
-    case T_X_BYTEMAP:
-        for (++_pos; _pos < len && !data[_pos]; ++_pos)
-            /* do nothing */;
-        _value = _pos >= len ? 0 : _pos - 8;
+    case T_X_BITSET: {
+        int b = _value & 63;
+        uint64_t w = *reinterpret_cast<const uint64_t *>(data + _pos);
+        bitset_scan(b == 63 ? 0 : w & ~(((uint64_t) 2 << b) - 1));
         break;
     }
+    }
 }
 
 bool
@@ -1160,12 +1348,15 @@ Coverage::iterator::forward_to(Glyph find)
         _pos = HEADERSIZE + l * LIST_RECSIZE;
         _value = (_pos >= _str.length() ? 0 : Data::u16_aligned(data - HEADERSIZE + _pos));
 
-    } else if (data[1] == T_X_BYTEMAP) {
-        _pos = 8 + find;
-        while (_pos < _str.length() && !data[_pos])
-            ++_pos;
-        _pos = _pos >= _str.length() ? _str.length() : _pos;
-        _value = _pos >= _str.length() ? 0 : _pos - 8;
+    } else if (data[1] == T_X_BITSET) {
+        _pos = bitset_words_offset(bitset_nwords(data)) + (find >> 6) * 8;
+        if (_pos >= _str.length()) {
+            _pos = _str.length();
+            _value = 0;
+        } else {
+            uint64_t w = *reinterpret_cast<const uint64_t *>(data + _pos);
+            bitset_scan(w & ~(((uint64_t) 1 << (find & 63)) - 1));
+        }
     }
 
     return find == _value;
@@ -1186,51 +1377,210 @@ GlyphSet::GlyphSet(const GlyphSet &o)
 {
     for (int i = 0; i < VLEN; i++)
         if (o._v[i]) {
-            _v[i] = new uint32_t[VULEN];
-            memcpy(_v[i], o._v[i], sizeof(uint32_t) * VULEN);
+            _v[i] = new uint64_t[PAGEWORDS];
+            memcpy(_v[i], o._v[i], sizeof(uint64_t) * PAGEWORDS);
         } else
             _v[i] = 0;
 }
 
+GlyphSet::GlyphSet(const Coverage &c)
+{
+    memset(_v, 0, sizeof(_v));
+    if (c.has_fast_covers()) {
+        // copy bitset words directly
+        const uint8_t *data = c._str.udata();
+        int nwords = Coverage::bitset_nwords(data);
+        const uint64_t *words = reinterpret_cast<const uint64_t *>(data + Coverage::bitset_words_offset(nwords));
+        for (int w = 0; w < nwords; ++w)
+            if (words[w])
+                page(w / PAGEWORDS)[w % PAGEWORDS] = words[w];
+    } else
+        for (Coverage::iterator i = c.begin(); i; ++i)
+            insert(*i);
+}
+
 GlyphSet::~GlyphSet()
 {
     for (int i = 0; i < VLEN; i++)
         delete[] _v[i];
 }
 
+uint64_t *
+GlyphSet::page(int i)
+{
+    if (!_v[i]) {
+        _v[i] = new uint64_t[PAGEWORDS];
+        memset(_v[i], 0, sizeof(uint64_t) * PAGEWORDS);
+    }
+    return _v[i];
+}
+
+bool
+GlyphSet::empty() const
+{
+    for (int i = 0; i < VLEN; i++)
+        if (const uint64_t *u = _v[i])
+            for (int j = 0; j < PAGEWORDS; j++)
+                if (u[j])
+                    return false;
+    return true;
+}
+
+int
+GlyphSet::size() const
+{
+    int n = 0;
+    for (int i = 0; i < VLEN; i++)
+        if (const uint64_t *u = _v[i])
+            for (int j = 0; j < PAGEWORDS; j++)
+                n += popcount64(u[j]);
+    return n;
+}
+
+bool
+GlyphSet::covers(const Coverage &c) const
+{
+    if (c.has_fast_covers()) {
+        const uint8_t *data = c._str.udata();
+        int nwords = Coverage::bitset_nwords(data);
+        const uint64_t *words = reinterpret_cast<const uint64_t *>(data + Coverage::bitset_words_offset(nwords));
+        for (int w = 0; w < nwords; ++w)
+            if (words[w]) {
+                const uint64_t *u = _v[w / PAGEWORDS];
+                if (!u || (words[w] & ~u[w % PAGEWORDS]))
+                    return false;
+            }
+        return true;
+    } else {
+        for (Coverage::iterator i = c.begin(); i; ++i)
+            if (!covers(*i))
+                return false;
+        return true;
+    }
+}
+
 int
 GlyphSet::change(Glyph g, bool value)
 {
     if ((unsigned)g > MAXGLYPH)
         return -1;
-    uint32_t *&u = _v[g >> SHIFT];
-    if (!u) {
-        u = new uint32_t[VULEN];
-        memset(u, 0, sizeof(uint32_t) * VULEN);
-    }
-    uint32_t mask = (1 << (g & 0x1F));
+    uint64_t *u = page(g >> SHIFT);
+    uint64_t mask = ((uint64_t) 1 << (g & 0x3F));
     if (value)
-        u[(g & MASK) >> 5] |= mask;
+        u[(g & MASK) >> 6] |= mask;
     else
-        u[(g & MASK) >> 5] &= ~mask;
+        u[(g & MASK) >> 6] &= ~mask;
     return 0;
 }
 
+void
+GlyphSet::clear()
+{
+    for (int i = 0; i < VLEN; i++)
+        if (_v[i])
+            memset(_v[i], 0, sizeof(uint64_t) * PAGEWORDS);
+}
+
 GlyphSet &
 GlyphSet::operator=(const GlyphSet &o)
 {
     if (&o != this) {
         for (int i = 0; i < VLEN; i++)
-            if (o._v[i]) {
-                if (!_v[i])
-                    _v[i] = new uint32_t[VULEN];
-                memcpy(_v[i], o._v[i], sizeof(uint32_t) * VULEN);
-            } else if (_v[i])
-                memset(_v[i], 0, sizeof(uint32_t) * VULEN);
+            if (o._v[i])
+                memcpy(page(i), o._v[i], sizeof(uint64_t) * PAGEWORDS);
+            else if (_v[i])
+                memset(_v[i], 0, sizeof(uint64_t) * PAGEWORDS);
     }
     return *this;
 }
 
+GlyphSet &
+GlyphSet::operator|=(const GlyphSet &o)
+{
+    for (int i = 0; i < VLEN; i++)
+        if (const uint64_t *ou = o._v[i]) {
+            uint64_t *u = page(i);
+            for (int j = 0; j < PAGEWORDS; j++)
+                u[j] |= ou[j];
+        }
+    return *this;
+}
+
+GlyphSet &
+GlyphSet::operator&=(const GlyphSet &o)
+{
+    for (int i = 0; i < VLEN; i++)
+        if (uint64_t *u = _v[i]) {
+            if (const uint64_t *ou = o._v[i])
+                for (int j = 0; j < PAGEWORDS; j++)
+                    u[j] &= ou[j];
+            else
+                memset(u, 0, sizeof(uint64_t) * PAGEWORDS);
+        }
+    return *this;
+}
+
+GlyphSet &
+GlyphSet::operator-=(const GlyphSet &o)
+{
+    for (int i = 0; i < VLEN; i++)
+        if (uint64_t *u = _v[i])
+            if (const uint64_t *ou = o._v[i])
+                for (int j = 0; j < PAGEWORDS; j++)
+                    u[j] &= ~ou[j];
+    return *this;
+}
+
+bool
+GlyphSet::operator<=(const GlyphSet &o) const
+{
+    for (int i = 0; i < VLEN; i++)
+        if (const uint64_t *u = _v[i]) {
+            const uint64_t *ou = o._v[i];
+            for (int j = 0; j < PAGEWORDS; j++)
+                if (u[j] & ~(ou ? ou[j] : 0))
+                    return false;
+        }
+    return true;
+}
+
+Glyph
+GlyphSet::next(Glyph g) const
+{
+    if (g < 0)
+        g = 0;
+    for (int i = g >> SHIFT; i < VLEN; i++, g = i << SHIFT)
+        if (const uint64_t *u = _v[i]) {
+            int j = (g & MASK) >> 6;
+            uint64_t bits = u[j] & ~(((uint64_t) 1 << (g & 0x3F)) - 1);
+            while (1) {
+                if (bits)
+                    return (i << SHIFT) + (j << 6) + ctz64(bits);
+                if (++j == PAGEWORDS)
+                    break;
+                bits = u[j];
+            }
+        }
+    return -1;
+}
+
+Coverage
+GlyphSet::coverage() const
+{
+    int npages = VLEN;
+    while (npages > 0 && !_v[npages - 1])
+        --npages;
+    Coverage c;
+    if (npages > 0) {
+        uint64_t *words = c.make_bitset(npages * PAGEWORDS);
+        for (int i = 0; i < npages; i++)
+            if (_v[i])
+                memcpy(words + i * PAGEWORDS, _v[i], sizeof(uint64_t) * PAGEWORDS);
+        c.finish_bitset();
+    }
+    return c;
+}
+
 
 /**************************
  * ClassDef               *
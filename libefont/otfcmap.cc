@@ -30,7 +30,7 @@
 namespace Efont { namespace OpenType {
 
 Cmap::Cmap(const String &s, ErrorHandler *errh)
-    : _str(s)
+    : _str(s), _index_state(I_UNBUILT)
 {
     _str.align(4);
     _error = parse_header(errh ? errh : ErrorHandler::silent_handler());
@@ -406,7 +406,7 @@ Cmap::dump_table(int t, Vector<std::pair<uint32_t, Glyph> > &ugp, ErrorHandler *
                     Glyph g = (u + idDelta) & 65535;
                     ugp.push_back(std::make_pair(u, g));
                 }
-            } else {
+            } else if (idRangeOffset != 65535) {
                 const uint8_t *gdata = idRangeOffsets + i + idRangeOffset;
                 for (uint32_t u = startCount; u <= endCount; ++u, gdata += 2)
                     if (Glyph g = USHORT_AT(gdata)) {
@@ -446,16 +446,175 @@ Cmap::dump_table(int t, Vector<std::pair<uint32_t, Glyph> > &ugp, ErrorHandler *
     }
 }
 
+void
+Cmap::index_set(uint32_t u, Glyph g) const
+{
+    assert(u < 0x10000);
+    int &page = _bmp_page[u >> PAGE_SHIFT];
+    if (page == 0) {
+        page = _bmp_glyph.size();
+        _bmp_glyph.resize(page + PAGE_SIZE, -1);
+    }
+    _bmp_glyph[page + (u & (PAGE_SIZE - 1))] = g;
+}
+
+void
+Cmap::build_index(ErrorHandler *errh) const
+{
+    _index_state = I_NONE;
+    int t = check_table(USE_FIRST_UNICODE_TABLE, errh);
+    if (t < 0)
+        return;
+
+    // Block 0 of _bmp_glyph is the shared empty page.  The index records
+    // the same mappings as dump_table(), including explicit mappings to
+    // glyph 0.
+    _bmp_page.assign(NPAGES, 0);
+    _bmp_glyph.assign(PAGE_SIZE, -1);
+    _range_first.clear();
+    _range_last.clear();
+    _range_glyph.clear();
+
+    const uint8_t *data = table_data(t);
+    switch (USHORT_AT(data)) {
+
+    case F_BYTE:
+        for (uint32_t u = 0; u < 256; ++u)
+            if (int g = data[6 + u])
+                index_set(u, g);
+        break;
+
+    case F_SEGMENTED: {
+        int segCountX2 = USHORT_AT(data + 6);
+        const uint8_t *endCounts = data + 14;
+        const uint8_t *startCounts = endCounts + segCountX2 + 2;
+        const uint8_t *idDeltas = startCounts + segCountX2;
+        const uint8_t *idRangeOffsets = idDeltas + segCountX2;
+        for (int i = 0; i < segCountX2; i += 2) {
+            uint32_t endCount = USHORT_AT(endCounts + i);
+            uint32_t startCount = USHORT_AT(startCounts + i);
+            int idDelta = SHORT_AT(idDeltas + i);
+            int idRangeOffset = USHORT_AT(idRangeOffsets + i);
+            if (idRangeOffset == 0) {
+                for (uint32_t u = startCount; u <= endCount; ++u)
+                    index_set(u, (u + idDelta) & 65535);
+            } else if (idRangeOffset != 65535) {
+                const uint8_t *gdata = idRangeOffsets + i + idRangeOffset;
+                for (uint32_t u = startCount; u <= endCount; ++u, gdata += 2)
+                    if (Glyph g = USHORT_AT(gdata))
+                        index_set(u, (g + idDelta) & 65535);
+            }
+        }
+        break;
+    }
+
+    case F_TRIMMED: {
+        uint32_t firstCode = USHORT_AT(data + 6);
+        int entryCount = USHORT_AT(data + 8);
+        for (int i = 0; i < entryCount; i++)
+            if (Glyph g = USHORT_AT(data + 10 + (i << 1))) {
+                // the trimmed array may run past U+FFFF; those code points
+                // become one-character ranges
+                uint32_t u = firstCode + i;
+                if (u < 0x10000)
+                    index_set(u, g);
+                else {
+                    _range_first.push_back(u);
+                    _range_last.push_back(u);
+                    _range_glyph.push_back(g);
+                }
+            }
+        break;
+    }
+
+    case F_SEGMENTED32: {
+        uint32_t nGroups = ULONG_AT(data + 12);
+        const uint8_t *groups = data + 16;
+        for (uint32_t i = 0; i < nGroups; i++, groups += 12) {
+            uint32_t startCharCode = ULONG_AT(groups);
+            uint32_t endCharCode = ULONG_AT(groups + 4);
+            Glyph startGlyphID = ULONG_AT(groups + 8);
+            uint32_t u = startCharCode;
+            for (; u <= endCharCode && u < 0x10000; ++u)
+                index_set(u, startGlyphID + (u - startCharCode));
+            if (u <= endCharCode) {
+                _range_first.push_back(u);
+                _range_last.push_back(endCharCode);
+                _range_glyph.push_back(startGlyphID + (u - startCharCode));
+            }
+        }
+        break;
+    }
+
+    default:
+        // format 2 tables are rare and not Unicode; use map_table()
+        return;
+
+    }
+
+    _index_state = I_OK;
+}
+
+Glyph
+Cmap::index_lookup_range(uint32_t u) const
+{
+    // branch-free binary search for the last range starting at or before u
+    int n = _range_first.size();
+    if (n == 0 || u < _range_first[0])
+        return 0;
+    const uint32_t *base = _range_first.begin();
+    while (n > 1) {
+        int half = n / 2;
+        base = (base[half] <= u ? base + half : base);
+        n -= half;
+    }
+    int i = base - _range_first.begin();
+    return (u <= _range_last[i] ? _range_glyph[i] + (u - *base) : 0);
+}
+
 int
 Cmap::map_uni(const Vector<uint32_t> &vin, Vector<Glyph> &vout) const
 {
-    int t;
-    if ((t = check_table(USE_FIRST_UNICODE_TABLE)) < 0)
-        return -1;
+    if (_index_state == I_UNBUILT)
+        build_index(0);
+    if (_index_state != I_OK) {
+        int t;
+        if ((t = check_table(USE_FIRST_UNICODE_TABLE)) < 0)
+            return -1;
+        vout.resize(vin.size(), 0);
+        for (int i = 0; i < vin.size(); i++)
+            vout[i] = map_table(t, vin[i]);
+        return 0;
+    }
+
     vout.resize(vin.size(), 0);
-    for (int i = 0; i < vin.size(); i++)
-        vout[i] = map_table(t, vin[i]);
+    const uint32_t *in = vin.begin();
+    for (Glyph *out = vout.begin(); out != vout.end(); ++in, ++out)
+        *out = index_lookup(*in);
     return 0;
 }
 
+void
+Cmap::unmap_all(Vector<std::pair<uint32_t, Glyph> > &ugp) const
+{
+    if (_index_state == I_UNBUILT)
+        build_index(ErrorHandler::default_handler());
+    if (_index_state != I_OK) {
+        dump_table(USE_FIRST_UNICODE_TABLE, ugp, ErrorHandler::default_handler());
+        return;
+    }
+
+    for (int p = 0; p < NPAGES; ++p)
+        if (int off = _bmp_page[p])
+            for (int i = 0; i < PAGE_SIZE; ++i)
+                if (_bmp_glyph[off + i] >= 0)
+                    ugp.push_back(std::make_pair((uint32_t) (p << PAGE_SHIFT) + i, _bmp_glyph[off + i]));
+    for (int r = 0; r < _range_first.size(); ++r)
+        for (uint32_t u = _range_first[r]; ; ++u) {
+            ugp.push_back(std::make_pair(u, (Glyph) (_range_glyph[r] + (u - _range_first[r]))));
+            if (u == _range_last[r])
+                break;
+        }
+}
+
 }}
@@ -107,6 +107,18 @@ GposLookup::subtable(int i) const
 
 bool
 GposLookup::unparse_automatics(Vector<Positioning> &v, ErrorHandler *errh) const
+{
+    return unparse_automatics(v, 0, errh);
+}
+
+bool
+GposLookup::unparse_automatics(Vector<Positioning> &v, const Coverage &limit, ErrorHandler *errh) const
+{
+    return unparse_automatics(v, &limit, errh);
+}
+
+bool
+GposLookup::unparse_automatics(Vector<Positioning> &v, const Coverage *limit, ErrorHandler *errh) const
 {
     int nlookup = _d.u16(4), success = 0;
     switch (_type) {
@@ -114,7 +126,10 @@ GposLookup::unparse_automatics(Vector<Positioning> &v, ErrorHandler *errh) const
         for (int i = 0; i < nlookup; i++)
             try {
                 GposSingle s(subtable(i));
-                s.unparse(v);
+                if (limit)
+                    s.unparse(v, *limit);
+                else
+                    s.unparse(v);
                 success++;
             } catch (Error e) {
                 if (errh)
@@ -125,7 +140,10 @@ GposLookup::unparse_automatics(Vector<Positioning> &v, ErrorHandler *errh) const
         for (int i = 0; i < nlookup; i++)
             try {
                 GposPair p(subtable(i));
-                p.unparse(v);
+                if (limit)
+                    p.unparse(v, *limit);
+                else
+                    p.unparse(v);
                 success++;
             } catch (Error e) {
                 if (errh)
@@ -177,6 +195,23 @@ GposSingle::unparse(Vector<Positioning> &v) const
     }
 }
 
+void
+GposSingle::unparse(Vector<Positioning> &v, const Coverage &limit) const
+{
+    int format = _d.u16(4);
+    if (_d[1] == 1) {
+        Data value = _d.subtable(6);
+        for (Coverage::iterator i = coverage().begin(); i; i++)
+            if (limit.covers(*i))
+                v.push_back(Positioning(Position(*i, format, value)));
+    } else {
+        int size = GposValue::size(format);
+        for (Coverage::iterator i = coverage().begin(); i; i++)
+            if (limit.covers(*i))
+                v.push_back(Positioning(Position(*i, format, _d.subtable(F2_HEADERSIZE + size*i.coverage_index()))));
+    }
+}
+
 
 /**************************
  * GposPair               *
@@ -218,27 +253,173 @@ GposPair::unparse(Vector<Positioning> &v) const
                                         Position(pair.u16(0), format2, pair.subtable(f2_pos))));
             }
         }
-    } else {                    // _d[1] == 2
-        int format1 = _d.u16(4);
-        int format2 = _d.u16(6);
-        int f2_pos = GposValue::size(format1);
-        int recsize = f2_pos + GposValue::size(format2);
-        ClassDef class1(_d.offset_subtable(8));
-        ClassDef class2(_d.offset_subtable(10));
-        Coverage coverage = this->coverage();
-        int nclass1 = _d.u16(12);
-        int nclass2 = _d.u16(14);
-        int offset = F2_HEADERSIZE;
-        for (int c1 = 0; c1 < nclass1; c1++)
-            for (int c2 = 0; c2 < nclass2; c2++, offset += recsize) {
-                Position p1(format1, _d.subtable(offset));
-                Position p2(format2, _d.subtable(offset + f2_pos));
-                if (p1 || p2) {
-                    for (ClassDef::class_iterator c1i = class1.begin(c1, coverage); c1i; c1i++)
-                        for (ClassDef::class_iterator c2i = class2.begin(c2); c2i; c2i++)
-                            v.push_back(Positioning(Position(*c1i, p1), Position(*c2i, p2)));
+    } else                      // _d[1] == 2
+        unparse_classes(v, 0);
+}
+
+void
+GposPair::unparse_classes(Vector<Positioning> &v, const Coverage *limit) const
+{
+    int format1 = _d.u16(4);
+    int format2 = _d.u16(6);
+    int f2_pos = GposValue::size(format1);
+    int recsize = f2_pos + GposValue::size(format2);
+    ClassDef class1(_d.offset_subtable(8));
+    ClassDef class2(_d.offset_subtable(10));
+    Coverage coverage = this->coverage();
+    int nclass1 = _d.u16(12);
+    int nclass2 = _d.u16(14);
+    if (recsize == 0)           // every cell is empty
+        return;
+    int offset = F2_HEADERSIZE;
+    for (int c1 = 0; c1 < nclass1; c1++)
+        for (int c2 = 0; c2 < nclass2; c2++, offset += recsize) {
+            Position p1(format1, _d.subtable(offset));
+            Position p2(format2, _d.subtable(offset + f2_pos));
+            if (p1 || p2) {
+                // start the class2 iterator even for glyphs outside the
+                // limit, so class 0 fails the same way with or without one
+                for (ClassDef::class_iterator c1i = class1.begin(c1, coverage); c1i; c1i++) {
+                    ClassDef::class_iterator c2i = class2.begin(c2);
+                    if (!limit || limit->covers(*c1i))
+                        for (; c2i; c2i++)
+                            if (!limit || limit->covers(*c2i))
+                                v.push_back(Positioning(Position(*c1i, p1), Position(*c2i, p2)));
                 }
             }
+        }
+}
+
+bool
+GposPair::class_matrix(GposPairMatrix &m) const
+{
+    if (_d[1] != 2)
+        return false;
+    int format1 = _d.u16(4);
+    int format2 = _d.u16(6);
+    int f2_pos = GposValue::size(format1);
+    int recsize = f2_pos + GposValue::size(format2);
+    // The class counts come straight from the font, so check that the
+    // whole matrix lies within the subtable before allocating it.
+    size_t ncells = (size_t) _d.u16(12) * _d.u16(14);
+    if (recsize == 0 || _d.length() < F2_HEADERSIZE
+        || ncells > (size_t) (_d.length() - F2_HEADERSIZE) / recsize)
+        return false;
+    m._coverage = coverage();
+    m._class1 = ClassDef(_d.offset_subtable(8));
+    m._class2 = ClassDef(_d.offset_subtable(10));
+    m._nclass1 = _d.u16(12);
+    m._nclass2 = _d.u16(14);
+    m._values.resize(2 * m._nclass1 * m._nclass2);
+    Position *p = m._values.begin();
+    for (int offset = F2_HEADERSIZE; p != m._values.end(); offset += recsize, p += 2) {
+        p[0] = Position(format1, _d.subtable(offset));
+        p[1] = Position(format2, _d.subtable(offset + f2_pos));
+    }
+    return true;
+}
+
+void
+GposPair::unparse(Vector<Positioning> &v, const Coverage &limit) const
+{
+    GposPairMatrix m;
+    if (class_matrix(m)) {
+        m.unparse(v, limit);
+        return;
+    } else if (_d[1] == 2) {
+        // a matrix that overruns the subtable: walk it cell by cell, so
+        // records before the first bad one are kept, as in unparse()
+        unparse_classes(v, &limit);
+        return;
+    }
+
+    // format 1: pair sets for uncovered first glyphs are never read
+    int format1 = _d.u16(4);
+    int format2 = _d.u16(6);
+    int f2_pos = PAIRVALUE_HEADERSIZE + GposValue::size(format1);
+    int pairvalue_size = f2_pos + GposValue::size(format2);
+    for (Coverage::iterator i = coverage().begin(); i; i++) {
+        if (!limit.covers(*i))
+            continue;
+        Data pairset = _d.offset_subtable(F1_HEADERSIZE + i.coverage_index()*F1_RECSIZE);
+        int npair = pairset.u16(0);
+        for (int j = 0; j < npair; j++) {
+            Data pair = pairset.subtable(PAIRSET_HEADERSIZE + j*pairvalue_size);
+            if (limit.covers(pair.u16(0)))
+                v.push_back(Positioning(Position(*i, format1, pair.subtable(PAIRVALUE_HEADERSIZE)),
+                                        Position(pair.u16(0), format2, pair.subtable(f2_pos))));
+        }
+    }
+}
+
+
+/**************************
+ * GposPairMatrix         *
+ *                        *
+ **************************/
+
+// Sort the glyphs of limit with a class in matrix m by that class, keeping
+// glyph order within each class. On return, the glyphs of class c are
+// glyphs[start[c]] through glyphs[start[c+1] - 1].
+static void
+sort_by_class(const GposPairMatrix &m, bool left, const Coverage &limit,
+              Vector<Glyph> &glyphs, Vector<int> &start)
+{
+    int nclass = left ? m.nclass1() : m.nclass2();
+    Vector<Glyph> found;
+    Vector<int> found_class;
+    start.assign(nclass + 1, 0);
+    for (Coverage::iterator i = limit.begin(); i; i++) {
+        int c = left ? m.left_class(*i) : m.right_class(*i);
+        if (c >= 0) {
+            found.push_back(*i);
+            found_class.push_back(c);
+            start[c + 1]++;
+        }
+    }
+    for (int c = 0; c < nclass; c++)
+        start[c + 1] += start[c];
+    glyphs.resize(found.size());
+    Vector<int> pos(start);
+    for (int i = 0; i < found.size(); i++)
+        glyphs[pos[found_class[i]]++] = found[i];
+}
+
+void
+GposPairMatrix::unparse(Vector<Positioning> &v, const Coverage &limit) const
+{
+    // Classify each glyph in the limit set once, then walk the matrix in
+    // row-major order, as GposPair::unparse() does, visiting only those
+    // glyphs. Positionings therefore come out in the same order.
+    Vector<Glyph> left, right;
+    Vector<int> left_start, right_start;
+    sort_by_class(*this, true, limit, left, left_start);
+    sort_by_class(*this, false, limit, right, right_start);
+
+    // GposPair::unparse() cannot iterate over right class 0 (glyphs missing
+    // from the second ClassDef), so it fails at the first nonempty cell in
+    // that column whose row has a covered glyph. Fail at the same point.
+    Vector<int> row_used(_nclass1, 0);
+    for (Coverage::iterator i = _coverage.begin(); i; i++) {
+        int c = left_class(*i);
+        if (c >= 0)
+            row_used[c] = 1;
+    }
+
+    for (int c1 = 0; c1 < _nclass1; c1++) {
+        if (row_used[c1] && _nclass2 > 0
+            && (left_value(c1, 0) || right_value(c1, 0)))
+            throw Error("cannot iterate over ClassDef class 0");
+        if (left_start[c1] == left_start[c1 + 1])
+            continue;
+        for (int c2 = 1; c2 < _nclass2; c2++) {
+            const Position &p1 = left_value(c1, c2), &p2 = right_value(c1, c2);
+            if ((!p1 && !p2) || right_start[c2] == right_start[c2 + 1])
+                continue;
+            for (int i = left_start[c1]; i < left_start[c1 + 1]; i++)
+                for (int j = right_start[c2]; j < right_start[c2 + 1]; j++)
+                    v.push_back(Positioning(Position(left[i], p1), Position(right[j], p2)));
+        }
     }
 }
 
@@ -323,6 +504,69 @@ Positioning::unparse(const Vector<PermString> *gns) const
     return sa.take_string();
 }
 
+/* Serialized form: a byte giving the number of positions (0, 1, or 2),
+   then each position as a 16-bit glyph and four 32-bit values, all
+   big-endian. */
+
+static inline void
+serialize_u32(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(4));
+    s[0] = x >> 24;
+    s[1] = x >> 16;
+    s[2] = x >> 8;
+    s[3] = x;
+}
+
+static void
+serialize_position(StringAccum &sa, const Position &p)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(2));
+    s[0] = p.g >> 8;
+    s[1] = p.g;
+    serialize_u32(sa, p.pdx);
+    serialize_u32(sa, p.pdy);
+    serialize_u32(sa, p.adx);
+    serialize_u32(sa, p.ady);
+}
+
+static bool
+deserialize_position(const uint8_t *&s, const uint8_t *end, Position &p)
+{
+    if (end - s < 18)
+        return false;
+    p = Position(Data::u16(s), Data::s32(s + 2), Data::s32(s + 6),
+                 Data::s32(s + 10), Data::s32(s + 14));
+    s += 18;
+    return true;
+}
+
+void
+Positioning::serialize(StringAccum &sa) const
+{
+    if (!*this)
+        sa << '\0';
+    else if (is_single()) {
+        sa << '\1';
+        serialize_position(sa, _left);
+    } else {
+        sa << '\2';
+        serialize_position(sa, _left);
+        serialize_position(sa, _right);
+    }
+}
+
+bool
+Positioning::deserialize(const uint8_t *&s, const uint8_t *end)
+{
+    if (s == end || *s > 2)
+        return false;
+    int n = *s++;
+    _left = _right = Position(0, 0, 0, 0, 0);
+    return (n < 1 || deserialize_position(s, end, _left))
+        && (n < 2 || deserialize_position(s, end, _right));
+}
+
 }}
 
 #include <lcdf/vector.cc>
@@ -228,10 +228,7 @@ Substitution::substitute_in(const Substitute &s, uint8_t t, const GlyphSet &gs)
                 return false;
         return true;
       case T_COVERAGE:
-        for (Coverage::iterator i = s.coverage->begin(); i; i++)
-            if (!gs.covers(*i))
-                return false;
-        return true;
+        return gs.covers(*s.coverage);
       default:
         assert(0);
         return false;
@@ -558,6 +555,108 @@ Substitution::unparse(const Vector<PermString> *gns) const
     return sa.take_string();
 }
 
+/* Serialized form: a flags byte (1 = alternate), then the left, in, out,
+   and right substitutes.  Each substitute is a type byte followed by a
+   16-bit glyph (T_GLYPH) or by a 32-bit count and that many 16-bit glyphs
+   (T_GLYPHS, T_COVERAGE).  Coverages are stored as glyph lists.  All
+   numbers are big-endian. */
+
+static inline void
+serialize_u16(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(2));
+    s[0] = x >> 8;
+    s[1] = x;
+}
+
+static inline void
+serialize_u32(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(4));
+    s[0] = x >> 24;
+    s[1] = x >> 16;
+    s[2] = x >> 8;
+    s[3] = x;
+}
+
+void
+Substitution::serialize(StringAccum &sa, const Substitute &s, uint8_t t)
+{
+    sa << (char) t;
+    if (t == T_GLYPH)
+        serialize_u16(sa, s.gid);
+    else if (t == T_GLYPHS || t == T_COVERAGE) {
+        Vector<Glyph> gs;
+        extract_glyphs(s, t, gs, true);
+        serialize_u32(sa, gs.size());
+        for (const Glyph *g = gs.begin(); g != gs.end(); ++g)
+            serialize_u16(sa, *g);
+    }
+}
+
+void
+Substitution::serialize(StringAccum &sa) const
+{
+    sa << (char) (_alternate ? 1 : 0);
+    serialize(sa, _left, _left_is);
+    serialize(sa, _in, _in_is);
+    serialize(sa, _out, _out_is);
+    serialize(sa, _right, _right_is);
+}
+
+bool
+Substitution::deserialize(const uint8_t *&s, const uint8_t *end, Substitute &x, uint8_t &t)
+{
+    clear(x, t);
+    if (s == end)
+        return false;
+    uint8_t type = *s++;
+    if (type == T_NONE)
+        return true;
+    else if (type == T_GLYPH) {
+        if (end - s < 2)
+            return false;
+        assign(x, t, Data::u16(s));
+        s += 2;
+        return true;
+    } else if (type == T_GLYPHS || type == T_COVERAGE) {
+        if (end - s < 4)
+            return false;
+        uint32_t n = Data::u32(s);
+        s += 4;
+        if (n == 0 || (uint32_t) (end - s) < 2 * n)
+            return false;
+        Vector<Glyph> gs;
+        for (uint32_t i = 0; i < n; ++i, s += 2)
+            gs.push_back(Data::u16(s));
+        if (type == T_GLYPHS) {
+            x.gids = new Glyph[n + 1];
+            x.gids[0] = n;
+            memcpy(x.gids + 1, gs.begin(), n * sizeof(Glyph));
+            t = T_GLYPHS;
+        } else {
+            GlyphSet gset;
+            for (const Glyph *g = gs.begin(); g != gs.end(); ++g)
+                gset.insert(*g);
+            assign(x, t, gset.coverage());
+        }
+        return true;
+    } else
+        return false;
+}
+
+bool
+Substitution::deserialize(const uint8_t *&s, const uint8_t *end)
+{
+    if (s == end)
+        return false;
+    _alternate = (*s++ & 1) != 0;
+    return deserialize(s, end, _left, _left_is)
+        && deserialize(s, end, _in, _in_is)
+        && deserialize(s, end, _out, _out_is)
+        && deserialize(s, end, _right, _right_is);
+}
+
 
 
 /**************************
@@ -642,7 +741,7 @@ GsubLookup::subtable(int i) const
 }
 
 void
-GsubLookup::mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const
+GsubLookup::mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const
 {
     int nlookup = _d.u16(4);
     switch (_type) {
@@ -699,19 +798,19 @@ GsubLookup::unparse_automatics(const Gsub &gsub, Vector<Substitution> &v, const
       case L_MULTIPLE:
         for (int i = 0; i < nlookup; i++) {
             GsubMultiple x(subtable(i));
-            x.unparse(v);
+            x.unparse(v, limit);
         }
         return true;
       case L_ALTERNATE:
         for (int i = 0; i < nlookup; i++) {
             GsubMultiple x(subtable(i));
-            x.unparse(v, true);
+            x.unparse(v, limit, true);
         }
         return true;
       case L_LIGATURE:
         for (int i = 0; i < nlookup; i++) {
             GsubLigature x(subtable(i));
-            x.unparse(v);
+            x.unparse(v, limit);
         }
         return true;
       case L_CONTEXT: {
@@ -810,15 +909,15 @@ GsubSingle::map(Glyph g) const
 }
 
 void
-GsubSingle::mark_out_glyphs(Vector<bool> &gmap) const
+GsubSingle::mark_out_glyphs(GlyphSet &gmap) const
 {
     if (_d[1] == 1) {
         int delta = _d.s16(4);
         for (Coverage::iterator i = coverage().begin(); i; i++)
-            gmap[*i + delta] = true;
+            gmap.insert(*i + delta);
     } else {
         for (Coverage::iterator i = coverage().begin(); i; i++)
-            gmap[_d.u16(HEADERSIZE + i.coverage_index()*FORMAT2_RECSIZE)] = true;
+            gmap.insert(_d.u16(HEADERSIZE + i.coverage_index()*FORMAT2_RECSIZE));
     }
 }
 
@@ -891,20 +990,22 @@ GsubMultiple::map(Glyph g, Vector<Glyph> &v) const
 }
 
 void
-GsubMultiple::mark_out_glyphs(Vector<bool> &gmap) const
+GsubMultiple::mark_out_glyphs(GlyphSet &gmap) const
 {
     for (Coverage::iterator i = coverage().begin(); i; ++i) {
         Data seq = _d.offset_subtable(HEADERSIZE + i.coverage_index()*RECSIZE);
         for (int j = 0; j < seq.u16(0); ++j)
-            gmap[seq.u16(SEQ_HEADERSIZE + j*SEQ_RECSIZE)] = true;
+            gmap.insert(seq.u16(SEQ_HEADERSIZE + j*SEQ_RECSIZE));
     }
 }
 
 void
-GsubMultiple::unparse(Vector<Substitution> &v, bool is_alternate) const
+GsubMultiple::unparse(Vector<Substitution> &v, const Coverage &limit, bool is_alternate) const
 {
     Vector<Glyph> result;
     for (Coverage::iterator i = coverage().begin(); i; i++) {
+        if (!limit.covers(*i))
+            continue;
         Data seq = _d.offset_subtable(HEADERSIZE + i.coverage_index()*RECSIZE);
         result.clear();
         for (int j = 0; j < seq.u16(0); j++)
@@ -980,7 +1081,7 @@ GsubLigature::map(const Vector<Glyph> &gs, Glyph &result, int &consumed) const
 }
 
 void
-GsubLigature::mark_out_glyphs(Vector<bool> &gmap) const
+GsubLigature::mark_out_glyphs(GlyphSet &gmap) const
 {
     for (Coverage::iterator i = coverage().begin(); i; i++) {
         Data ligset = _d.offset_subtable(HEADERSIZE + i.coverage_index()*RECSIZE);
@@ -988,15 +1089,18 @@ GsubLigature::mark_out_glyphs(Vector<bool> &gmap) const
         Vector<Glyph> components(1, *i);
         for (int j = 0; j < nligset; j++) {
             Data lig = ligset.offset_subtable(SET_HEADERSIZE + j*SET_RECSIZE);
-            gmap[lig.u16(0)] = true;
+            gmap.insert(lig.u16(0));
         }
     }
 }
 
 void
-GsubLigature::unparse(Vector<Substitution> &v) const
+GsubLigature::unparse(Vector<Substitution> &v, const Coverage &limit) const
 {
+    // a ligature is skipped unless all its components are in limit
     for (Coverage::iterator i = coverage().begin(); i; i++) {
+        if (!limit.covers(*i))
+            continue;
         Data ligset = _d.offset_subtable(HEADERSIZE + i.coverage_index()*RECSIZE);
         int nligset = ligset.u16(0);
         Vector<Glyph> components(1, *i);
@@ -1004,9 +1108,14 @@ GsubLigature::unparse(Vector<Substitution> &v) const
             Data lig = ligset.offset_subtable(SET_HEADERSIZE + j*SET_RECSIZE);
             int nlig = lig.u16(2);
             components.resize(1);
-            for (int k = 0; k < nlig - 1; k++)
-                components.push_back(lig.u16(LIG_HEADERSIZE + k*LIG_RECSIZE));
+            for (int k = 0; k < nlig - 1; k++) {
+                Glyph g = lig.u16(LIG_HEADERSIZE + k*LIG_RECSIZE);
+                if (!limit.covers(g))
+                    goto skip_ligature;
+                components.push_back(g);
+            }
             v.push_back(Substitution(components, lig.u16(0)));
+        skip_ligature: ;
         }
     }
 }
@@ -1073,7 +1182,7 @@ GsubContext::coverage() const throw ()
 void
 GsubContext::subruleset_mark_out_glyphs(const Data &data, int nsub,
                                         int subtab_offset, const Gsub &gsub,
-                                        Vector<bool> &gmap)
+                                        GlyphSet &gmap)
 {
     for (int j = 0; j < nsub; ++j) {
         int lookup_index = data.u16(subtab_offset + SUBRECSIZE*j + 2);
@@ -1082,7 +1191,7 @@ GsubContext::subruleset_mark_out_glyphs(const Data &data, int nsub,
 }
 
 void
-GsubContext::mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const
+GsubContext::mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const
 {
     if (_d.u16(0) != 3)         // XXX
         return;
@@ -1217,7 +1326,7 @@ GsubChainContext::coverage() const throw ()
 }
 
 void
-GsubChainContext::mark_out_glyphs(const Gsub &gsub, Vector<bool> &gmap) const
+GsubChainContext::mark_out_glyphs(const Gsub &gsub, GlyphSet &gmap) const
 {
     switch (_d.u16(0)) {
     case 1: {
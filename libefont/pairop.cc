@@ -23,7 +23,8 @@ namespace Efont {
 PairProgram::PairProgram(const PairProgram &o)
   : _reversed(o._reversed),
     _left_map(o._left_map),
-    _op(o._op)
+    _op(o._op),
+    _pair_count(0)
 {
 }
 
@@ -36,16 +37,68 @@ PairProgram::reserve_glyphs(int e)
 }
 
 
+inline unsigned
+PairProgram::pair_hash(GlyphIndex left, GlyphIndex right)
+{
+  unsigned h = ((unsigned) left * 0x9E3779B1U ^ (unsigned) right) * 0x85EBCA6BU;
+  return h ^ (h >> 16);
+}
+
+
+void
+PairProgram::build_pair_table() const
+{
+  int n = 16;
+  while (n < 2 * (_op.size() + 1))
+    n *= 2;
+  _pair_table.assign(n, -1);
+  _pair_count = 0;
+  // Walk the left lists so each pair maps to the op find() would reach
+  // first, even when the program holds duplicate pairs.
+  for (GlyphIndex gi = 0; gi < _left_map.size(); gi++)
+    for (PairOpIndex opi = _left_map[gi]; opi >= 0; opi = _op[opi].next_left())
+      insert_pair(opi, false);
+}
+
+
+void
+PairProgram::insert_pair(PairOpIndex opi, bool replace) const
+{
+  // Keep the table at most half full.  Rebuilding picks up opi from its
+  // left list.
+  if (2 * (_pair_count + 1) > _pair_table.size()) {
+    build_pair_table();
+    return;
+  }
+
+  const PairOp &o = _op[opi];
+  unsigned mask = _pair_table.size() - 1;
+  unsigned h = pair_hash(o.left(), o.right()) & mask;
+  while (_pair_table[h] >= 0) {
+    const PairOp &p = _op[_pair_table[h]];
+    if (p.left() == o.left() && p.right() == o.right()) {
+      if (replace)
+        _pair_table[h] = opi;
+      return;
+    }
+    h = (h + 1) & mask;
+  }
+  _pair_table[h] = opi;
+  _pair_count++;
+}
+
+
 PairOpIndex
 PairProgram::find(GlyphIndex leftgi, GlyphIndex rightgi) const
 {
-  PairOpIndex opi = find_left(leftgi);
-  while (opi >= 0) {
-    if (op(opi).right() == rightgi)
+  if (!_pair_table.size())
+    build_pair_table();
+  unsigned mask = _pair_table.size() - 1;
+  for (unsigned h = pair_hash(leftgi, rightgi) & mask; ; h = (h + 1) & mask) {
+    PairOpIndex opi = _pair_table[h];
+    if (opi < 0 || (_op[opi].left() == leftgi && _op[opi].right() == rightgi))
       return opi;
-    opi = op(opi).next_left();
   }
-  return -1;
 }
 
 
@@ -56,6 +109,9 @@ PairProgram::add_kern(GlyphIndex left, GlyphIndex right, int ki)
   int newopi = _op.size();
   _op.push_back(newop);
   _left_map[left] = newopi;
+  // newop now heads its left list
+  if (_pair_table.size())
+    insert_pair(newopi, true);
 
   //PairOpIndex duplicate = map[newop];
   //map.add(newop, newopi);
@@ -72,6 +128,9 @@ PairProgram::add_lig(GlyphIndex left, GlyphIndex right, GlyphIndex result,
   int newopi = _op.size();
   _op.push_back(newop);
   _left_map[left] = newopi;
+  // newop now heads its left list
+  if (_pair_table.size())
+    insert_pair(newopi, true);
 
   //PairOpIndex duplicate = map[newop];
   //map.add(newop, newopi);
@@ -86,6 +145,7 @@ PairProgram::unreverse()
   if (!_reversed) return;
 
   _left_map.assign(_left_map.size(), -1);
+  _pair_table.clear();
 
   for (PairOpIndex opi = _op.size() - 1; opi >= 0; opi--) {
     PairOp &o = _op[opi];
@@ -17,48 +17,93 @@
 # include <config.h>
 #endif
 #include <efont/t1bounds.hh>
+#include <lcdf/mapfile.hh>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <algorithm>
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#if HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+#if HAVE_UNISTD_H && HAVE_SYS_WAIT_H && HAVE_WAITPID
+# define GLYPHBOUNDS_PARALLEL 1
+#endif
 
 namespace Efont {
 
 CharstringBounds::CharstringBounds()
     : _lb(UNKDOUBLE, UNKDOUBLE), _rt(UNKDOUBLE, UNKDOUBLE),
-      _last_xf_program(0)
+      _last(UNKDOUBLE, UNKDOUBLE), _last_xf_program(0)
 {
 }
 
 CharstringBounds::CharstringBounds(const Transform& nonfont_xf)
     : _lb(UNKDOUBLE, UNKDOUBLE), _rt(UNKDOUBLE, UNKDOUBLE),
-      _nonfont_xf(nonfont_xf), _last_xf_program(0)
+      _last(UNKDOUBLE, UNKDOUBLE), _nonfont_xf(nonfont_xf),
+      _last_xf_program(0)
 {
 }
 
 CharstringBounds::CharstringBounds(const Transform &nonfont_xf, const Vector<double> &weight)
-    : CharstringInterp(weight),
+    : Type2Interp<CharstringBounds>(weight),
       _lb(UNKDOUBLE, UNKDOUBLE), _rt(UNKDOUBLE, UNKDOUBLE),
-      _nonfont_xf(nonfont_xf), _last_xf_program(0)
+      _last(UNKDOUBLE, UNKDOUBLE), _nonfont_xf(nonfont_xf),
+      _last_xf_program(0)
 {
 }
 
 void
 CharstringBounds::clear()
 {
-    _lb = _rt = Point(UNKDOUBLE, UNKDOUBLE);
+    _lb = _rt = _last = Point(UNKDOUBLE, UNKDOUBLE);
     _width = Point(0, 0);
 }
 
+// Mark the interior extrema of a transformed curve whose endpoints are
+// already marked.  An axis whose control coordinates lie within the box
+// cannot extend it; otherwise the curve's extrema on that axis are the
+// roots of its derivative, a quadratic.
 void
-CharstringBounds::xf_mark(const Bezier &b)
+CharstringBounds::xf_mark_extrema(const Point &q0, const Point &q1,
+                                  const Point &q2, const Point &q3)
 {
-    Bezier b1, b2;
-    b.halve(b1, b2);
-    xf_mark(b1.point(3));
-    if (!xf_controls_inside(b1))
-        xf_mark(b1);
-    if (!xf_controls_inside(b2))
-        xf_mark(b2);
+    for (int axis = 0; axis < 2; ++axis) {
+        double c0 = (axis ? q0.y : q0.x), c1 = (axis ? q1.y : q1.x);
+        double c2 = (axis ? q2.y : q2.x), c3 = (axis ? q3.y : q3.x);
+        double lo = (axis ? _lb.y : _lb.x), hi = (axis ? _rt.y : _rt.x);
+        if (c1 >= lo && c1 <= hi && c2 >= lo && c2 <= hi)
+            continue;
+
+        // B'(t) / 3 = a t^2 + b t + c
+        double a = c3 - c0 + 3 * (c1 - c2);
+        double b = 2 * (c0 - 2 * c1 + c2);
+        double c = c1 - c0;
+        double disc = b * b - 4 * a * c;
+        if (disc < 0)
+            continue;
+        double sq = sqrt(disc);
+        double q = -0.5 * (b < 0 ? b - sq : b + sq);
+        double t[2];
+        int nt = 0;
+        if (a != 0)
+            t[nt++] = q / a;
+        if (q != 0)
+            t[nt++] = c / q;
+
+        for (int i = 0; i < nt; ++i)
+            if (t[i] > 0 && t[i] < 1) {
+                double u = t[i], mu = 1 - u;
+                double w0 = mu * mu * mu, w1 = 3 * mu * mu * u;
+                double w2 = 3 * mu * u * u, w3 = u * u * u;
+                xf_mark(Point(w0 * q0.x + w1 * q1.x + w2 * q2.x + w3 * q3.x,
+                              w0 * q0.y + w1 * q1.y + w2 * q2.y + w3 * q3.y));
+            }
+    }
 }
 
 void
@@ -70,25 +115,28 @@ CharstringBounds::act_width(int, const Point &w)
 void
 CharstringBounds::act_line(int, const Point &p0, const Point &p1)
 {
-    mark(p0);
+    // Segments usually start where the last one ended, already marked.
+    if (p0 != _last)
+        mark(p0);
     mark(p1);
+    _last = p1;
 }
 
 void
 CharstringBounds::act_curve(int, const Point &p0, const Point &p1, const Point &p2, const Point &p3)
 {
-    Point q0 = p0 * _xf;
+    if (p0 != _last)
+        mark(p0);
     Point q1 = p1 * _xf;
     Point q2 = p2 * _xf;
     Point q3 = p3 * _xf;
-
-    xf_mark(q0);
     xf_mark(q3);
+    _last = p3;
 
-    if (!xf_inside(q1) || !xf_inside(q2)) {
-        Bezier b(q0, q1, q2, q3);
-        xf_mark(b);
-    }
+    // A curve lies within its control points' hull, so if the controls
+    // are inside the box, so is the whole curve.
+    if (!xf_inside(q1) || !xf_inside(q2))
+        xf_mark_extrema(p0 * _xf, q1, q2, q3);
 }
 
 void
@@ -101,6 +149,7 @@ CharstringBounds::set_xf(const CharstringProgram *program)
         Transform font_xf = Transform(matrix).scaled(program->units_per_em());
         font_xf.check_null(0.001);
         _xf = _nonfont_xf * font_xf;
+        _last = Point(UNKDOUBLE, UNKDOUBLE);
     }
 }
 
@@ -108,11 +157,12 @@ bool
 CharstringBounds::char_bounds(const CharstringContext &g, bool shift)
 {
     set_xf(g.program);
-    CharstringInterp::interpret(g);
+    fast_interpret(g);
     if (shift) {
         _xf.raw_translate(_width - _xf.translation());
         _nonfont_xf.raw_translate(_width - _nonfont_xf.translation());
         _width = Point(0, 0);
+        _last = Point(UNKDOUBLE, UNKDOUBLE);
     }
     return error() >= 0;
 }
@@ -122,6 +172,7 @@ CharstringBounds::translate(double dx, double dy)
 {
     _xf.translate(dx, dy);
     _nonfont_xf.translate(dx, dy);
+    _last = Point(UNKDOUBLE, UNKDOUBLE);
 }
 
 bool
@@ -162,4 +213,177 @@ CharstringBounds::bounds(const CharstringContext &g,
     return b.output(bb, width, true);
 }
 
+
+
+// GlyphBoundsTable: bounds of every glyph in a program, computed at most
+// once each.  The table is stored as parallel arrays, one per dimension.
+// Bulk computation can be split across several processes.
+
+GlyphBoundsTable::GlyphBoundsTable(const CharstringProgram *program,
+                                   const Transform &nonfont_xf)
+    : _program(program), _nonfont_xf(nonfont_xf)
+{
+    int n = program->nglyphs();
+    _state.assign(n, s_unknown);
+    _xmin.assign(n, 0);
+    _ymin.assign(n, 0);
+    _xmax.assign(n, 0);
+    _ymax.assign(n, 0);
+    _width.assign(n, 0);
+}
+
+void
+GlyphBoundsTable::set(int g, const double bb[4], double width, bool ok)
+{
+    if (g >= 0 && g < _state.size()) {
+        _xmin[g] = bb[0];
+        _ymin[g] = bb[1];
+        _xmax[g] = bb[2];
+        _ymax[g] = bb[3];
+        _width[g] = width;
+        _state[g] = (ok ? s_ok : s_error);
+    }
+}
+
+void
+GlyphBoundsTable::compute_one(int g)
+{
+    double bb[4], width;
+    bool ok = CharstringBounds::bounds(_nonfont_xf, _program->glyph_context(g), bb, width);
+    set(g, bb, width, ok);
+}
+
+bool
+GlyphBoundsTable::get(int g, double bb[4], double &width)
+{
+    if (g < 0 || g >= _state.size())
+        return CharstringBounds::bounds(_nonfont_xf, _program->glyph_context(g), bb, width);
+    if (_state[g] == s_unknown)
+        compute_one(g);
+    bb[0] = _xmin[g];
+    bb[1] = _ymin[g];
+    bb[2] = _xmax[g];
+    bb[3] = _ymax[g];
+    width = _width[g];
+    return _state[g] == s_ok;
+}
+
+void
+GlyphBoundsTable::compute(const Vector<int> &glyphs, int nprocs)
+{
+    Vector<int> todo;
+    for (const int *g = glyphs.begin(); g != glyphs.end(); ++g)
+        if (*g >= 0 && *g < _state.size() && _state[*g] == s_unknown)
+            todo.push_back(*g);
+    std::sort(todo.begin(), todo.end());
+    todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+
+    if (nprocs > 1 && compute_parallel(todo, nprocs))
+        return;
+    for (const int *g = todo.begin(); g != todo.end(); ++g)
+        compute_one(*g);
+}
+
+void
+GlyphBoundsTable::compute_all(int nprocs)
+{
+    Vector<int> glyphs;
+    for (int g = 0; g < _state.size(); ++g)
+        glyphs.push_back(g);
+    compute(glyphs, nprocs);
+}
+
+#if GLYPHBOUNDS_PARALLEL
+namespace {
+// Each child process reports one record per glyph in its slice.
+struct BoundsRecord {
+    double v[5];
+    uint8_t ok;
+};
+}
+#endif
+
+bool
+GlyphBoundsTable::compute_parallel(const Vector<int> &glyphs, int nprocs)
+{
+#if GLYPHBOUNDS_PARALLEL
+    // Forking costs more than interpreting a few hundred glyphs, so only
+    // split large jobs.
+    const int min_slice = 512;
+    if (nprocs > glyphs.size() / min_slice)
+        nprocs = glyphs.size() / min_slice;
+    if (nprocs <= 1)
+        return false;
+
+    // The parent computes the first slice itself; children compute the
+    // rest and send their results back through pipes.
+    Vector<int> fds(nprocs, -1);
+    Vector<pid_t> pids(nprocs, -1);
+    for (int p = 1; p < nprocs; ++p) {
+        int pipefd[2];
+        if (pipe(pipefd) != 0)
+            break;
+        pid_t child = fork();
+        if (child < 0) {
+            close(pipefd[0]);
+            close(pipefd[1]);
+            break;
+        } else if (child == 0) {
+            close(pipefd[0]);
+            int first = glyphs.size() * p / nprocs;
+            int last = glyphs.size() * (p + 1) / nprocs;
+            Vector<BoundsRecord> recs(last - first, BoundsRecord());
+            for (int i = first; i < last; ++i) {
+                int g = glyphs[i];
+                compute_one(g);
+                BoundsRecord &r = recs[i - first];
+                r.v[0] = _xmin[g];
+                r.v[1] = _ymin[g];
+                r.v[2] = _xmax[g];
+                r.v[3] = _ymax[g];
+                r.v[4] = _width[g];
+                r.ok = _state[g];
+            }
+            bool ok = write_fd_data(pipefd[1], reinterpret_cast<const char *>(recs.begin()), recs.size() * sizeof(BoundsRecord));
+            _exit(ok ? 0 : 1);
+        }
+        close(pipefd[1]);
+        fds[p] = pipefd[0];
+        pids[p] = child;
+    }
+
+    for (int i = 0; i < glyphs.size() / nprocs; ++i)
+        compute_one(glyphs[i]);
+
+    // Collect results.  Glyphs whose child failed are computed here.
+    for (int p = 1; p < nprocs; ++p) {
+        int first = glyphs.size() * p / nprocs;
+        int last = glyphs.size() * (p + 1) / nprocs;
+        int got = 0;
+        if (fds[p] >= 0) {
+            Vector<BoundsRecord> recs(last - first, BoundsRecord());
+            size_t len = read_fd_data(fds[p], reinterpret_cast<char *>(recs.begin()), recs.size() * sizeof(BoundsRecord));
+            close(fds[p]);
+            // only trust the records of a child that exited cleanly
+            int status = 0;
+            pid_t w;
+            while ((w = waitpid(pids[p], &status, 0)) < 0 && errno == EINTR)
+                /* nada */;
+            if (w == pids[p] && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                for (got = 0; got < (int) (len / sizeof(BoundsRecord)); ++got) {
+                    const BoundsRecord &r = recs[got];
+                    int g = glyphs[first + got];
+                    set(g, r.v, r.v[4], r.ok == s_ok);
+                }
+        }
+        for (int i = first + got; i < last; ++i)
+            compute_one(glyphs[i]);
+    }
+    return true;
+#else
+    (void) glyphs, (void) nprocs;
+    return false;
+#endif
+}
+
 } // namespace Efont
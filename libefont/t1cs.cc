@@ -115,7 +115,7 @@ Type1Charstring::Type1Charstring(int lenIV, const String &s)
         const unsigned char *d = reinterpret_cast<const unsigned char*>(s.data());
         _key = t1R_cs;
         for (int i = 0; i < lenIV; i++, d++)
-            _key = ((*d + _key) * t1C1 + t1C2) & 0xFFFF;
+            _key = ((unsigned) (*d + _key) * t1C1 + t1C2) & 0xFFFF;
         _s = s.substring(lenIV);
     }
 }
@@ -139,7 +139,7 @@ Type1Charstring::decrypt() const
         for (int i = 0; i < _s.length(); i++, d++) {
             uint8_t encrypted = *d;
             *d = encrypted ^ (r >> 8);
-            r = ((encrypted + r) * t1C1 + t1C2) & 0xFFFF;
+            r = ((unsigned) (encrypted + r) * t1C1 + t1C2) & 0xFFFF;
         }
         _key = -1;
     }
@@ -259,8 +259,8 @@ Type1Charstring::assign_substring(int pos, int len, const String &cs)
 bool
 Type2Charstring::process(CharstringInterp &interp) const
 {
-    const uint8_t *data = Type2Charstring::data();
-    int left = _s.length();
+    const uint8_t *data = _data;
+    int left = _len;
 
     while (left > 0) {
         bool more;
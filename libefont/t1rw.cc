@@ -45,7 +45,8 @@ Type1Reader::static_initialize()
 
 Type1Reader::Type1Reader()
     : _data(new unsigned char[DATA_SIZE]), _len(0), _pos(0),
-      _ungot(-1), _eexec(false)
+      _ungot(-1), _eexec(false),
+      _edata(new unsigned char[DATA_SIZE]), _elen(0), _epos(0), _eraw(0)
 {
     static_initialize();
 }
@@ -53,6 +54,7 @@ Type1Reader::Type1Reader()
 Type1Reader::~Type1Reader()
 {
     delete[] _data;
+    delete[] _edata;
 }
 
 
@@ -86,7 +88,8 @@ Type1Reader::switch_eexec(bool on, unsigned char *data, int len)
         memcpy(_data + _pos - len, data, len);
         _pos -= len;
         start_eexec(original_pos - _pos);
-    }
+    } else if (_eexec)
+        eexec_rewind();
     _eexec = on;
 }
 
@@ -117,7 +120,7 @@ inline int
 Type1Reader::eexec(int c)
 {
     unsigned char answer = (unsigned char)(c ^ (_r >> 8));
-    _r = (((unsigned char)c + _r) * t1C1 + t1C2) & 0xFFFF;
+    _r = ((unsigned) ((unsigned char)c + _r) * t1C1 + t1C2) & 0xFFFF;
     return answer;
 }
 
@@ -139,20 +142,118 @@ Type1Reader::ascii_eexec_get()
 }
 
 
-inline int
-Type1Reader::get()
+// Decrypt (and, for ASCII eexec, hex-decode) as much of the current buffer
+// as fits into _edata in one pass, and return the first decrypted byte.
+// A hex digit pair split across buffers is left to ascii_eexec_get().
+int
+Type1Reader::eexec_fill()
 {
-    if (!_eexec)
-        return get_base();
+    _epos = _elen = 0;
+    if (_pos >= _len) {
+        if (more_data() < 0)
+            return -1;
+        _pos--;                 // more_data() consumed the first byte
+    }
+    _eraw = _pos;
+
+    const unsigned char *s = _data + _pos;
+    const unsigned char *end = _data + _len;
+    unsigned char *o = _edata;
+    int r = _r;
+
+    if (_binary_eexec) {
+        if (end - s > DATA_SIZE)
+            end = s + DATA_SIZE;
+        for (; s < end; ++s, ++o) {
+            *o = *s ^ (r >> 8);
+            r = ((unsigned) (*s + r) * t1C1 + t1C2) & 0xFFFF;
+        }
+    } else {
+        unsigned char *oend = _edata + DATA_SIZE;
+        while (o < oend) {
+            const unsigned char *d1 = s, *d2 = s + 1;
+            // whitespace characters are all <= ' '
+            if (d2 >= end || *d1 <= ' ' || *d2 <= ' ') {
+                while (d1 < end && isspace(*d1))
+                    d1++;
+                for (d2 = d1 + 1; d2 < end && isspace(*d2); d2++)
+                    /* nada */;
+                if (d2 >= end)
+                    break;
+            }
+            unsigned char c = (xvalue[*d1] << 4) | xvalue[*d2];
+            *o++ = c ^ (r >> 8);
+            r = ((unsigned) (c + r) * t1C1 + t1C2) & 0xFFFF;
+            s = d2 + 1;
+        }
+    }
 
-    else if (_binary_eexec) {
+    _pos = s - _data;
+    _r = r;
+    _elen = o - _edata;
+    if (_elen > 0) {
+        _epos = 1;
+        return _edata[0];
+    } else if (_binary_eexec) {
         int c = get_base();
         return c < 0 ? c : eexec(c);
-
     } else
         return ascii_eexec_get();
 }
 
+// Leaving eexec: return any decrypted but unread bytes to the raw buffer.
+void
+Type1Reader::eexec_rewind()
+{
+    if (_epos < _elen) {
+        if (_binary_eexec)
+            _pos = _eraw + _epos;
+        else {
+            const unsigned char *s = _data + _eraw;
+            for (int i = 0; i < _epos; i++) {
+                while (isspace(*s))
+                    s++;
+                for (s++; isspace(*s); s++)
+                    /* nada */;
+                s++;
+            }
+            _pos = s - _data;
+        }
+    }
+    _epos = _elen = 0;
+}
+
+
+inline int
+Type1Reader::get()
+{
+    if (!_eexec)
+        return get_base();
+    else if (_epos < _elen)
+        return _edata[_epos++];
+    else
+        return eexec_fill();
+}
+
+// Append the buffered bytes up to the next line ending to s.
+inline void
+Type1Reader::append_run(StringAccum &s)
+{
+    unsigned char *p, *end;
+    int *pos;
+    if (!_eexec)
+        p = _data + _pos, end = _data + _len, pos = &_pos;
+    else
+        p = _edata + _epos, end = _edata + _elen, pos = &_epos;
+    unsigned char *q = p;
+    while (q < end && *q != '\n' && *q != '\r')
+        q++;
+    if (q > p) {
+        s.append(p, q - p);
+        *pos += q - p;
+    }
+}
+
 
 void
 Type1Reader::start_eexec(int initial_ascii)
@@ -248,10 +349,10 @@ Type1Reader::test_charstring(StringAccum &str)
 }
 
 
-/* PERFORMANCE NOTE: All kinds of speedup tricks tried with eexec -- buffering
-   (doing eexec processing at more_data time), etc., and all this stuff -- and
-   found to have essentially zero effect for PFB fonts. Now, it might be
-   effective for PFAs; but who cares? I hate PFAs. */
+/* PERFORMANCE NOTE: eexec data is decrypted a buffer at a time by
+   eexec_fill(), and next_line() copies runs of ordinary characters straight
+   out of the buffer, so the per-character loop below only sees line
+   endings. */
 
 bool
 Type1Reader::next_line(StringAccum &s)
@@ -291,6 +392,7 @@ Type1Reader::next_line(StringAccum &s)
           normal:
           default:
             s.append((char)c);
+            append_run(s);
             break;
 
         }
@@ -315,11 +417,27 @@ Type1Reader::get_data(unsigned char *data, int len)
         _ungot = -1;
     }
 
-    for (; pos < len; pos++) {
-        int c = get();
-        if (c < 0)
-            break;
-        *data++ = c;
+    while (pos < len) {
+        const unsigned char *src;
+        int avail;
+        if (!_eexec)
+            src = _data + _pos, avail = _len - _pos;
+        else
+            src = _edata + _epos, avail = _elen - _epos;
+        if (avail > 0) {
+            if (avail > len - pos)
+                avail = len - pos;
+            memcpy(data, src, avail);
+            (_eexec ? _epos : _pos) += avail;
+            data += avail;
+            pos += avail;
+        } else {
+            int c = get();
+            if (c < 0)
+                break;
+            *data++ = c;
+            pos++;
+        }
     }
 
     return pos;
@@ -439,7 +557,7 @@ inline unsigned char
 Type1Writer::eexec(int p)
 {
     unsigned char c = ((unsigned char)p ^ (_r >> 8)) & 0xFF;
-    _r = ((c + _r) * t1C1 + t1C2) & 0xFFFF;
+    _r = ((unsigned) (c + _r) * t1C1 + t1C2) & 0xFFFF;
     return c;
 }
 
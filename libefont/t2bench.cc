@@ -0,0 +1,147 @@
+/* t2bench.cc -- compare virtual and specialized Type 2 interpretation
+ *
+ * Copyright (c) 2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+/* Not installed; build it with `make -C libefont t2bench' and run
+ * `libefont/t2bench FONT.otf [REPS]'.  For each glyph of the font's CFF, it
+ * first checks that CharstringInterp::interpret() and
+ * Type2Interp::fast_interpret() report the same bounds, width, and error.
+ * It then reports the best time per glyph over REPS runs (default 9) of each
+ * path, for a sink that only consumes path segments and for
+ * CharstringBounds. */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/t1bounds.hh>
+#include <efont/cff.hh>
+#include <efont/otf.hh>
+#include <lcdf/error.hh>
+#include <lcdf/mapfile.hh>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+using namespace Efont;
+
+// Consumes path segments without computing anything expensive, so the
+// timings measure interpretation overhead.
+class PathSink : public Type2Interp<PathSink> { public:
+
+    PathSink()                          : _sum(0) { }
+
+    double sum() const                  { return _sum; }
+
+    void act_line(int, const Point &a, const Point &b) {
+        _sum += a.x + b.y;
+    }
+    void act_curve(int, const Point &a, const Point &, const Point &, const Point &d) {
+        _sum += a.x + d.y;
+    }
+
+  private:
+
+    double _sum;
+
+};
+
+static int
+count_mismatches(const Cff::Font *font, const Transform &xf)
+{
+    int bad = 0;
+    for (int g = 0; g < font->nglyphs(); g++) {
+        CharstringBounds a(xf), b(xf);
+        a.interpret(font->glyph_context(g));
+        b.fast_interpret(font->glyph_context(g));
+        double abb[4], bbb[4], awidth, bwidth;
+        a.output(abb, awidth, true);
+        b.output(bbb, bwidth, true);
+        if (a.error() != b.error()
+            || (a.error() != CharstringInterp::errOK
+                && a.error_data() != b.error_data())
+            || awidth != bwidth || memcmp(abb, bbb, sizeof(abb)) != 0) {
+            if (!bad)
+                fprintf(stderr, "glyph %d: results differ\n", g);
+            bad++;
+        }
+    }
+    return bad;
+}
+
+template <typename T>
+static double
+time_pass(T &interp, const Cff::Font *font, bool fast)
+{
+    clock_t start = clock();
+    for (int g = 0; g < font->nglyphs(); g++) {
+        if (fast)
+            interp.fast_interpret(font->glyph_context(g));
+        else
+            interp.interpret(font->glyph_context(g));
+    }
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s FONT.otf [REPS]\n", argv[0]);
+        exit(1);
+    }
+    int reps = (argc == 3 ? atoi(argv[2]) : 9);
+    ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(argv[0]) + ": "));
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f)
+        errh->fatal("%s: %s", argv[1], strerror(errno));
+    String data = read_file_data(f);
+    fclose(f);
+
+    OpenType::Font otf(data, errh);
+    if (!otf.ok())
+        exit(1);
+    Cff cff(otf.table("CFF"), otf.units_per_em(), errh);
+    Cff::Font *font = static_cast<Cff::Font *>(cff.font(PermString(), errh));
+    if (!cff.ok() || !font || !font->ok())
+        errh->fatal("%s: no usable CFF font", argv[1]);
+    int n = font->nglyphs();
+
+    // an oblique transform, as otftotfm uses for slanted fonts
+    Transform xf;
+    xf.shear(0.2);
+    int bad = count_mismatches(font, xf);
+
+    double sink = 0, path_best[2] = {1e9, 1e9}, bounds_best[2] = {1e9, 1e9};
+    for (int r = 0; r < reps; r++)
+        for (int fast = 0; fast < 2; fast++) {
+            PathSink p;
+            double t = time_pass(p, font, fast);
+            path_best[fast] = (t < path_best[fast] ? t : path_best[fast]);
+            sink += p.sum();
+
+            CharstringBounds b(xf);
+            t = time_pass(b, font, fast);
+            bounds_best[fast] = (t < bounds_best[fast] ? t : bounds_best[fast]);
+            sink += b.bb_right();
+        }
+
+    printf("%s: %d glyphs, %d mismatches\n", argv[1], n, bad);
+    printf("  path-only sink    virtual %8.1f ns/glyph  fast %8.1f ns/glyph  (%.2fx)\n",
+           path_best[0] / n * 1e9, path_best[1] / n * 1e9,
+           path_best[0] / path_best[1]);
+    printf("  CharstringBounds  virtual %8.1f ns/glyph  fast %8.1f ns/glyph  (%.2fx)\n",
+           bounds_best[0] / n * 1e9, bounds_best[1] / n * 1e9,
+           bounds_best[0] / bounds_best[1]);
+    return (bad || sink != sink ? 1 : 0);
+}
@@ -0,0 +1,149 @@
+// -*- related-file-name: "../include/lcdf/mapfile.hh" -*-
+
+/* mapfile.{cc,hh} -- read files, memory-mapping them when possible; move
+ * data through file descriptors
+ *
+ * Copyright (c) 2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <lcdf/mapfile.hh>
+#include <lcdf/straccum.hh>
+#include <errno.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+static void
+unmap_file_data(void *data, int len, void *)
+{
+    munmap(data, len);
+}
+
+static String
+map_file_data(FILE *f)
+{
+    struct stat s;
+    int fd = fileno(f);
+    if (fd < 0 || fstat(fd, &s) < 0 || !S_ISREG(s.st_mode)
+	|| s.st_size <= 0 || s.st_size >= INT_MAX
+	|| ftell(f) != 0)
+	return String();
+    void *data = mmap(0, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+	return String();
+    return String::make_external(data, s.st_size, unmap_file_data, 0);
+}
+#endif
+
+/** @brief Return the remaining contents of @a f.
+ * @param f file
+ * @param[out] errp if nonnull, set to 0 on success or an errno value on error
+ *
+ * If @a f is a regular file positioned at its beginning, the result
+ * references a read-only memory mapping of the file.  No data is copied, and
+ * the operating system reads file pages only as they are accessed.
+ * Otherwise, @a f is read in the usual way.  On error, the result holds the
+ * data read before the error.  The caller remains responsible for closing
+ * @a f. */
+String
+read_file_data(FILE *f, int *errp)
+{
+#if HAVE_MMAP && HAVE_SYS_MMAN_H
+    if (String s = map_file_data(f)) {
+	if (errp)
+	    *errp = 0;
+	return s;
+    }
+#endif
+
+    StringAccum sa;
+    int amt;
+    do {
+	if (char *x = sa.reserve(32768)) {
+	    amt = fread(x, 1, 32768, f);
+	    sa.adjust_length(amt);
+	} else
+	    amt = 0;
+    } while (amt != 0);
+    if (errp)
+	*errp = (!feof(f) || ferror(f) ? (errno ? errno : EIO) : 0);
+    return sa.take_string();
+}
+
+#if HAVE_UNISTD_H
+/** @brief Write @a len bytes from @a s to file descriptor @a fd.
+ * @return true on success, false on error
+ *
+ * Short writes and EINTR are retried.  Useful for pipes, where a single
+ * write() may transfer only part of the data. */
+bool
+write_fd_data(int fd, const char *s, size_t len)
+{
+    while (len > 0) {
+	ssize_t w = write(fd, s, len);
+	if (w < 0 && errno != EINTR)
+	    return false;
+	else if (w > 0)
+	    s += w, len -= w;
+    }
+    return true;
+}
+
+/** @brief Read up to @a len bytes from file descriptor @a fd into @a s.
+ * @return the number of bytes read
+ *
+ * Reads until @a len bytes arrive, end of file, or an error other than
+ * EINTR. */
+size_t
+read_fd_data(int fd, char *s, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+	ssize_t r = read(fd, s + pos, len - pos);
+	if (r < 0 && errno != EINTR)
+	    break;
+	else if (r == 0)
+	    break;
+	else if (r > 0)
+	    pos += r;
+    }
+    return pos;
+}
+
+/** @brief Return the remaining data on file descriptor @a fd.
+ *
+ * Reads until end of file or an error other than EINTR. */
+String
+read_fd_data(int fd)
+{
+    StringAccum sa;
+    while (char *x = sa.reserve(65536)) {
+	ssize_t r = read(fd, x, 65536);
+	if (r < 0 && errno != EINTR)
+	    break;
+	else if (r == 0)
+	    break;
+	else if (r > 0)
+	    sa.adjust_length(r);
+    }
+    return sa.take_string();
+}
+#endif
@@ -130,6 +130,12 @@ String::create_memo(char *space, int dirty, int capacity)
 void
 String::delete_memo(memo_t *memo)
 {
+    if (memo->capacity == 0) {
+	external_memo_t *ememo = reinterpret_cast<external_memo_t *>(memo);
+	ememo->free_function(ememo->data, ememo->length, ememo->free_argument);
+	delete ememo;
+	return;
+    }
     assert(memo->capacity > 0);
     assert(memo->capacity >= memo->dirty);
 #if HAVE_STRING_PROFILING
@@ -267,6 +273,23 @@ String::make_stable(const char *s, int len)
     return String(s, len, 0);
 }
 
+String
+String::make_external(void *data, int len,
+		      void (*free_function)(void *, int, void *),
+		      void *free_argument)
+{
+    assert(data && len > 0 && free_function);
+    external_memo_t *ememo = new external_memo_t;
+    ememo->memo.refcount = 0;
+    ememo->memo.capacity = 0;
+    ememo->memo.dirty = 0;
+    ememo->data = data;
+    ememo->length = len;
+    ememo->free_function = free_function;
+    ememo->free_argument = free_argument;
+    return String(reinterpret_cast<const char *>(data), len, &ememo->memo);
+}
+
 String
 String::make_fill(int c, int len)
 {
@@ -303,6 +326,12 @@ String::assign(const char *s, int len, bool need_deref)
 	    _r.data = s;
 	    _r.length = len;
 	    return;
+	} else if (unlikely(_r.memo && !_r.memo->capacity)) {
+	    // Be careful about "String s = external; s = s.data();"
+	    String preserve_s(*this);
+	    deref();
+	    assign(s, len, false);
+	    return;
 	} else
 	    deref();
     }
@@ -404,8 +433,9 @@ String::append(const char *s, int len, memo_t *memo)
 	deref();
 	assign_memo(s, len, memo);
     } else if (likely(!(_r.memo
-			&& s >= _r.memo->real_data
-			&& s + len <= _r.memo->real_data + _r.memo->capacity))) {
+			&& (!_r.memo->capacity
+			    || (s >= _r.memo->real_data
+				&& s + len <= _r.memo->real_data + _r.memo->capacity))))) {
 	if (char *space = append_uninitialized(len))
 	    memcpy(space, s, len);
     } else {
@@ -429,14 +459,14 @@ String::append_fill(int c, int len)
 char *
 String::mutable_data()
 {
-    // If _memo has a capacity (it's not one of the special strings) and it's
-    // uniquely referenced, return _data right away.
-    if (_r.memo && _r.memo->refcount == 1)
+    // If _memo has a capacity (it's not one of the special strings or an
+    // external string) and it's uniquely referenced, return _data right away.
+    if (_r.memo && _r.memo->refcount == 1 && _r.memo->capacity)
 	return const_cast<char *>(_r.data);
 
     // Otherwise, make a copy of it. Rely on: deref() doesn't change _data or
     // _length; and if _capacity == 0, then deref() doesn't free _real_data.
-    assert(!_r.memo || _r.memo->refcount > 1);
+    assert(!_r.memo || _r.memo->refcount > 1 || !_r.memo->capacity);
     // But in multithreaded situations we must hold a local copy of memo!
     String do_not_delete_underlying_memo(*this);
     deref();
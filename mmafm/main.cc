@@ -43,6 +43,7 @@
 #define OUTPUT_OPT	310
 #define PRECISION_OPT	311
 #define KERN_PREC_OPT	312
+#define CACHE_DIR_OPT	313
 
 const Clp_Option options[] = {
   { "1", '1', N1_OPT, Clp_ValDouble, 0 },
@@ -60,6 +61,7 @@ const Clp_Option options[] = {
   { "kern-precision", 'k', KERN_PREC_OPT, Clp_ValDouble, 0 },
   { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
   { "precision", 'p', PRECISION_OPT, Clp_ValInt, 0 },
+  { "cache-directory", 0, CACHE_DIR_OPT, Clp_ValString, Clp_Optional },
   { "version", 'v', VERSION_OPT, 0, 0 },
   { "help", 'h', HELP_OPT, 0, 0 },
 };
@@ -236,6 +238,8 @@ General options:\n\
   -o, --output=FILE             Write output to FILE.\n\
   -h, --help                    Print this message and exit.\n\
   -v, --version                 Print version number and warranty and exit.\n\
+      --cache-directory[=DIR]   Compile AFM files into DIR (default beside\n\
+                                each AFM file) and reuse them on later runs.\n\
 \n\
 Interpolation settings:\n\
   -w, --weight=N                Set weight to N.\n\
@@ -304,6 +308,10 @@ main(int argc, char *argv[])
       kern_precision = clp->val.d;
       break;
 
+     case CACHE_DIR_OPT:
+      MetricsFinder::set_compiled_metrics(true, clp->have_val ? String(clp->vstr) : String());
+      break;
+
      case OUTPUT_OPT:
       if (output_file) errh->fatal("output file already specified");
       if (strcmp(clp->vstr, "-") == 0)
@@ -24,6 +24,7 @@
 #include <efont/cff.hh>
 #include <lcdf/clp.h>
 #include <lcdf/error.hh>
+#include <lcdf/mapfile.hh>
 #include <lcdf/straccum.hh>
 #include <stdlib.h>
 #include <string.h>
@@ -48,6 +49,7 @@ using namespace Efont;
 #define QUIET_OPT		303
 #define VERBOSE_OPT		304
 #define SCRIPT_OPT		305
+#define FACE_OPT		306
 
 #define QUERY_SCRIPTS_OPT	320
 #define QUERY_FEATURES_OPT	321
@@ -63,6 +65,7 @@ using namespace Efont;
 
 const Clp_Option options[] = {
     { "script", 0, SCRIPT_OPT, Clp_ValString, 0 },
+    { "face", 0, FACE_OPT, Clp_ValUnsigned, 0 },
     { "quiet", 'q', QUIET_OPT, 0, Clp_Negate },
     { "verbose", 'V', VERBOSE_OPT, 0, Clp_Negate },
     { "features", 'f', QUERY_FEATURES_OPT, 0, 0 },
@@ -128,6 +131,7 @@ Query options:\n\
 \n\
 Other options:\n\
       --script=SCRIPT[.LANG]   Set script used for --features [latn].\n\
+      --face=N                 Use face N of font collections [all faces].\n\
   -V, --verbose                Print progress information to standard error.\n\
   -h, --help                   Print this message and exit.\n\
   -q, --quiet                  Do not generate any error messages.\n\
@@ -159,20 +163,12 @@ read_file(String filename, ErrorHandler *errh, bool warning = false)
 	return String();
     }
 
-    StringAccum sa;
-    int amt;
-    do {
-	if (char *x = sa.reserve(8192)) {
-	    amt = fread(x, 1, 8192, f);
-	    sa.adjust_length(amt);
-	} else
-	    amt = 0;
-    } while (amt != 0);
-    if (!feof(f) || ferror(f))
-	errh->xmessage(error_anno, strerror(errno));
+    String s = read_file_data(f, &f_errno);
+    if (f_errno)
+	errh->xmessage(error_anno, strerror(f_errno));
     if (f != stdin)
 	fclose(f);
-    return sa.take_string();
+    return s;
 }
 
 String
@@ -584,6 +580,7 @@ main(int argc, char *argv[])
     Vector<const char *> input_files;
     OpenType::Tag dump_table;
     int query = 0;
+    int face = -1;
 
     while (1) {
 	int opt = Clp_Next(clp);
@@ -609,6 +606,10 @@ main(int argc, char *argv[])
 	      break;
 	  }
 
+	  case FACE_OPT:
+	    face = clp->val.u;
+	    break;
+
 	  case QUERY_SCRIPTS_OPT:
 	  case QUERY_FEATURES_OPT:
 	  case QUERY_OPTICAL_SIZE_OPT:
@@ -689,36 +690,46 @@ particular purpose.\n");
 	if (errh->nerrors() != before_nerrors)
 	    continue;
 
-	String input_file = printable_filename(*input_filep);
-	LandmarkErrorHandler cerrh(errh, input_file);
-	OpenType::Font otf(font_data, &cerrh);
-	if (!otf.ok())
-	    continue;
-
-	PrefixErrorHandler stdout_cerrh(&stdout_errh, input_file + ":");
-	ErrorHandler *result_errh = (input_files.size() > 1 ? static_cast<ErrorHandler *>(&stdout_cerrh) : static_cast<ErrorHandler *>(&stdout_errh));
-	if (query == QUERY_SCRIPTS_OPT)
-	    do_query_scripts(otf, &cerrh, result_errh);
-	else if (query == QUERY_FEATURES_OPT)
-	    do_query_features(otf, &cerrh, result_errh);
-	else if (query == QUERY_OPTICAL_SIZE_OPT)
-	    do_query_optical_size(otf, &cerrh, result_errh);
-	else if (query == QUERY_POSTSCRIPT_NAME_OPT)
-	    do_query_postscript_name(otf, &cerrh, result_errh);
-	else if (query == QUERY_GLYPHS_OPT)
-	    do_query_glyphs(otf, &cerrh, result_errh);
-	else if (query == QUERY_UNICODE_OPT)
-	    do_query_unicode(otf, &cerrh, result_errh);
-	else if (query == QUERY_FAMILY_OPT)
-	    do_query_family_name(otf, &cerrh, result_errh);
-	else if (query == QUERY_FVERSION_OPT)
-	    do_query_font_version(otf, &cerrh, result_errh);
-	else if (query == TABLES_OPT)
-	    do_tables(otf, &cerrh, result_errh);
-	else if (query == DUMP_TABLE_OPT)
-	    do_dump_table(otf, dump_table, &cerrh);
-	else if (query == INFO_OPT)
-	    do_info(otf, &cerrh, result_errh);
+	// report every face of a collection unless --face says otherwise
+	bool collection = OpenType::Font::is_collection(font_data);
+	int face_begin = (face >= 0 ? face : 0);
+	int face_end = face_begin + 1;
+	if (face < 0 && collection && OpenType::Font::nfaces(font_data) > 1)
+	    face_end = OpenType::Font::nfaces(font_data);
+	for (int f = face_begin; f < face_end; ++f) {
+	    String input_file = printable_filename(*input_filep);
+	    if (collection)
+		input_file += "(" + String(f) + ")";
+	    LandmarkErrorHandler cerrh(errh, input_file);
+	    OpenType::Font otf(font_data, &cerrh, f);
+	    if (!otf.ok())
+		break;
+
+	    PrefixErrorHandler stdout_cerrh(&stdout_errh, input_file + ":");
+	    ErrorHandler *result_errh = (input_files.size() > 1 || face_end - face_begin > 1 ? static_cast<ErrorHandler *>(&stdout_cerrh) : static_cast<ErrorHandler *>(&stdout_errh));
+	    if (query == QUERY_SCRIPTS_OPT)
+		do_query_scripts(otf, &cerrh, result_errh);
+	    else if (query == QUERY_FEATURES_OPT)
+		do_query_features(otf, &cerrh, result_errh);
+	    else if (query == QUERY_OPTICAL_SIZE_OPT)
+		do_query_optical_size(otf, &cerrh, result_errh);
+	    else if (query == QUERY_POSTSCRIPT_NAME_OPT)
+		do_query_postscript_name(otf, &cerrh, result_errh);
+	    else if (query == QUERY_GLYPHS_OPT)
+		do_query_glyphs(otf, &cerrh, result_errh);
+	    else if (query == QUERY_UNICODE_OPT)
+		do_query_unicode(otf, &cerrh, result_errh);
+	    else if (query == QUERY_FAMILY_OPT)
+		do_query_family_name(otf, &cerrh, result_errh);
+	    else if (query == QUERY_FVERSION_OPT)
+		do_query_font_version(otf, &cerrh, result_errh);
+	    else if (query == TABLES_OPT)
+		do_tables(otf, &cerrh, result_errh);
+	    else if (query == DUMP_TABLE_OPT)
+		do_dump_table(otf, dump_table, &cerrh);
+	    else if (query == INFO_OPT)
+		do_info(otf, &cerrh, result_errh);
+	}
     }
 
     return (errh->nerrors() == 0 ? 0 : 1);
@@ -33,6 +33,9 @@
 #endif
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
+#include <efont/maket1font.hh>
+#include <efont/t1font.hh>
+#include <efont/t1rw.hh>
 #if HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
@@ -64,6 +67,8 @@ static String odir[NUMODIR];
 static String typeface;
 static String vendor;
 static String map_file;
+static int shared_lock_fd = -1;
+static int shared_lock_depth = 0;
 #define DEFAULT_VENDOR "lcdftools"
 #define DEFAULT_TYPEFACE "unknown"
 
@@ -312,6 +317,16 @@ update_odir(int o, String file, ErrorHandler *errh)
     bool success = false;
     if (access(ls_r.c_str(), R_OK) >= 0) // make sure it already exists
 	if (FILE *f = fopen(ls_r.c_str(), "a")) {
+#if defined(F_SETLKW)
+	    // concurrent otftotfm processes may be updating ls-R too
+	    struct flock lock;
+	    lock.l_type = F_WRLCK;
+	    lock.l_whence = SEEK_SET;
+	    lock.l_start = 0;
+	    lock.l_len = 0;
+	    while (fcntl(fileno(f), F_SETLKW, &lock) < 0 && errno == EINTR)
+		/* try again */;
+#endif
 	    fprintf(f, "./%s:\n%s\n", directory.c_str(), file.c_str());
 	    success = true;
 	    fclose(f);
@@ -350,17 +365,93 @@ set_map_file(const String &s)
     return !had;
 }
 
+void
+set_shared_lock_fd(int fd)
+{
+    shared_lock_fd = fd;
+}
+
+static void
+shared_lock_fcntl(int type)
+{
+#if defined(F_SETLKW)
+    struct flock lock;
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    while (fcntl(shared_lock_fd, F_SETLKW, &lock) < 0 && errno == EINTR)
+	/* try again */;
+#else
+    (void) type;
+#endif
+}
+
+// Holds the shared lock, if any, while this process installs fonts or
+// runs updmap, so that concurrent batch jobs don't generate the same
+// font twice. Nested locks are allowed.
+class SharedLock { public:
+    SharedLock() {
+	if (shared_lock_fd >= 0 && shared_lock_depth++ == 0)
+	    shared_lock_fcntl(F_WRLCK);
+    }
+    ~SharedLock() {
+	if (shared_lock_fd >= 0 && --shared_lock_depth == 0)
+	    shared_lock_fcntl(F_UNLCK);
+    }
+};
+
+#if HAVE_AUTO_CFFTOT1
+static bool
+write_type1(const Efont::Cff::Font *cff, const String &pfb_filename, ErrorHandler *errh)
+{
+    if (no_create) {
+	errh->message("would create %s", pfb_filename.c_str());
+	return true;
+    }
+    if (verbose)
+	errh->message("creating %s", pfb_filename.c_str());
+
+    int nerrors = errh->nerrors();
+    ContextErrorHandler cerrh(errh, "While converting %s to Type 1:", String(cff->font_name()).c_str());
+    cerrh.set_indent(0);
+    Efont::Type1Font *font1 = Efont::create_type1_font(cff, &cerrh);
+    if (errh->nerrors() != nerrors) {
+	delete font1;
+	return false;
+    }
+
+    FILE *f = fopen(pfb_filename.c_str(), "wb");
+    if (!f) {
+	errh->error("%s: %s", pfb_filename.c_str(), strerror(errno));
+	delete font1;
+	return false;
+    }
+    {
+	Efont::Type1PFBWriter w(f);
+	font1->write(w);
+    }
+    delete font1;
+    if (ferror(f) || fclose(f) != 0) {
+	errh->error("%s: %s", pfb_filename.c_str(), strerror(errno));
+	return false;
+    }
+    return true;
+}
+#endif
+
 String
-installed_type1(const String &otf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
+installed_type1(const Efont::Cff::Font *cff, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
 {
-    (void) otf_filename, (void) allow_generate, (void) errh;
+    (void) cff, (void) allow_generate, (void) errh;
 
     if (!ps_fontname)
 	return String();
+    SharedLock lock;
 
 #if HAVE_KPATHSEA
 # if HAVE_AUTO_CFFTOT1
-    if (!(force && allow_generate && otf_filename && otf_filename != "-" && getodir(O_TYPE1, errh))) {
+    if (!(force && allow_generate && cff && getodir(O_TYPE1, errh))) {
 # endif
 	// look for .pfb and .pfa
 	String file, path;
@@ -381,20 +472,11 @@ installed_type1(const String &otf_filename, const String &ps_fontname, bool allo
 #endif
 
 #if HAVE_AUTO_CFFTOT1
-    // if not found, and can generate on the fly, run cfftot1
-    if (allow_generate && otf_filename && otf_filename != "-" && getodir(O_TYPE1, errh)) {
+    // if not found, and can generate on the fly, convert the CFF font
+    // we already parsed (this is what cfftot1 would do)
+    if (allow_generate && cff && getodir(O_TYPE1, errh)) {
 	String pfb_filename = odir[O_TYPE1] + "/" + ps_fontname + ".pfb";
-	if (pfb_filename.find_left('\'') >= 0 || otf_filename.find_left('\'') >= 0)
-	    return String();
-	String command = "cfftot1 " + shell_quote(otf_filename) + " -n " + shell_quote(ps_fontname) + " " + shell_quote(pfb_filename);
-	int retval = mysystem(command.c_str(), errh);
-	if (retval == 127)
-	    errh->error("could not run %<%s%>", command.c_str());
-	else if (retval < 0)
-	    errh->error("could not run %<%s%>: %s", command.c_str(), strerror(errno));
-	else if (retval != 0)
-	    errh->error("%<%s%> failed", command.c_str());
-	if (retval == 0) {
+	if (write_type1(cff, pfb_filename, errh)) {
 	    update_odir(O_TYPE1, pfb_filename, errh);
 	    return pfb_filename;
 	}
@@ -405,14 +487,15 @@ installed_type1(const String &otf_filename, const String &ps_fontname, bool allo
 }
 
 String
-installed_type1_dotlessj(const String &otf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
+installed_type1_dotlessj(const Efont::Cff::Font *cff, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
 {
-    (void) otf_filename, (void) allow_generate, (void) errh;
+    (void) cff, (void) allow_generate, (void) errh;
 
     if (!ps_fontname)
 	return String();
     if (verbose)
 	errh->message("searching for dotless-j font for %s", ps_fontname.c_str());
+    SharedLock lock;
 
     String j_ps_fontname = ps_fontname + "LCDFJ";
 
@@ -442,7 +525,7 @@ installed_type1_dotlessj(const String &otf_filename, const String &ps_fontname,
 #if HAVE_AUTO_T1DOTLESSJ
     // if not found, and can generate on the fly, try running t1dotlessj
     if (allow_generate && getodir(O_TYPE1, errh)) {
-	if (String base_filename = installed_type1(otf_filename, ps_fontname, allow_generate, errh)) {
+	if (String base_filename = installed_type1(cff, ps_fontname, allow_generate, errh)) {
 	    String pfb_filename = odir[O_TYPE1] + "/" + j_ps_fontname + ".pfb";
 	    if (pfb_filename.find_left('\'') >= 0 || base_filename.find_left('\'') >= 0)
 		return String();
@@ -472,6 +555,7 @@ String
 installed_truetype(const String &ttf_filename, bool allow_generate, ErrorHandler *errh)
 {
     String file = pathname_filename(ttf_filename);
+    SharedLock lock;
 
 #if HAVE_KPATHSEA
     if (!(force && allow_generate && ttf_filename && ttf_filename != "-" && getodir(O_TRUETYPE, errh))) {
@@ -520,12 +604,13 @@ installed_truetype(const String &ttf_filename, bool allow_generate, ErrorHandler
 }
 
 String
-installed_type42(const String &ttf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
+installed_type42(const String &ttf_filename, int face, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
 {
-    (void) allow_generate, (void) ttf_filename, (void) errh;
+    (void) allow_generate, (void) ttf_filename, (void) face, (void) errh;
 
     if (!ps_fontname)
 	return String();
+    SharedLock lock;
 
 #if HAVE_KPATHSEA
 # if HAVE_AUTO_TTFTOTYPE42
@@ -554,7 +639,10 @@ installed_type42(const String &ttf_filename, const String &ps_fontname, bool all
 	String t42_filename = odir[O_TYPE42] + "/" + ps_fontname + ".t42";
 	if (t42_filename.find_left('\'') >= 0 || ttf_filename.find_left('\'') >= 0)
 	    return String();
-	String command = "ttftotype42 " + shell_quote(ttf_filename) + " " + shell_quote(t42_filename);
+	String command = "ttftotype42 ";
+	if (face)
+	    command += "--face=" + String(face) + " ";
+	command += shell_quote(ttf_filename) + " " + shell_quote(t42_filename);
 	int retval = mysystem(command.c_str(), errh);
 	if (retval == 127)
 	    errh->error("could not run %<%s%>", command.c_str());
@@ -691,6 +779,7 @@ update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
 
 #if HAVE_KPATHSEA && !WIN32
 	// run 'updmap' if present
+	SharedLock lock;
 	String updmap_dir, updmap_file;
 	if (automatic && (output_flags & G_UPDMAP))
 	    updmap_dir = getodir(O_MAP_PARENT, errh);
@@ -1,6 +1,7 @@
 #ifndef OTFTOTFM_AUTOMATIC_HH
 #define OTFTOTFM_AUTOMATIC_HH
 #include <lcdf/string.hh>
+#include <efont/cff.hh>
 class ErrorHandler;
 
 enum { O_ENCODING = 0, O_TFM, O_PL, O_VF, O_VPL, O_TYPE1, O_MAP, O_MAP_PARENT,
@@ -15,10 +16,11 @@ bool set_typeface(const String &, bool override);
 bool set_map_file(const String &);
 const char *odirname(int o);
 void update_odir(int o, String file, ErrorHandler *);
-String installed_type1(const String &otf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *);
-String installed_type1_dotlessj(const String &otf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *);
+String installed_type1(const Efont::Cff::Font *cff, const String &ps_fontname, bool allow_generate, ErrorHandler *);
+String installed_type1_dotlessj(const Efont::Cff::Font *cff, const String &ps_fontname, bool allow_generate, ErrorHandler *);
 String installed_truetype(const String &ttf_filename, bool allow_generate, ErrorHandler *errh);
-String installed_type42(const String &ttf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh);
+String installed_type42(const String &ttf_filename, int face, const String &ps_fontname, bool allow_generate, ErrorHandler *errh);
+void set_shared_lock_fd(int fd);
 int update_autofont_map(const String &fontname, String mapline, ErrorHandler *);
 String locate_encoding(String encfile, ErrorHandler *, bool literal = false);
 
@@ -742,12 +742,12 @@ DvipsEncoding::bad_codepoint(int code, Metrics &metrics, HashMap<PermString, int
 }
 
 static inline Efont::OpenType::Glyph
-map_uni(uint32_t uni, const Efont::OpenType::Cmap &cmap, const Metrics &m)
+map_uni(uint32_t uni, const FontInfo &finfo, const Metrics &m)
 {
     if (uni == U_EMPTYSLOT)
 	return m.emptyslot_glyph();
     else
-	return cmap.map_uni(uni);
+	return finfo.map_uni(uni);
 }
 
 bool
@@ -792,7 +792,7 @@ DvipsEncoding::make_metrics(Metrics &metrics, const FontInfo &finfo, Secondary *
 		    ++u;
 		}
 
-		glyph = map_uni(this_uni, *finfo.cmap, metrics);
+		glyph = map_uni(this_uni, finfo, metrics);
 		if (glyph_uni == 0 || glyph > 0)
 		    glyph_uni = this_uni;
 	    }
@@ -0,0 +1,338 @@
+// -*- related-file-name: "fontcache.hh" -*-
+
+/* fontcache.{cc,hh} -- persistent cache of font interpretation results
+ *
+ * Copyright (c) 2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include "fontcache.hh"
+#include "automatic.hh"
+#include "util.hh"
+#include <lcdf/error.hh>
+#include <lcdf/md5.h>
+#include <lcdf/straccum.hh>
+#include <lcdf/transform.hh>
+#include <efont/otfdata.hh>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+using namespace Efont::OpenType;
+
+// A cache file is a header line followed by (key, value) records.  Each
+// record is a 32-bit key length, a 32-bit value length, the key, and the
+// value.  Numbers are big-endian, so cache directories can be shared
+// between machines.  A file with a different header, for instance one
+// written by a different version, is ignored.
+
+static const char cache_header[] = "otftotfm font cache 1 " VERSION "\n";
+
+static void
+append_u16(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(2));
+    s[0] = x >> 8;
+    s[1] = x;
+}
+
+static void
+append_u32(StringAccum &sa, uint32_t x)
+{
+    uint8_t *s = reinterpret_cast<uint8_t *>(sa.extend(4));
+    s[0] = x >> 24;
+    s[1] = x >> 16;
+    s[2] = x >> 8;
+    s[3] = x;
+}
+
+static void
+append_double(StringAccum &sa, double d)
+{
+    // store the exact bits; cached bounds must match computed ones
+    uint32_t x[2];
+    memcpy(x, &d, sizeof(d));
+    uint32_t one = 1;
+    bool little_endian = *reinterpret_cast<uint8_t *>(&one) == 1;
+    append_u32(sa, x[little_endian]);
+    append_u32(sa, x[!little_endian]);
+}
+
+static double
+extract_double(const uint8_t *s)
+{
+    uint32_t one = 1;
+    bool little_endian = *reinterpret_cast<uint8_t *>(&one) == 1;
+    uint32_t x[2];
+    x[little_endian] = Data::u32(s);
+    x[!little_endian] = Data::u32(s + 4);
+    double d;
+    memcpy(&d, x, sizeof(d));
+    return d;
+}
+
+
+FontCache::FontCache(const String &font_data, int face, const String &directory, ErrorHandler *errh)
+    : _dirty(false)
+{
+    MD5_CONTEXT md5;
+    md5_init(&md5);
+    md5_update(&md5, font_data.udata(), font_data.length());
+    char text_digest[MD5_TEXT_DIGEST_SIZE + 1];
+    md5_final_text(text_digest, &md5);
+
+    _filename = directory;
+    if (_filename && _filename.back() != '/')
+	_filename += "/";
+    _filename += String(text_digest);
+    if (face)
+	_filename += "-" + String(face);
+    _filename += ".cache";
+
+    if (read(_filename, true) && verbose)
+	errh->message("using font cache %s", _filename.c_str());
+}
+
+bool
+FontCache::read(const String &filename, bool replace)
+{
+    String data = read_file(filename, ErrorHandler::silent_handler());
+    int hlen = sizeof(cache_header) - 1;
+    if (data.length() < hlen || memcmp(data.data(), cache_header, hlen) != 0)
+	return false;
+
+    const uint8_t *s = data.udata() + hlen, *end = data.udata() + data.length();
+    while (end - s >= 8) {
+	uint32_t klen = Data::u32(s), vlen = Data::u32(s + 4);
+	s += 8;
+	if (klen == 0 || (uint32_t) (end - s) < klen
+	    || (uint32_t) (end - s) - klen < vlen)
+	    break;
+	String key = data.substring((const char *) s, (const char *) s + klen);
+	s += klen;
+	if (replace || !_entries.findp(key))
+	    _entries.insert(key, data.substring((const char *) s, (const char *) s + vlen));
+	s += vlen;
+    }
+    return true;
+}
+
+void
+FontCache::add(const String &key, const String &value)
+{
+    _entries.insert(key, value);
+    _dirty = true;
+}
+
+void
+FontCache::save(ErrorHandler *errh)
+{
+    if (!_dirty || no_create)
+	return;
+
+    // pick up anything that concurrent jobs saved since we started
+    read(_filename, false);
+
+    StringAccum sa;
+    sa << cache_header;
+    for (HashMap<String, String>::const_iterator it = _entries.begin(); it; ++it) {
+	append_u32(sa, it.key().length());
+	append_u32(sa, it.value().length());
+	sa << it.key() << it.value();
+    }
+
+    // write a temporary file and rename it into place, so readers never
+    // see a partial cache
+    StringAccum tmp_sa;
+    tmp_sa << _filename << '.';
+#ifdef HAVE_UNISTD_H
+    tmp_sa << (long) getpid();
+#endif
+    tmp_sa << ".tmp";
+    String tmp_filename = tmp_sa.take_string();
+
+    if (verbose)
+	errh->message("writing font cache %s", _filename.c_str());
+    FILE *f = fopen(tmp_filename.c_str(), "wb");
+    if (!f) {
+	errh->warning("%s: %s", tmp_filename.c_str(), strerror(errno));
+	return;
+    }
+    ignore_result(fwrite(sa.data(), 1, sa.length(), f));
+    if (ferror(f) || fclose(f) != 0 || rename(tmp_filename.c_str(), _filename.c_str()) != 0) {
+	errh->warning("%s: %s", _filename.c_str(), strerror(errno));
+	remove(tmp_filename.c_str());
+	return;
+    }
+    _dirty = false;
+}
+
+
+bool
+FontCache::find_glyph_names(Vector<PermString> &glyph_names) const
+{
+    const String &v = _entries["glyph_names"];
+    const uint8_t *s = v.udata(), *end = s + v.length();
+    if (end - s < 4)
+	return false;
+    uint32_t n = Data::u32(s);
+    s += 4;
+    Vector<PermString> gn;
+    for (uint32_t i = 0; i < n; ++i) {
+	if (end - s < 2 || end - s - 2 < Data::u16(s))
+	    return false;
+	int len = Data::u16(s);
+	gn.push_back(PermString((const char *) s + 2, len));
+	s += 2 + len;
+    }
+    glyph_names.swap(gn);
+    return true;
+}
+
+void
+FontCache::add_glyph_names(const Vector<PermString> &glyph_names)
+{
+    StringAccum sa;
+    append_u32(sa, glyph_names.size());
+    for (const PermString *g = glyph_names.begin(); g != glyph_names.end(); ++g) {
+	append_u16(sa, g->length());
+	sa << *g;
+    }
+    add("glyph_names", sa.take_string());
+}
+
+bool
+FontCache::find_unicode_map(Vector<std::pair<uint32_t, Glyph> > &ugp) const
+{
+    const String &v = _entries["unicode_map"];
+    if (v.length() < 4 || v.length() != 4 + 6 * (int) Data::u32(v.udata()))
+	return false;
+    ugp.clear();
+    for (const uint8_t *s = v.udata() + 4; s != v.udata() + v.length(); s += 6)
+	ugp.push_back(std::make_pair(Data::u32(s), (Glyph) Data::u16(s + 4)));
+    return true;
+}
+
+void
+FontCache::add_unicode_map(const Vector<std::pair<uint32_t, Glyph> > &ugp)
+{
+    StringAccum sa;
+    append_u32(sa, ugp.size());
+    for (const std::pair<uint32_t, Glyph> *p = ugp.begin(); p != ugp.end(); ++p) {
+	append_u32(sa, p->first);
+	append_u16(sa, p->second);
+    }
+    add("unicode_map", sa.take_string());
+}
+
+bool
+FontCache::find_substitutions(const String &key, Vector<Substitution> &subs, bool &understood) const
+{
+    const String &v = _entries["GSUB " + key];
+    const uint8_t *s = v.udata(), *end = s + v.length();
+    if (end - s < 5)
+	return false;
+    understood = s[0] != 0;
+    uint32_t n = Data::u32(s + 1);
+    s += 5;
+    Vector<Substitution> v_subs;
+    for (uint32_t i = 0; i < n; ++i) {
+	v_subs.push_back(Substitution());
+	if (!v_subs.back().deserialize(s, end))
+	    return false;
+    }
+    subs.swap(v_subs);
+    return true;
+}
+
+void
+FontCache::add_substitutions(const String &key, const Vector<Substitution> &subs, bool understood)
+{
+    StringAccum sa;
+    sa << (char) understood;
+    append_u32(sa, subs.size());
+    for (const Substitution *s = subs.begin(); s != subs.end(); ++s)
+	s->serialize(sa);
+    add("GSUB " + key, sa.take_string());
+}
+
+bool
+FontCache::find_positionings(const String &key, Vector<Positioning> &poss, bool &understood) const
+{
+    const String &v = _entries["GPOS " + key];
+    const uint8_t *s = v.udata(), *end = s + v.length();
+    if (end - s < 5)
+	return false;
+    understood = s[0] != 0;
+    uint32_t n = Data::u32(s + 1);
+    s += 5;
+    Vector<Positioning> v_poss;
+    Positioning p(Position(0, 0, 0, 0, 0));
+    for (uint32_t i = 0; i < n; ++i) {
+	if (!p.deserialize(s, end))
+	    return false;
+	v_poss.push_back(p);
+    }
+    poss.swap(v_poss);
+    return true;
+}
+
+void
+FontCache::add_positionings(const String &key, const Vector<Positioning> &poss, bool understood)
+{
+    StringAccum sa;
+    sa << (char) understood;
+    append_u32(sa, poss.size());
+    for (const Positioning *p = poss.begin(); p != poss.end(); ++p)
+	p->serialize(sa);
+    add("GPOS " + key, sa.take_string());
+}
+
+static String
+bounds_key(const Transform &xf, Glyph g)
+{
+    StringAccum sa;
+    sa << "bounds ";
+    for (int i = 0; i < 6; ++i)
+	append_double(sa, xf[i]);
+    append_u16(sa, g);
+    return sa.take_string();
+}
+
+bool
+FontCache::find_bounds(const Transform &xf, Glyph g, double bounds[4], double &width, bool &ok) const
+{
+    const String &v = _entries[bounds_key(xf, g)];
+    if (v.length() != 41)
+	return false;
+    const uint8_t *s = v.udata();
+    ok = s[0] != 0;
+    for (int i = 0; i < 4; ++i)
+	bounds[i] = extract_double(s + 1 + 8 * i);
+    width = extract_double(s + 33);
+    return true;
+}
+
+void
+FontCache::add_bounds(const Transform &xf, Glyph g, const double bounds[4], double width, bool ok)
+{
+    StringAccum sa;
+    sa << (char) ok;
+    for (int i = 0; i < 4; ++i)
+	append_double(sa, bounds[i]);
+    append_double(sa, width);
+    add(bounds_key(xf, g), sa.take_string());
+}
@@ -0,0 +1,53 @@
+#ifndef OTFTOTFM_FONTCACHE_HH
+#define OTFTOTFM_FONTCACHE_HH
+#include <efont/otfgsub.hh>
+#include <efont/otfgpos.hh>
+#include <lcdf/hashmap.hh>
+#include <lcdf/permstr.hh>
+#include <utility>
+class Transform;
+class ErrorHandler;
+
+// A persistent cache of font interpretation results: glyph names, the
+// Unicode map, unparsed GSUB and GPOS lookups, and glyph bounds.  Each
+// font has its own file in the cache directory, named after the MD5
+// checksum of the font data (and the face number, for collections), so
+// changed fonts never see stale results.
+
+class FontCache { public:
+
+    typedef Efont::OpenType::Glyph Glyph;
+
+    FontCache(const String &font_data, int face, const String &directory, ErrorHandler *);
+
+    const String &filename() const	{ return _filename; }
+
+    bool find_glyph_names(Vector<PermString> &) const;
+    void add_glyph_names(const Vector<PermString> &);
+
+    bool find_unicode_map(Vector<std::pair<uint32_t, Glyph> > &) const;
+    void add_unicode_map(const Vector<std::pair<uint32_t, Glyph> > &);
+
+    bool find_substitutions(const String &key, Vector<Efont::OpenType::Substitution> &, bool &understood) const;
+    void add_substitutions(const String &key, const Vector<Efont::OpenType::Substitution> &, bool understood);
+
+    bool find_positionings(const String &key, Vector<Efont::OpenType::Positioning> &, bool &understood) const;
+    void add_positionings(const String &key, const Vector<Efont::OpenType::Positioning> &, bool understood);
+
+    bool find_bounds(const Transform &, Glyph, double bounds[4], double &width, bool &ok) const;
+    void add_bounds(const Transform &, Glyph, const double bounds[4], double width, bool ok);
+
+    void save(ErrorHandler *);
+
+  private:
+
+    String _filename;
+    HashMap<String, String> _entries;
+    bool _dirty;
+
+    bool read(const String &filename, bool replace);
+    void add(const String &key, const String &value);
+
+};
+
+#endif
@@ -26,16 +26,17 @@
 Metrics::Metrics(const Efont::CharstringProgram *font, int nglyphs)
     : _boundary_glyph(nglyphs), _emptyslot_glyph(nglyphs + 1),
       _design_units(1000), _units_per_em(font->units_per_em()),
-      _liveness_marked(false)
+      _liveness_marked(false), _ligkern_indexed(false),
+      _lig_index(-1), _kern_index(-1)
 {
-    _encoding.assign(256, Char());
+    resize_encoding(256);
     add_mapped_font(font, String());
 }
 
 Metrics::~Metrics()
 {
-    for (Char *c = _encoding.begin(); c != _encoding.end(); c++)
-	delete c->virtual_char;
+    for (VirtualChar **vc = _virtual_char.begin(); vc != _virtual_char.end(); vc++)
+	delete *vc;
 }
 
 int
@@ -51,16 +52,15 @@ Metrics::check() const
 {
     // check invariants
     // 1. all 'ligatures' entries refer to valid characters
-    // 2. all 'ligatures' entries with 'in1 == c' are in '_encoding[c].ligs'
+    // 2. all 'ligatures' entries with 'in1 == c' are in '_ligatures[c]'
     // 3. 'virtual_char' SHOW operations point to valid non-virtual chars
-    for (int code = 0; code < _encoding.size(); code++) {
-	const Char *ch = &_encoding[code];
-	assert((ch->virtual_char != 0) == (ch->glyph == VIRTUAL_GLYPH));
-	for (const Ligature *l = ch->ligatures.begin(); l != ch->ligatures.end(); l++)
+    for (int code = 0; code < _glyph.size(); code++) {
+	assert((_virtual_char[code] != 0) == (_glyph[code] == VIRTUAL_GLYPH));
+	for (const Ligature *l = _ligatures[code].begin(); l != _ligatures[code].end(); l++)
 	    assert(valid_code(l->in2) && valid_code(l->out));
-	for (const Kern *k = ch->kerns.begin(); k != ch->kerns.end(); k++)
+	for (const Kern *k = _kerns[code].begin(); k != _kerns[code].end(); k++)
 	    assert(valid_code(k->in2));
-	if (const VirtualChar *vc = ch->virtual_char) {
+	if (const VirtualChar *vc = _virtual_char[code]) {
 	    assert(vc->name);
 	    int font_number = 0;
 	    for (const Setting *s = vc->setting.begin(); s != vc->setting.end(); s++) {
@@ -71,39 +71,39 @@ Metrics::check() const
 		    font_number = s->x;
 	    }
 	}
-	assert(ch->built_in1 < 0 || valid_code(ch->built_in1));
-	assert(ch->built_in2 < 0 || valid_code(ch->built_in2));
-	assert((ch->built_in1 >= 0) == (ch->built_in2 >= 0));
-	assert(ch->base_code < 0 || valid_code(ch->base_code));
-	if (valid_code(ch->base_code)) {
-	    const Char *ch2 = &_encoding[ch->base_code];
-	    assert((!ch->virtual_char && ch->glyph)
-		   || (!ch2->virtual_char && ch2->glyph));
-	}
-	if (ch->flag(Char::CONTEXT_ONLY))
-	    assert(ch->virtual_char && ch->built_in1 >= 0 && ch->built_in2 >= 0);
-	if (ch->flag(Char::CONTEXT_ONLY))
-	    assert(ch->flag(Char::LIVE));
+	const BuiltPair &b = _built[code];
+	assert(b.in1 < 0 || valid_code(b.in1));
+	assert(b.in2 < 0 || valid_code(b.in2));
+	assert((b.in1 >= 0) == (b.in2 >= 0));
+	Code bc = _base_code[code];
+	assert(bc < 0 || valid_code(bc));
+	if (valid_code(bc))
+	    assert((!_virtual_char[code] && _glyph[code])
+		   || (!_virtual_char[bc] && _glyph[bc]));
+	if (flag(code, CONTEXT_ONLY))
+	    assert(_virtual_char[code] && b.in1 >= 0 && b.in2 >= 0);
+	if (flag(code, CONTEXT_ONLY))
+	    assert(flag(code, LIVE));
     }
 }
 
 PermString
 Metrics::code_name(Code code) const
 {
-    if (code < 0 || code >= _encoding.size())
+    if (code < 0 || code >= _glyph.size())
 	return permprintf("<badcode%d>", code);
     else {
-	const Char &ch = _encoding[code];
-	if (ch.virtual_char)
-	    return ch.virtual_char->name;
-	else if (ch.glyph == _boundary_glyph)
+	Glyph g = _glyph[code];
+	if (const VirtualChar *vc = _virtual_char[code])
+	    return vc->name;
+	else if (g == _boundary_glyph)
 	    return "<boundary>";
-	else if (ch.glyph == _emptyslot_glyph)
+	else if (g == _emptyslot_glyph)
 	    return "<emptyslot>";
-	else if (ch.glyph >= 0 && ch.glyph < _mapped_fonts[0]->nglyphs())
-	    return _mapped_fonts[0]->glyph_name(ch.glyph);
+	else if (g >= 0 && g < _mapped_fonts[0]->nglyphs())
+	    return _mapped_fonts[0]->glyph_name(g);
 	else
-	    return permprintf("<glyph%d>", ch.glyph);
+	    return permprintf("<glyph%d>", g);
     }
 }
 
@@ -114,9 +114,9 @@ Metrics::code_name(Code code) const
 Metrics::Code
 Metrics::unicode_encoding(uint32_t uni) const
 {
-    for (const Char *ch = _encoding.begin(); ch < _encoding.end(); ch++)
-	if (ch->unicode == uni)
-	    return ch - _encoding.begin();
+    for (const uint32_t *u = _unicode.begin(); u < _unicode.end(); u++)
+	if (*u == uni)
+	    return u - _unicode.begin();
     return -1;
 }
 
@@ -126,8 +126,8 @@ Metrics::hard_encoding(Glyph g, Code after) const
     if (g < 0)
 	return -1;
     int answer = -1, n = 0;
-    for (int i = _encoding.size() - 1; i >= after; i--)
-	if (_encoding[i].glyph == g)
+    for (int i = _glyph.size() - 1; i >= after; i--)
+	if (_glyph[i] == g)
 	    answer = i, n++;
     if (n < 2 && after == 0) {
 	if (g >= _emap.size())
@@ -145,13 +145,13 @@ Metrics::force_encoding(Glyph g, int lookup_source)
     if (e >= 0)
 	return e;
     else {
-	Char ch;
-	ch.glyph = g;
-	ch.base_code = _encoding.size();
-	ch.lookup_source = lookup_source;
-	_encoding.push_back(ch);
-	assign_emap(g, ch.base_code);
-	return ch.base_code;
+	Code code = _glyph.size();
+	resize_encoding(code + 1);
+	_glyph[code] = g;
+	_base_code[code] = code;
+	_lookup_source[code] = lookup_source;
+	assign_emap(g, code);
+	return code;
     }
 }
 
@@ -159,13 +159,13 @@ void
 Metrics::encode(Code code, uint32_t uni, Glyph g)
 {
     assert(code >= 0 && g >= 0 && g != VIRTUAL_GLYPH);
-    if (code >= _encoding.size())
-	_encoding.resize(code + 1, Char());
-    _encoding[code].unicode = uni;
-    _encoding[code].glyph = g;
+    if (code >= _glyph.size())
+	resize_encoding(code + 1);
+    _unicode[code] = uni;
+    _glyph[code] = g;
     if (g > 0)
-	_encoding[code].base_code = code;
-    assert(!_encoding[code].virtual_char);
+	_base_code[code] = code;
+    assert(!_virtual_char[code]);
     assign_emap(g, code);
 }
 
@@ -173,14 +173,14 @@ void
 Metrics::encode_virtual(Code code, PermString name, uint32_t uni, const Vector<Setting> &v, bool base_char)
 {
     assert(code >= 0 && v.size() > 0);
-    if (code >= _encoding.size())
-	_encoding.resize(code + 1, Char());
-    _encoding[code].unicode = uni;
-    _encoding[code].glyph = VIRTUAL_GLYPH;
+    if (code >= _glyph.size())
+	resize_encoding(code + 1);
+    _unicode[code] = uni;
+    _glyph[code] = VIRTUAL_GLYPH;
     if (base_char)
-	_encoding[code].flags |= Char::BASE_REP;
-    assert(!_encoding[code].virtual_char);
-    VirtualChar *vc = _encoding[code].virtual_char = new VirtualChar;
+	_flags[code] |= BASE_REP;
+    assert(!_virtual_char[code]);
+    VirtualChar *vc = _virtual_char[code] = new VirtualChar;
     vc->name = name;
     vc->setting = v;
     int font_number = 0;
@@ -195,19 +195,21 @@ void
 Metrics::apply_base_encoding(const String &font_name, const DvipsEncoding &dvipsenc, const Vector<int> &mapping)
 {
     int font_number = -1;
-    for (Char *c = _encoding.begin(); c != _encoding.end(); c++)
-	if (c->glyph > 0 && !c->virtual_char && c->glyph < mapping.size()
-	    && mapping[c->glyph] >= 0) {
+    for (Code c = 0; c < _glyph.size(); c++) {
+	Glyph g = _glyph[c];
+	if (g > 0 && !_virtual_char[c] && g < mapping.size()
+	    && mapping[g] >= 0) {
 	    if (font_number < 0)
 		font_number = add_mapped_font(mapped_font(0), font_name);
-	    VirtualChar *vc = c->virtual_char = new VirtualChar;
-	    vc->name = dvipsenc.encoding(mapping[c->glyph]);
+	    VirtualChar *vc = _virtual_char[c] = new VirtualChar;
+	    vc->name = dvipsenc.encoding(mapping[g]);
 	    vc->setting.push_back(Setting(Setting::FONT, font_number));
-	    vc->setting.push_back(Setting(Setting::SHOW, mapping[c->glyph], c->glyph));
-	    c->glyph = VIRTUAL_GLYPH;
-	    c->base_code = -1;
-	    c->flags = (c->flags & ~Char::BASE_LIVE) | Char::BASE_REP;
+	    vc->setting.push_back(Setting(Setting::SHOW, mapping[g], g));
+	    _glyph[c] = VIRTUAL_GLYPH;
+	    _base_code[c] = -1;
+	    _flags[c] = (_flags[c] & ~BASE_LIVE) | BASE_REP;
 	}
+    }
 }
 
 void
@@ -225,54 +227,111 @@ bool
 Metrics::base_glyphs(Vector<Glyph> &v, int size) const
 {
     bool any = false;
-    v.assign(_encoding.size(), 0);
-    for (const Char *ch = _encoding.begin(); ch != _encoding.end(); ch++)
-	if (ch->base_code >= 0 && ch->base_code < size) {
-	    v[ch->base_code] = ch->glyph;
+    v.assign(_glyph.size(), 0);
+    for (Code c = 0; c < _glyph.size(); c++)
+	if (_base_code[c] >= 0 && _base_code[c] < size) {
+	    v[_base_code[c]] = _glyph[c];
 	    any = true;
 	}
     return any;
 }
 
+void
+Metrics::encoded_glyphs(Efont::OpenType::GlyphSet &gs, int nglyphs) const
+{
+    // skips virtual and boundary glyphs
+    for (const Glyph *g = _glyph.begin(); g != _glyph.end(); g++)
+	if (*g >= 0 && *g < nglyphs)
+	    gs.insert(*g);
+}
+
 
 /*****************************************************************************/
-/* Char methods								     */
+/* per-code state							     */
+
+void
+Metrics::resize_encoding(int size)
+{
+    _glyph.resize(size, 0);
+    _base_code.resize(size, -1);
+    _unicode.resize(size, 0);
+    _flags.resize(size, 0);
+    _delta.resize(size, Delta());
+    _virtual_char.resize(size, 0);
+    _built.resize(size, BuiltPair());
+    _lookup_source.resize(size, -1);
+    _ligatures.resize(size, Vector<Ligature>());
+    _kerns.resize(size, Vector<Kern>());
+}
 
 void
-Metrics::Char::clear()
+Metrics::clear_code(Code c)
 {
-    glyph = 0;
-    base_code = -1;
-    unicode = 0;
-    ligatures.clear();
-    kerns.clear();
-    delete virtual_char;
-    virtual_char = 0;
-    pdx = pdy = adx = 0;
-    built_in1 = built_in2 = -1;
-    lookup_source = -1;
-    flags = 0;
+    _glyph[c] = 0;
+    _base_code[c] = -1;
+    _unicode[c] = 0;
+    _ligatures[c].clear();
+    _kerns[c].clear();
+    delete _virtual_char[c];
+    _virtual_char[c] = 0;
+    _delta[c] = Delta();
+    _built[c] = BuiltPair();
+    _lookup_source[c] = -1;
+    _flags[c] = 0;
 }
 
 void
-Metrics::Char::swap(Char &c)
+Metrics::swap_codes(Code a, Code b)
 {
-    std::swap(glyph, c.glyph);
+    std::swap(_glyph[a], _glyph[b]);
     // NB: only a partial switch of base_code!!
-    if (base_code < 0)
-	base_code = c.base_code;
-    c.base_code = -1;
-    std::swap(unicode, c.unicode);
-    ligatures.swap(c.ligatures);
-    kerns.swap(c.kerns);
-    std::swap(virtual_char, c.virtual_char);
-    std::swap(pdx, c.pdx);
-    std::swap(pdy, c.pdy);
-    std::swap(adx, c.adx);
-    std::swap(built_in1, c.built_in1);
-    std::swap(built_in2, c.built_in2);
-    std::swap(lookup_source, c.lookup_source);
-    std::swap(flags, c.flags);
+    if (_base_code[a] < 0)
+	_base_code[a] = _base_code[b];
+    _base_code[b] = -1;
+    std::swap(_unicode[a], _unicode[b]);
+    _ligatures[a].swap(_ligatures[b]);
+    _kerns[a].swap(_kerns[b]);
+    std::swap(_virtual_char[a], _virtual_char[b]);
+    std::swap(_delta[a], _delta[b]);
+    std::swap(_built[a], _built[b]);
+    std::swap(_lookup_source[a], _lookup_source[b]);
+    std::swap(_flags[a], _flags[b]);
+}
+
+
+/*****************************************************************************/
+/* ligature and kern indexes						     */
+
+void
+Metrics::index_ligkerns() const
+{
+    _lig_index.clear();
+    _kern_index.clear();
+    for (Code c = 0; c < _glyph.size(); c++) {
+	const Vector<Ligature> &ligs = _ligatures[c];
+	for (int i = 0; i < ligs.size(); i++)
+	    _lig_index.insert(PairKey(c, ligs[i].in2), i);
+	const Vector<Kern> &kerns = _kerns[c];
+	for (int i = 0; i < kerns.size(); i++)
+	    _kern_index.insert(PairKey(c, kerns[i].in2), i);
+    }
+    _ligkern_indexed = true;
+}
+
+inline void
+Metrics::unindex_ligkerns()
+{
+    // called after ligature or kern lists are moved or rewritten wholesale;
+    // the indexes are rebuilt on the next long-list lookup
+    _ligkern_indexed = false;
+}
+
+inline int
+Metrics::indexed_pair(const HashMap<PairKey, int> &index, Code in1, Code in2) const
+{
+    if (!_ligkern_indexed)
+	index_ligkerns();
+    return index[PairKey(in1, in2)];
 }
 
 
@@ -283,8 +342,14 @@ Metrics::Ligature *
 Metrics::ligature_obj(Code code1, Code code2)
 {
     assert(valid_code(code1) && valid_code(code2));
-    Char &ch = _encoding[code1];
-    for (Ligature *l = ch.ligatures.begin(); l != ch.ligatures.end(); l++)
+    Vector<Ligature> &ligs = _ligatures[code1];
+    if (ligs.size() > INDEX_THRESHOLD) {
+	int i = indexed_pair(_lig_index, code1, code2);
+	if (i >= 0 && i < ligs.size() && ligs[i].in2 == code2)
+	    return &ligs[i];
+	return 0;
+    }
+    for (Ligature *l = ligs.begin(); l != ligs.end(); l++)
 	if (l->in2 == code2)
 	    return l;
     return 0;
@@ -294,7 +359,10 @@ inline void
 Metrics::new_ligature(Code in1, Code in2, Code out)
 {
     assert(valid_code(in1) && valid_code(in2) && valid_code(out));
-    _encoding[in1].ligatures.push_back(Ligature(in2, out));
+    Vector<Ligature> &ligs = _ligatures[in1];
+    if (_ligkern_indexed)
+	_lig_index.insert(PairKey(in1, in2), ligs.size());
+    ligs.push_back(Ligature(in2, out));
 }
 
 inline void
@@ -307,11 +375,13 @@ void
 Metrics::add_ligature(Code in1, Code in2, Code out)
 {
     if (Ligature *l = ligature_obj(in1, in2)) {
-	Char &ch = _encoding[l->out];
-	if (ch.flags & Char::BUILT) {
+	Code old_out = l->out;
+	if (_flags[old_out] & BUILT) {
 	    // move old ligatures to point to the true ligature
-	    for (Ligature *ll = ch.ligatures.begin(); ll != ch.ligatures.end(); ll++)
-		add_ligature(out, ll->in2, ll->out);
+	    for (int i = 0; i < _ligatures[old_out].size(); i++) {
+		const Ligature &ll = _ligatures[old_out][i];
+		add_ligature(out, ll.in2, ll.out);
+	    }
 	    repoint_ligature(in1, l, out);
 	}
     } else
@@ -323,23 +393,24 @@ Metrics::pair_code(Code in1, Code in2, int lookup_source)
 {
     if (const Ligature *l = ligature_obj(in1, in2)) {
 	if (lookup_source < 0)
-	    _encoding[l->out].flags &= ~Char::INTERMEDIATE;
+	    _flags[l->out] &= ~INTERMEDIATE;
 	return l->out;
     } else {
-	Char ch;
-	ch.glyph = VIRTUAL_GLYPH;
-	ch.flags = Char::BUILT | (lookup_source >= 0 ? Char::INTERMEDIATE : 0);
-	VirtualChar *vc = ch.virtual_char = new VirtualChar;
+	VirtualChar *vc = new VirtualChar;
 	vc->name = permprintf("%s__%s", code_str(in1), code_str(in2));
 	setting(in1, vc->setting, SET_INTERMEDIATE);
 	vc->setting.push_back(Setting(Setting::KERN));
 	setting(in2, vc->setting, SET_INTERMEDIATE);
-	ch.built_in1 = in1;
-	ch.built_in2 = in2;
-	ch.lookup_source = lookup_source;
-	_encoding.push_back(ch);
-	new_ligature(in1, in2, _encoding.size() - 1);
-	return _encoding.size() - 1;
+	Code code = _glyph.size();
+	resize_encoding(code + 1);
+	_glyph[code] = VIRTUAL_GLYPH;
+	_flags[code] = BUILT | (lookup_source >= 0 ? INTERMEDIATE : 0);
+	_virtual_char[code] = vc;
+	_built[code].in1 = in1;
+	_built[code].in2 = in2;
+	_lookup_source[code] = lookup_source;
+	new_ligature(in1, in2, code);
+	return code;
     }
 }
 
@@ -347,15 +418,17 @@ void
 Metrics::remove_ligatures(Code in1, Code in2)
 {
     if (in1 == CODE_ALL) {
-	for (in1 = 0; in1 < _encoding.size(); in1++)
+	for (in1 = 0; in1 < _glyph.size(); in1++)
 	    remove_ligatures(in1, in2);
     } else {
-	Char &ch = _encoding[in1];
+	Vector<Ligature> &ligs = _ligatures[in1];
 	if (in2 == CODE_ALL)
-	    ch.ligatures.clear();
+	    ligs.clear();
 	else if (Ligature *l = ligature_obj(in1, in2)) {
-	    *l = ch.ligatures.back();
-	    ch.ligatures.pop_back();
+	    *l = ligs.back();
+	    ligs.pop_back();
+	    if (_ligkern_indexed && l != ligs.end())
+		_lig_index.insert(PairKey(in1, l->in2), l - ligs.begin());
 	}
     }
 }
@@ -368,8 +441,14 @@ Metrics::Kern *
 Metrics::kern_obj(Code in1, Code in2)
 {
     assert(valid_code(in1) && valid_code(in2));
-    Char &ch = _encoding[in1];
-    for (Kern *k = ch.kerns.begin(); k != ch.kerns.end(); k++)
+    Vector<Kern> &kerns = _kerns[in1];
+    if (kerns.size() > INDEX_THRESHOLD) {
+	int i = indexed_pair(_kern_index, in1, in2);
+	if (i >= 0 && i < kerns.size() && kerns[i].in2 == in2)
+	    return &kerns[i];
+	return 0;
+    }
+    for (Kern *k = kerns.begin(); k != kerns.end(); k++)
 	if (k->in2 == in2)
 	    return k;
     return 0;
@@ -379,8 +458,14 @@ int
 Metrics::kern(Code in1, Code in2) const
 {
     assert(valid_code(in1) && valid_code(in2));
-    const Char &ch = _encoding[in1];
-    for (const Kern *k = ch.kerns.begin(); k != ch.kerns.end(); k++)
+    const Vector<Kern> &kerns = _kerns[in1];
+    if (kerns.size() > INDEX_THRESHOLD) {
+	int i = indexed_pair(_kern_index, in1, in2);
+	if (i >= 0 && i < kerns.size() && kerns[i].in2 == in2)
+	    return kerns[i].kern;
+	return 0;
+    }
+    for (const Kern *k = kerns.begin(); k != kerns.end(); k++)
 	if (k->in2 == in2)
 	    return k->kern;
     return 0;
@@ -391,29 +476,38 @@ Metrics::add_kern(Code in1, Code in2, int kern)
 {
     if (Kern *k = kern_obj(in1, in2))
 	k->kern += kern;
-    else
-	_encoding[in1].kerns.push_back(Kern(in2, kern));
+    else {
+	Vector<Kern> &kerns = _kerns[in1];
+	if (_ligkern_indexed)
+	    _kern_index.insert(PairKey(in1, in2), kerns.size());
+	kerns.push_back(Kern(in2, kern));
+    }
 }
 
 void
 Metrics::set_kern(Code in1, Code in2, int kern)
 {
     if (in1 == CODE_ALL) {
-	for (in1 = 0; in1 < _encoding.size(); in1++)
+	for (in1 = 0; in1 < _glyph.size(); in1++)
 	    set_kern(in1, in2, kern);
     } else {
-	Char &ch = _encoding[in1];
+	Vector<Kern> &kerns = _kerns[in1];
 	if (in2 == CODE_ALL) {
 	    assert(kern == 0);
-	    ch.kerns.clear();
+	    kerns.clear();
 	} else if (Kern *k = kern_obj(in1, in2)) {
 	    if (kern == 0) {
-		*k = ch.kerns.back();
-		ch.kerns.pop_back();
+		*k = kerns.back();
+		kerns.pop_back();
+		if (_ligkern_indexed && k != kerns.end())
+		    _kern_index.insert(PairKey(in1, k->in2), k - kerns.begin());
 	    } else
 		k->kern = kern;
-	} else if (kern != 0)
-	    ch.kerns.push_back(Kern(in2, kern));
+	} else if (kern != 0) {
+	    if (_ligkern_indexed)
+		_kern_index.insert(PairKey(in1, in2), kerns.size());
+	    kerns.push_back(Kern(in2, kern));
+	}
     }
 }
 
@@ -421,33 +515,37 @@ int
 Metrics::reencode_right_ligkern(Code old_in2, Code new_in2)
 {
     int nchanges = 0;
-    for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++) {
-	for (Ligature *l = ch->ligatures.begin(); l != ch->ligatures.end(); l++)
+    for (Code c = 0; c < _glyph.size(); c++) {
+	Vector<Ligature> &ligs = _ligatures[c];
+	for (Ligature *l = ligs.begin(); l != ligs.end(); l++)
 	    if (l->in2 == old_in2) {
 		if (new_in2 >= 0)
 		    l->in2 = new_in2;
 		else {
-		    *l = ch->ligatures.back();
-		    ch->ligatures.pop_back();
+		    *l = ligs.back();
+		    ligs.pop_back();
 		    l--;
 		}
 		nchanges++;
 	    }
-	for (Kern *k = ch->kerns.begin(); k != ch->kerns.end(); k++)
+	Vector<Kern> &kerns = _kerns[c];
+	for (Kern *k = kerns.begin(); k != kerns.end(); k++)
 	    if (k->in2 == old_in2) {
 		if (new_in2 >= 0)
 		    k->in2 = new_in2;
 		else {
-		    *k = ch->kerns.back();
-		    ch->kerns.pop_back();
+		    *k = kerns.back();
+		    kerns.pop_back();
 		    k--;
 		}
 		nchanges++;
 	    }
 	// XXX?
-	if (ch->context_setting(-1, old_in2) && new_in2 >= 0 && ch->built_in1 >= 0)
-	    ch->built_in2 = new_in2;
+	if (context_setting(c, -1, old_in2) && new_in2 >= 0 && _built[c].in1 >= 0)
+	    _built[c].in2 = new_in2;
     }
+    if (nchanges)
+	unindex_ligkerns();
     return nchanges;
 }
 
@@ -459,10 +557,10 @@ void
 Metrics::add_single_positioning(Code c, int pdx, int pdy, int adx)
 {
     assert(valid_code(c));
-    Char &ch = _encoding[c];
-    ch.pdx += pdx;
-    ch.pdy += pdy;
-    ch.adx += adx;
+    Delta &d = _delta[c];
+    d.pdx += pdx;
+    d.pdy += pdy;
+    d.adx += adx;
 }
 
 
@@ -606,16 +704,16 @@ Metrics::apply_single(Code cin, const Substitution *s, int lookup,
 	// no one has changed this glyph yet, change it unilaterally
 	assign_emap(s->in_glyph(), -2);
 	assign_emap(out, cin);
-	assert(!_encoding[cin].virtual_char);
-	_encoding[cin].glyph = out;
+	assert(!_virtual_char[cin]);
+	_glyph[cin] = out;
     } else {
 	// some contextual substitutions have changed this glyph, add
 	// contextual substitutions for the remaining possibilities
 	Code cout = force_encoding(out, lookup);
-	for (Code right = 0; right < _encoding.size(); right++)
-	    if (_encoding[right].visible() && !_encoding[right].flag(Char::BUILT) && ctx.pair_allowed(cin, right)) {
+	for (Code right = 0; right < _glyph.size(); right++)
+	    if (visible(right) && !flag(right, BUILT) && ctx.pair_allowed(cin, right)) {
 		Code pair = pair_code(cout, right, lookup);
-		_encoding[cout].flags &= ~Char::INTERMEDIATE;
+		_flags[cout] &= ~INTERMEDIATE;
 		add_ligature(cin, right, pair);
 	    }
     }
@@ -641,14 +739,14 @@ Metrics::apply_ligature(const Vector<Code> &in, const Substitution *s, int looku
 	*outp = force_encoding(*outp, lookup);
 	cout = (cout < 0 ? *outp : pair_code(cout, *outp, lookup));
     }
-    _encoding[cout].flags &= ~Char::INTERMEDIATE;
+    _flags[cout] &= ~INTERMEDIATE;
 
     // check for replacing a fake ligature
     int old_out = -1;
     if (Ligature *l = ligature_obj(cin1, cin2)) {
 	if (l->out == cout)	// already created this same ligature
 	    return;
-	if (_encoding[l->out].flags & Char::BUILT)
+	if (_flags[l->out] & BUILT)
 	    old_out = l->out;
     }
 
@@ -659,10 +757,10 @@ Metrics::apply_ligature(const Vector<Code> &in, const Substitution *s, int looku
 
     // if appropriate, swap old ligatures to point to the new result
     if (old_out >= 0)
-	for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++)
-	    for (Ligature *l = ch->ligatures.begin(); l != ch->ligatures.end(); l++)
+	for (Code c = 0; c < _glyph.size(); c++)
+	    for (Ligature *l = _ligatures[c].begin(); l != _ligatures[c].end(); l++)
 		if (l->out == old_out)
-		    repoint_ligature(ch - _encoding.begin(), l, cout);
+		    repoint_ligature(c, l, cout);
 }
 
 void
@@ -719,7 +817,7 @@ Metrics::apply(const Vector<Substitution>& sv, bool allow_single, int lookup, co
     Vector<Code> codes;
 
     // keep track of what substitutions we have performed
-    ChangedContext ctx(_encoding.size());
+    ChangedContext ctx(_glyph.size());
 
     // loop over substitutions
     int failures = 0;
@@ -827,7 +925,7 @@ Metrics::apply(const Vector<Positioning>& pv)
 {
     // keep track of what substitutions we have performed
     int *single_changed = 0;
-    Vector<int *> pair_changed(_encoding.size(), 0);
+    Vector<int *> pair_changed(_glyph.size(), 0);
     Vector<Glyph> glyphs;
     Vector<Code> codes;
 
@@ -839,13 +937,14 @@ Metrics::apply(const Vector<Positioning>& pv)
 	    p->all_in_glyphs(glyphs);
 	    for (codes.clear(); next_encoding(codes, glyphs); )
 		if (is_single) {
-		    if (!assign_bitvec(single_changed, codes[0], _encoding.size())) {
-			_encoding[codes[0]].pdx += p->left().pdx;
-			_encoding[codes[0]].pdy += p->left().pdy;
-			_encoding[codes[0]].adx += p->left().adx;
+		    if (!assign_bitvec(single_changed, codes[0], _glyph.size())) {
+			Delta &d = _delta[codes[0]];
+			d.pdx += p->left().pdx;
+			d.pdy += p->left().pdy;
+			d.adx += p->left().adx;
 		    }
 		} else {
-		    if (!assign_bitvec(pair_changed[codes[0]], codes[1], _encoding.size()))
+		    if (!assign_bitvec(pair_changed[codes[0]], codes[1], _glyph.size()))
 			add_kern(codes[0], codes[1], p->left().adx);
 		}
 	    success++;
@@ -886,8 +985,8 @@ Metrics::all_ligatures(Vector<Ligature3> &all_ligs) const
 {
     /* Develop a topologically-sorted ligature list. */
     all_ligs.clear();
-    for (Code code = 0; code < _encoding.size(); code++)
-	for (const Ligature *l = _encoding[code].ligatures.begin(); l != _encoding[code].ligatures.end(); l++)
+    for (Code code = 0; code < _glyph.size(); code++)
+	for (const Ligature *l = _ligatures[code].begin(); l != _ligatures[code].end(); l++)
 	    all_ligs.push_back(Ligature3(code, l->in2, l->out));
     std::sort(all_ligs.begin(), all_ligs.end());
 }
@@ -906,30 +1005,30 @@ Metrics::mark_liveness(int size, const Vector<Ligature3> *all_ligs)
     }
 
     /* Characters below 'size' are in both virtual and base encodings. */
-    for (Char *ch = _encoding.begin(); ch < _encoding.begin() + size; ch++)
-	if (ch->visible())
-	    ch->flags |= Char::LIVE | (ch->virtual_char ? 0 : Char::BASE_LIVE);
+    for (Code c = 0; c < size; c++)
+	if (visible(c))
+	    _flags[c] |= LIVE | (_virtual_char[c] ? 0 : BASE_LIVE);
 
     /* Characters reachable from live chars by live ligatures are live. */
   redo_live_reachable:
     for (const Ligature3 *l = all_ligs->begin(); l != all_ligs->end(); l++)
-	if (_encoding[l->in1].flag(Char::LIVE) && _encoding[l->in2].flag(Char::LIVE)) {
-	    Char &ch = _encoding[l->out];
-	    if (!ch.flag(Char::LIVE))
-		ch.flags |= Char::LIVE | Char::CONTEXT_ONLY | (ch.virtual_char ? 0 : Char::BASE_LIVE);
-	    if (ch.flag(Char::CONTEXT_ONLY) && !ch.context_setting(l->in1, l->in2))
-		ch.flags &= ~Char::CONTEXT_ONLY;
+	if (flag(l->in1, LIVE) && flag(l->in2, LIVE)) {
+	    int &flags = _flags[l->out];
+	    if (!(flags & LIVE))
+		flags |= LIVE | CONTEXT_ONLY | (_virtual_char[l->out] ? 0 : BASE_LIVE);
+	    if ((flags & CONTEXT_ONLY) && !context_setting(l->out, l->in1, l->in2))
+		flags &= ~CONTEXT_ONLY;
 	}
 
     /* Characters reachable from context-only ligatures are live. */
     changed = false;
-    for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++)
-	if (ch->flag(Char::CONTEXT_ONLY)) {
-	    Char &ch1 = _encoding[ch->built_in1];
-	    Char &ch2 = _encoding[ch->built_in2];
-	    if (!ch1.flag(Char::LIVE) || !ch2.flag(Char::LIVE)) {
-		ch1.flags |= Char::LIVE;
-		ch2.flags |= Char::LIVE;
+    for (Code c = 0; c < _flags.size(); c++)
+	if (_flags[c] & CONTEXT_ONLY) {
+	    int &flags1 = _flags[_built[c].in1];
+	    int &flags2 = _flags[_built[c].in2];
+	    if (!(flags1 & LIVE) || !(flags2 & LIVE)) {
+		flags1 |= LIVE;
+		flags2 |= LIVE;
 		changed = true;
 	    }
 	}
@@ -937,14 +1036,14 @@ Metrics::mark_liveness(int size, const Vector<Ligature3> *all_ligs)
 	goto redo_live_reachable;
 
     /* Characters reachable from live settings are base-live. */
-    for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++)
-	if (ch->flag(Char::LIVE))
-	    if (VirtualChar *vc = ch->virtual_char) {
+    for (Code c = 0; c < _flags.size(); c++)
+	if (_flags[c] & LIVE)
+	    if (VirtualChar *vc = _virtual_char[c]) {
 		int font_number = 0;
 		for (Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
 		    if (s->op == Setting::SHOW && font_number == 0
-			&& _encoding[s->x].base_code >= 0)
-			_encoding[s->x].flags |= Char::BASE_LIVE;
+			&& _base_code[s->x] >= 0)
+			_flags[s->x] |= BASE_LIVE;
 		    else if (s->op == Setting::FONT)
 			font_number = s->x;
 	    }
@@ -953,14 +1052,17 @@ Metrics::mark_liveness(int size, const Vector<Ligature3> *all_ligs)
 void
 Metrics::reencode(const Vector<Code> &reencoding)
 {
-    for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++) {
-	for (Ligature *l = ch->ligatures.begin(); l != ch->ligatures.end(); l++) {
+    int n = _glyph.size();
+    for (Code c = 0; c < n; c++) {
+	for (Ligature *l = _ligatures[c].begin(); l != _ligatures[c].end(); l++) {
 	    l->in2 = reencoding[l->in2];
 	    l->out = reencoding[l->out];
 	}
-	for (Kern *k = ch->kerns.begin(); k != ch->kerns.end(); k++)
+	for (Kern *k = _kerns[c].begin(); k != _kerns[c].end(); k++)
 	    k->in2 = reencoding[k->in2];
-	if (VirtualChar *vc = ch->virtual_char) {
+    }
+    for (Code c = 0; c < n; c++)
+	if (VirtualChar *vc = _virtual_char[c]) {
 	    int font_number = 0;
 	    for (Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
 		if (s->op == Setting::SHOW && font_number == 0)
@@ -968,14 +1070,16 @@ Metrics::reencode(const Vector<Code> &reencoding)
 		else if (s->op == Setting::FONT)
 		    font_number = s->x;
 	}
-	if (ch->built_in1 >= 0) {
-	    ch->built_in1 = reencoding[ch->built_in1];
-	    ch->built_in2 = reencoding[ch->built_in2];
+    for (BuiltPair *b = _built.begin(); b != _built.end(); b++)
+	if (b->in1 >= 0) {
+	    b->in1 = reencoding[b->in1];
+	    b->in2 = reencoding[b->in2];
 	}
-	if (ch->base_code >= 0)
-	    ch->base_code = reencoding[ch->base_code];
-    }
+    for (Code *bc = _base_code.begin(); bc != _base_code.end(); bc++)
+	if (*bc >= 0)
+	    *bc = reencoding[*bc];
     _emap.clear();
+    unindex_ligkerns();
 }
 
 
@@ -983,14 +1087,14 @@ Metrics::reencode(const Vector<Code> &reencoding)
 /* shrinking the encoding						     */
 
 bool
-Metrics::Char::context_setting(Code in1, Code in2) const
+Metrics::context_setting(Code c, Code in1, Code in2) const
 {
-    // return true iff this character could represent the context setting of
+    // return true iff character 'c' could represent the context setting of
     // 'in1' and 'in2'
-    if (!virtual_char || ligatures.size())
+    if (!_virtual_char[c] || _ligatures[c].size())
 	return false;
     else
-	return (in1 == built_in1 || in2 == built_in2);
+	return (in1 == _built[c].in1 || in2 == _built[c].in2);
 }
 
 void
@@ -1000,17 +1104,17 @@ Metrics::cut_encoding(int size)
        characters above 'size', except for context ligatures. */
 
     /* Change "emptyslot"s to ".notdef"s. */
-    for (Char *ch = _encoding.begin(); ch != _encoding.end(); ch++)
-	if (ch->glyph == emptyslot_glyph()) {
-	    ch->glyph = 0;
-	    ch->base_code = -1;
+    for (Code c = 0; c < _glyph.size(); c++)
+	if (_glyph[c] == emptyslot_glyph()) {
+	    _glyph[c] = 0;
+	    _base_code[c] = -1;
 	    // 21.Feb.2007: Character isn't live any more.
-	    ch->flags &= ~(Char::BASE_LIVE | Char::LIVE);
+	    _flags[c] &= ~(BASE_LIVE | LIVE);
 	}
 
     /* Maybe we don't need to do anything else. */
-    if (_encoding.size() <= size) {
-	_encoding.resize(size, Char());
+    if (_glyph.size() <= size) {
+	resize_encoding(size);
 	return;
     }
 
@@ -1020,24 +1124,24 @@ Metrics::cut_encoding(int size)
 
     /* Characters below 'size' are 'good'.
        Characters above 'size' are not 'good'. */
-    Vector<int> good(_encoding.size(), 1);
-    for (Code c = size; c < _encoding.size(); c++)
+    Vector<int> good(_glyph.size(), 1);
+    for (Code c = size; c < _glyph.size(); c++)
 	good[c] = 0;
 
     /* Characters encoded via base_code are 'good', though. */
-    for (Char *ch = _encoding.begin(); ch < _encoding.begin() + size; ch++)
-	if (ch->base_code >= size)
-	    good[ch->base_code] = 1;
+    for (Code c = 0; c < size; c++)
+	if (_base_code[c] >= size)
+	    good[_base_code[c]] = 1;
 
     /* Some fake characters might point beyond 'size'; remove them too. No
        need for a multipass algorithm since virtual chars never point to
        virtual chars. */
-    for (Code c = 0; c < _encoding.size(); c++) {
-	if (VirtualChar *vc = _encoding[c].virtual_char) {
+    for (Code c = 0; c < _glyph.size(); c++) {
+	if (VirtualChar *vc = _virtual_char[c]) {
 	    int font_number = 0;
 	    for (Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
 		if (s->op == Setting::SHOW && font_number == 0 && !good[s->x]) {
-		    _encoding[c].clear();
+		    clear_code(c);
 		    goto bad_virtual_char;
 		} else if (s->op == Setting::FONT)
 		    font_number = s->x;
@@ -1048,9 +1152,9 @@ Metrics::cut_encoding(int size)
     }
 
     /* Certainly none of the later ligatures or kerns will be meaningful. */
-    for (Code c = size; c < _encoding.size(); c++) {
-	_encoding[c].ligatures.clear();
-	_encoding[c].kerns.clear();
+    for (Code c = size; c < _glyph.size(); c++) {
+	_ligatures[c].clear();
+	_kerns[c].clear();
     }
 
     /* Remove ligatures and kerns that point beyond 'size', except for valid
@@ -1059,21 +1163,23 @@ Metrics::cut_encoding(int size)
     /* 30.May.2005 -- Kerns might point involve a too-high character; kill
        them. */
     for (Code c = 0; c < size; c++) {
-	Char &ch = _encoding[c];
-	for (Ligature *l = ch.ligatures.begin(); l != ch.ligatures.end(); l++)
+	Vector<Ligature> &ligs = _ligatures[c];
+	for (Ligature *l = ligs.begin(); l != ligs.end(); l++)
 	    if (!good[l->in2] || l->in2 >= size
-		|| (!good[l->out] && !_encoding[l->out].context_setting(c, l->in2))) {
-		*l = ch.ligatures.back();
-		ch.ligatures.pop_back();
+		|| (!good[l->out] && !context_setting(l->out, c, l->in2))) {
+		*l = ligs.back();
+		ligs.pop_back();
 		l--;
 	    }
-	for (Kern *k = ch.kerns.begin(); k != ch.kerns.end(); k++)
+	Vector<Kern> &kerns = _kerns[c];
+	for (Kern *k = kerns.begin(); k != kerns.end(); k++)
 	    if (!good[k->in2] || k->in2 >= size) {
-		*k = ch.kerns.back();
-		ch.kerns.pop_back();
+		*k = kerns.back();
+		kerns.pop_back();
 		k--;
 	    }
     }
+    unindex_ligkerns();
 
     /* We are done! */
 }
@@ -1144,7 +1250,7 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
     /* Move characters around. */
 
     /* Maybe we don't need to do anything. */
-    if (_encoding.size() <= size) {
+    if (_glyph.size() <= size) {
 	cut_encoding(size);
 	return;
     }
@@ -1162,30 +1268,30 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
        a ligature. */
 
     /* Create an initial set of scores, based on Unicode values. */
-    Vector<int> scores(_encoding.size(), NOCHAR_SCORE);
-    for (int i = 0; i < _encoding.size(); i++)
-	if (_encoding[i].unicode)
-	    scores[i] = unicode_score(_encoding[i].unicode);
+    Vector<int> scores(_unicode.size(), NOCHAR_SCORE);
+    for (int i = 0; i < _unicode.size(); i++)
+	if (_unicode[i])
+	    scores[i] = unicode_score(_unicode[i]);
 
     /* Prefer conventional f-ligatures. */
     bool has_ff = false;
     for (Ligature3* l = all_ligs.begin(); l != all_ligs.end(); ++l)
-        if (_encoding[l->in1].unicode == 'f'
-            && (_encoding[l->in2].unicode == 'f'
-                || _encoding[l->in2].unicode == 'i'
-                || _encoding[l->in2].unicode == 'l')) {
+        if (_unicode[l->in1] == 'f'
+            && (_unicode[l->in2] == 'f'
+                || _unicode[l->in2] == 'i'
+                || _unicode[l->in2] == 'l')) {
             if (scores[l->out] > CONVENTIONAL_F_LIGATURE_SCORE)
                 scores[l->out] = CONVENTIONAL_F_LIGATURE_SCORE;
-            if (_encoding[l->in2].unicode == 'f') {
-                _encoding[l->out].flags |= Char::IS_FF;
+            if (_unicode[l->in2] == 'f') {
+                _flags[l->out] |= IS_FF;
                 has_ff = true;
             }
         }
     if (has_ff)
         for (Ligature3* l = all_ligs.begin(); l != all_ligs.end(); ++l)
-            if (_encoding[l->in1].flag(Char::IS_FF)
-                && (_encoding[l->in2].unicode == 'i'
-                    || _encoding[l->in2].unicode == 'l')
+            if (flag(l->in1, IS_FF)
+                && (_unicode[l->in2] == 'i'
+                    || _unicode[l->in2] == 'l')
                 && scores[l->out] > CONVENTIONAL_F_F_LIGATURE_SCORE)
                 scores[l->out] = CONVENTIONAL_F_F_LIGATURE_SCORE;
 
@@ -1201,8 +1307,8 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
                 scores[l->out] = score, changed = true;
 	}
 
-	for (Code c = 0; c < _encoding.size(); c++)
-	    if (VirtualChar *vc = _encoding[c].virtual_char) {
+	for (Code c = 0; c < _virtual_char.size(); c++)
+	    if (VirtualChar *vc = _virtual_char[c]) {
 		/* Make sure that if this virtual character appears, its parts
 		   will also appear, by scoring the parts less */
 		int score = scores[c] - 1, font_number = 0;
@@ -1217,21 +1323,19 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
 
     /* Rescore intermediates to not be better off than their endpoints. */
     /* XXX multiple layers of intermediate? */
-    for (Code c = 0; c < _encoding.size(); c++) {
-	Char &ch = _encoding[c];
-	if (ch.flag(Char::INTERMEDIATE))
-	    for (Ligature *l = ch.ligatures.begin(); l != ch.ligatures.end(); l++)
-		if (scores[c] < scores[l->out] && !_encoding[l->out].context_setting(c, l->in2))
+    for (Code c = 0; c < _flags.size(); c++)
+	if (_flags[c] & INTERMEDIATE)
+	    for (Ligature *l = _ligatures[c].begin(); l != _ligatures[c].end(); l++)
+		if (scores[c] < scores[l->out] && !context_setting(l->out, c, l->in2))
 		    scores[c] = scores[l->out];
-    }
 
     /* Collect characters that want to be reassigned. */
     Vector<Slot> slots;
-    for (Code c = size; c < _encoding.size(); c++)
+    for (Code c = size; c < _glyph.size(); c++)
 	if (scores[c] < NOCHAR_SCORE
-	    && !(_encoding[c].flags & Char::CONTEXT_ONLY)
-	    && (_encoding[c].flags & (Char::LIVE | Char::BASE_LIVE))) {
-	    Slot slot = { c, -1, _encoding[c].glyph, scores[c], _encoding[c].lookup_source };
+	    && !(_flags[c] & CONTEXT_ONLY)
+	    && (_flags[c] & (LIVE | BASE_LIVE))) {
+	    Slot slot = { c, -1, _glyph[c], scores[c], _lookup_source[c] };
 	    slots.push_back(slot);
 	}
     // Sort them by score, then by glyph.
@@ -1241,8 +1345,8 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
     for (Slot *slot = slots.begin(); slot < slots.end(); slot++)
 	if (PermString g = code_name(slot->old_code)) {
 	    int c = dvipsenc.encoding_of(g);
-	    if (c >= 0 && _encoding[c].glyph == 0) {
-		_encoding[c].swap(_encoding[slot->old_code]);
+	    if (c >= 0 && _glyph[c] == 0) {
+		swap_codes(c, slot->old_code);
 		slot->new_code = c;
 	    }
 	}
@@ -1253,7 +1357,7 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
     Vector<Code> empty_codes;
     for (int want_encoded = 0; want_encoded < 2; want_encoded++)
 	for (Code c = 0; c < size; c++)
-	    if (_encoding[c].base_code < 0
+	    if (_base_code[c] < 0
 		&& dvipsenc.encoded(c) == (bool) want_encoded)
 		empty_codes.push_back(c);
 
@@ -1264,30 +1368,30 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
 	if (slot->new_code >= 0)
 	    continue;
 
-	int needs = (_encoding[slot->old_code].visible_base() ? 1 : 0)
-	    + (_encoding[slot->old_code].flag(Char::LIVE) ? 2 : 0);
+	int needs = (visible_base(slot->old_code) ? 1 : 0)
+	    + (flag(slot->old_code, LIVE) ? 2 : 0);
 	assert(needs > 0);
 
 	Code dest = -1;
 	for (Code *h = empty_codes.begin(); h < empty_codes.end() && dest < 0; h++) {
-	    int haves = (_encoding[*h].base_code < 0 ? 1 : 0)
-		+ (!_encoding[*h].visible() ? 2 : 0);
+	    int haves = (_base_code[*h] < 0 ? 1 : 0)
+		+ (!visible(*h) ? 2 : 0);
 	    if ((needs & haves) == needs)
 		dest = *h;
 	}
 
 	if (dest >= 0) {
 	    if (needs & 2) {
-		assert(!_encoding[dest].visible());
-		_encoding[dest].swap(_encoding[slot->old_code]);
+		assert(!visible(dest));
+		swap_codes(dest, slot->old_code);
 		slot->new_code = dest;
 	    } else {
-		_encoding[slot->old_code].base_code = dest;
+		_base_code[slot->old_code] = dest;
 		slot->new_code = slot->old_code;
 	    }
 	    if (needs & 1) {
-		assert(_encoding[dest].base_code < 0 || _encoding[dest].base_code == slot->old_code);
-		_encoding[dest].base_code = slot->old_code;
+		assert(_base_code[dest] < 0 || _base_code[dest] == slot->old_code);
+		_base_code[dest] = slot->old_code;
 	    }
 	} else
 	    nunencoded++;
@@ -1316,7 +1420,7 @@ To select specific glyphs, add them to the input encoding.)", sa.c_str());
 
     /* Reencode changed slots. */
     Vector<Code> reencoding;
-    for (Code c = 0; c < _encoding.size(); c++)
+    for (Code c = 0; c < _glyph.size(); c++)
 	reencoding.push_back(c);
     for (Slot *s = slots.begin(); s != slots.end(); s++)
 	if (s->new_code >= 0)
@@ -1330,18 +1434,18 @@ void
 Metrics::make_base(int size)
 {
     Vector<Code> reencoding;
-    for (Code c = 0; c < size && c < _encoding.size(); c++) {
-	Char &ch = _encoding[c];
-	if (ch.base_code >= 0 && ch.base_code != c) {
+    for (Code c = 0; c < size && c < _glyph.size(); c++) {
+	Code bc = _base_code[c];
+	if (bc >= 0 && bc != c) {
 	    if (!reencoding.size())
-		for (Code cc = 0; cc < _encoding.size(); cc++)
+		for (Code cc = 0; cc < _glyph.size(); cc++)
 		    reencoding.push_back(cc);
-	    reencoding[ch.base_code] = c;
-	    reencoding[c] = ch.base_code;
-	    _encoding[c].swap(_encoding[ch.base_code]);
+	    reencoding[bc] = c;
+	    reencoding[c] = bc;
+	    swap_codes(c, bc);
 	}
-	if (ch.virtual_char)	// remove it
-	    ch.clear();
+	if (_virtual_char[c])	// remove it
+	    clear_code(c);
     }
     if (reencoding.size()) {
 	reencode(reencoding);
@@ -1357,11 +1461,11 @@ Metrics::make_base(int size)
 bool
 Metrics::need_virtual(int size) const
 {
-    if (size > _encoding.size())
-	size = _encoding.size();
-    for (const Char *ch = _encoding.begin(); ch < _encoding.begin() + size; ch++)
-	if (ch->glyph /* actually encoded */
-	    && (ch->pdx || ch->pdy || ch->adx || ch->virtual_char))
+    if (size > _glyph.size())
+	size = _glyph.size();
+    for (Code c = 0; c < size; c++)
+	if (_glyph[c] /* actually encoded */
+	    && (_delta[c].nonzero() || _virtual_char[c]))
 	    return true;
     return false;
 }
@@ -1370,9 +1474,9 @@ bool
 Metrics::need_base()
 {
     if (!_liveness_marked)
-	mark_liveness(_encoding.size());
-    for (const Char *ch = _encoding.begin(); ch < _encoding.end(); ch++)
-	if ((ch->flags & Char::BASE_LIVE) && ch->glyph != _boundary_glyph)
+	mark_liveness(_glyph.size());
+    for (Code c = 0; c < _flags.size(); c++)
+	if ((_flags[c] & BASE_LIVE) && _glyph[c] != _boundary_glyph)
 	    return true;
     return false;
 }
@@ -1385,17 +1489,17 @@ Metrics::setting(Code code, Vector<Setting> &v, SettingMode sm) const
     if (!(sm & SET_KEEP))
 	v.clear();
 
-    if (!valid_code(code) || _encoding[code].glyph == 0)
+    if (!valid_code(code) || _glyph[code] == 0)
 	return false;
 
-    const Char &ch = _encoding[code];
+    const Delta &d = _delta[code];
 
-    if (const VirtualChar *vc = ch.virtual_char) {
+    if (const VirtualChar *vc = _virtual_char[code]) {
 	bool good = true;
 	int font_number = 0;
 
-	if (ch.pdx != 0 || ch.pdy != 0)
-	    v.push_back(Setting(Setting::MOVE, ch.pdx, ch.pdy));
+	if (d.pdx != 0 || d.pdy != 0)
+	    v.push_back(Setting(Setting::MOVE, d.pdx, d.pdy));
 
 	for (const Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
 	    switch (s->op) {
@@ -1433,18 +1537,18 @@ Metrics::setting(Code code, Vector<Setting> &v, SettingMode sm) const
 		break;
 	    }
 
-	if (ch.pdy != 0 || ch.adx - ch.pdx != 0)
-	    v.push_back(Setting(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy));
+	if (d.pdy != 0 || d.adx - d.pdx != 0)
+	    v.push_back(Setting(Setting::MOVE, d.adx - d.pdx, -d.pdy));
 	return good;
 
-    } else if (ch.base_code >= 0) {
-	if (ch.pdx != 0 || ch.pdy != 0)
-	    v.push_back(Setting(Setting::MOVE, ch.pdx, ch.pdy));
+    } else if (_base_code[code] >= 0) {
+	if (d.pdx != 0 || d.pdy != 0)
+	    v.push_back(Setting(Setting::MOVE, d.pdx, d.pdy));
 
-	v.push_back(Setting(Setting::SHOW, ch.base_code, ch.glyph));
+	v.push_back(Setting(Setting::SHOW, _base_code[code], _glyph[code]));
 
-	if (ch.pdy != 0 || ch.adx - ch.pdx != 0)
-	    v.push_back(Setting(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy));
+	if (d.pdy != 0 || d.adx - d.pdx != 0)
+	    v.push_back(Setting(Setting::MOVE, d.adx - d.pdx, -d.pdy));
 	return true;
 
     } else
@@ -1458,18 +1562,18 @@ Metrics::ligatures(Code in1, Vector<Code> &in2, Vector<Code> &out, Vector<int> &
     out.clear();
     context.clear();
 
-    const Char &in1ch = _encoding[in1];
-    for (const Ligature *l = in1ch.ligatures.begin(); l != in1ch.ligatures.end(); l++) {
+    const Vector<Ligature> &ligs = _ligatures[in1];
+    for (const Ligature *l = ligs.begin(); l != ligs.end(); l++) {
 	in2.push_back(l->in2);
-	const Char &outch = _encoding[l->out];
-	if (outch.context_setting(in1, l->in2)) {
-	    if (in1 == outch.built_in1 && l->in2 == outch.built_in2)
+	if (context_setting(l->out, in1, l->in2)) {
+	    const BuiltPair &b = _built[l->out];
+	    if (in1 == b.in1 && l->in2 == b.in2)
 		in2.pop_back();
-	    else if (in1 == outch.built_in1) {
-		out.push_back(outch.built_in2);
+	    else if (in1 == b.in1) {
+		out.push_back(b.in2);
 		context.push_back(-1);
 	    } else {
-		out.push_back(outch.built_in1);
+		out.push_back(b.in1);
 		context.push_back(1);
 	    }
 	} else {
@@ -1487,8 +1591,8 @@ Metrics::kerns(Code in1, Vector<Code> &in2, Vector<int> &kern) const
     in2.clear();
     kern.clear();
 
-    const Char &in1ch = _encoding[in1];
-    for (const Kern *k = in1ch.kerns.begin(); k != in1ch.kerns.end(); k++)
+    const Vector<Kern> &kerns = _kerns[in1];
+    for (const Kern *k = kerns.begin(); k != kerns.end(); k++)
 	if (k->kern != 0) {
 	    in2.push_back(k->in2);
 	    kern.push_back(k->kern);
@@ -1502,22 +1606,17 @@ Metrics::kerns(Code in1, Vector<Code> &in2, Vector<int> &kern) const
 /* debugging								     */
 
 void
-Metrics::unparse(const Char *ch) const
+Metrics::unparse(Code c) const
 {
-    Code c;
-    if (ch >= _encoding.begin() && ch < _encoding.end())
-	c = ch - _encoding.begin();
-    else
-	c = -1;
     fprintf(stderr, "%4d/%s%s%s%s%s%s\n", c, code_str(c),
-	    (ch->flag(Char::LIVE) ? " [L]" : ""),
-	    (ch->flag(Char::BASE_LIVE) ? " [B]" : ""),
-	    (ch->flag(Char::CONTEXT_ONLY) ? " [C]" : ""),
-	    (ch->flag(Char::BUILT) ? " [!]" : ""),
-	    (ch->base_code >= 0 ? " <BC>" : ""));
-    if (ch->base_code >= 0 && ch->base_code != c)
-	fprintf(stderr, "\tBASE %d/%s\n", ch->base_code, code_str(ch->base_code));
-    if (const VirtualChar *vc = ch->virtual_char) {
+	    (flag(c, LIVE) ? " [L]" : ""),
+	    (flag(c, BASE_LIVE) ? " [B]" : ""),
+	    (flag(c, CONTEXT_ONLY) ? " [C]" : ""),
+	    (flag(c, BUILT) ? " [!]" : ""),
+	    (_base_code[c] >= 0 ? " <BC>" : ""));
+    if (_base_code[c] >= 0 && _base_code[c] != c)
+	fprintf(stderr, "\tBASE %d/%s\n", _base_code[c], code_str(_base_code[c]));
+    if (const VirtualChar *vc = _virtual_char[c]) {
 	fprintf(stderr, "\t*");
 	int curfont = 0;
 	for (const Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
@@ -1550,12 +1649,12 @@ Metrics::unparse(const Char *ch) const
 		fprintf(stderr, " S{%s}", s->s.c_str());
 		break;
 	    }
-	fprintf(stderr, "  ((%d/%s, %d/%s))\n", ch->built_in1, code_str(ch->built_in1), ch->built_in2, code_str(ch->built_in2));
+	fprintf(stderr, "  ((%d/%s, %d/%s))\n", _built[c].in1, code_str(_built[c].in1), _built[c].in2, code_str(_built[c].in2));
     }
-    for (const Ligature *l = ch->ligatures.begin(); l != ch->ligatures.end(); l++)
-	fprintf(stderr, "\t[%d/%s => %d/%s]%s\n", l->in2, code_str(l->in2), l->out, code_str(l->out), (_encoding[l->out].context_setting(c, l->in2) ? " [C]" : ""));
+    for (const Ligature *l = _ligatures[c].begin(); l != _ligatures[c].end(); l++)
+	fprintf(stderr, "\t[%d/%s => %d/%s]%s\n", l->in2, code_str(l->in2), l->out, code_str(l->out), (context_setting(l->out, c, l->in2) ? " [C]" : ""));
 #if 0
-    for (const Kern *k = ch->kerns.begin(); k != ch->kerns.end(); k++)
+    for (const Kern *k = _kerns[c].begin(); k != _kerns[c].end(); k++)
 	fprintf(stderr, "\t{%d/%s %+d}\n", k->in2, code_str(k->in2), k->kern);
 #endif
 }
@@ -1563,7 +1662,7 @@ Metrics::unparse(const Char *ch) const
 void
 Metrics::unparse() const
 {
-    for (const Char *ch = _encoding.begin(); ch < _encoding.end(); ch++)
-	if (ch->glyph)
-	    unparse(ch);
+    for (Code c = 0; c < _glyph.size(); c++)
+	if (_glyph[c])
+	    unparse(c);
 }
@@ -2,6 +2,7 @@
 #define OTFTOTFM_METRICS_HH
 #include <efont/otfgsub.hh>
 #include <efont/otfgpos.hh>
+#include <lcdf/hashmap.hh>
 namespace Efont { class CharstringProgram; }
 class DvipsEncoding;
 class GlyphFilter;
@@ -48,7 +49,7 @@ class Metrics { public:
     const String &mapped_font_name(int i) const { return _mapped_font_names[i]; }
     int add_mapped_font(const Efont::CharstringProgram *, const String &);
 
-    inline int encoding_size() const		{ return _encoding.size(); }
+    inline int encoding_size() const		{ return _glyph.size(); }
     inline bool valid_code(Code) const;
     inline bool nonvirtual_code(Code) const;
     PermString code_name(Code) const;
@@ -69,6 +70,7 @@ class Metrics { public:
     inline Code base_code(Code) const;
     inline Glyph base_glyph(Code) const;
     bool base_glyphs(Vector<Glyph> &, int size) const;
+    void encoded_glyphs(Efont::OpenType::GlyphSet &, int nglyphs) const;
 
     void add_ligature(Code in1, Code in2, Code out);
     Code pair_code(Code, Code, int lookup_source = -1);
@@ -125,36 +127,46 @@ class Metrics { public:
         String unparse(const Metrics& m) const;
     };
 
+    struct PairKey {
+	Code in1;
+	Code in2;
+	PairKey() : in1(-1), in2(-1) { }
+	PairKey(Code in1_, Code in2_) : in1(in1_), in2(in2_) { }
+	operator bool() const		{ return in1 >= 0; }
+    };
+
   private:
 
-    struct Char {
-	Glyph glyph;
-	Code base_code;
-	uint32_t unicode;
-	Vector<Ligature> ligatures;
-	Vector<Kern> kerns;
-	VirtualChar *virtual_char;
+    struct Delta {
 	int pdx;
 	int pdy;
 	int adx;
-	Code built_in1;
-	Code built_in2;
-	int lookup_source;
-	enum { BUILT = 1, INTERMEDIATE = 2, CONTEXT_ONLY = 4, LIVE = 8,
-	       BASE_LIVE = 16, BASE_REP = 32, IS_FF = 64 };
-	int flags;
-
-	Char()				: virtual_char(0) { clear(); }
-	void clear();
-	void swap(Char &);
-	bool visible() const		{ return glyph != 0; }
-	bool visible_base() const	{ return glyph != 0 && glyph != VIRTUAL_GLYPH; }
-	bool flag(int f) const		{ return (flags & f) != 0; }
-	inline bool base_glyph() const;
-	bool context_setting(Code in1, Code in2) const;
+	Delta() : pdx(0), pdy(0), adx(0) { }
+	bool nonzero() const		{ return pdx || pdy || adx; }
     };
 
-    Vector<Char> _encoding;
+    struct BuiltPair {
+	Code in1;
+	Code in2;
+	BuiltPair() : in1(-1), in2(-1) { }
+    };
+
+    enum { BUILT = 1, INTERMEDIATE = 2, CONTEXT_ONLY = 4, LIVE = 8,
+	   BASE_LIVE = 16, BASE_REP = 32, IS_FF = 64 };
+
+    // The encoding is stored as parallel arrays indexed by Code, all of
+    // size encoding_size(), so that passes over every code touch only the
+    // properties they need.
+    Vector<Glyph> _glyph;
+    Vector<Code> _base_code;
+    Vector<uint32_t> _unicode;
+    Vector<int> _flags;
+    Vector<Delta> _delta;
+    Vector<VirtualChar *> _virtual_char;
+    Vector<BuiltPair> _built;
+    Vector<int> _lookup_source;
+    Vector<Vector<Ligature> > _ligatures;
+    Vector<Vector<Kern> > _kerns;
     mutable Vector<int> _emap;
 
     Glyph _boundary_glyph;
@@ -167,6 +179,16 @@ class Metrics { public:
     int _units_per_em;
 
     bool _liveness_marked : 1;
+    mutable bool _ligkern_indexed : 1;
+
+    // Lists shorter than this are searched linearly. Longer lists are
+    // found through _lig_index/_kern_index, which map (in1, in2) to the
+    // position of the Ligature/Kern in _encoding[in1]'s vector. Entries
+    // may be stale (a position no longer holding in2), but while
+    // _ligkern_indexed is true, every stored pair has a correct entry.
+    enum { INDEX_THRESHOLD = 8 };
+    mutable HashMap<PairKey, int> _lig_index;
+    mutable HashMap<PairKey, int> _kern_index;
 
     Vector<const Efont::CharstringProgram *> _mapped_fonts;
     Vector<String> _mapped_font_names;
@@ -174,10 +196,21 @@ class Metrics { public:
     Metrics(const Metrics &);	// does not exist
     Metrics &operator=(const Metrics &); // does not exist
 
+    void resize_encoding(int size);
+    void clear_code(Code);
+    void swap_codes(Code, Code);
+    bool visible(Code c) const		{ return _glyph[c] != 0; }
+    bool visible_base(Code c) const	{ return _glyph[c] != 0 && _glyph[c] != VIRTUAL_GLYPH; }
+    bool flag(Code c, int f) const	{ return (_flags[c] & f) != 0; }
+    bool context_setting(Code c, Code in1, Code in2) const;
+
     inline void assign_emap(Glyph, Code);
     Code hard_encoding(Glyph, Code) const;
     bool next_encoding(Vector<Code> &codes, const Vector<Glyph> &glyphs) const;
 
+    void index_ligkerns() const;
+    inline void unindex_ligkerns();
+    inline int indexed_pair(const HashMap<PairKey, int> &, Code, Code) const;
     Ligature *ligature_obj(Code, Code);
     Kern *kern_obj(Code, Code);
     inline void new_ligature(Code, Code, Code);
@@ -203,57 +236,70 @@ class Metrics { public:
 		const GlyphFilter &glyph_filter,
 		const Vector<PermString> &glyph_names);
 
-    void unparse(const Char *) const;
+    void unparse(Code) const;
 
 };
 
 
+inline bool
+operator==(const Metrics::PairKey &a, const Metrics::PairKey &b)
+{
+    return a.in1 == b.in1 && a.in2 == b.in2;
+}
+
+inline hashcode_t
+hashcode(const Metrics::PairKey &k)
+{
+    return static_cast<hashcode_t>(k.in1) * 0x9E3779B1U
+	+ static_cast<hashcode_t>(k.in2);
+}
+
 inline bool
 Metrics::valid_code(Code code) const
 {
-    return code >= 0 && code < _encoding.size();
+    return code >= 0 && code < _glyph.size();
 }
 
 inline bool
 Metrics::nonvirtual_code(Code code) const
 {
-    return code >= 0 && code < _encoding.size() && !_encoding[code].virtual_char;
+    return code >= 0 && code < _glyph.size() && !_virtual_char[code];
 }
 
 inline Metrics::Glyph
 Metrics::glyph(Code code) const
 {
-    if (code < 0 || code >= _encoding.size())
+    if (code < 0 || code >= _glyph.size())
 	return 0;
     else
-	return _encoding[code].glyph;
+	return _glyph[code];
 }
 
 inline uint32_t
 Metrics::unicode(Code code) const
 {
-    if (code < 0 || code >= _encoding.size())
+    if (code < 0 || code >= _unicode.size())
 	return 0;
     else
-	return _encoding[code].unicode;
+	return _unicode[code];
 }
 
 inline Metrics::Glyph
 Metrics::base_glyph(Code code) const
 {
-    if (code < 0 || code >= _encoding.size() || _encoding[code].base_code < 0)
+    if (code < 0 || code >= _glyph.size() || _base_code[code] < 0)
 	return 0;
     else
-	return _encoding[code].glyph;
+	return _glyph[code];
 }
 
 inline Metrics::Code
 Metrics::base_code(Code code) const
 {
-    if (code < 0 || code >= _encoding.size())
+    if (code < 0 || code >= _base_code.size())
 	return 0;
     else
-	return _encoding[code].base_code;
+	return _base_code[code];
 }
 
 inline Metrics::Code
@@ -280,19 +326,15 @@ Metrics::code_str(Code code) const
     return code_name(code).c_str();
 }
 
-inline bool
-Metrics::Char::base_glyph() const
-{
-    return glyph == VIRTUAL_GLYPH ? flags & BASE_REP : glyph != 0;
-}
-
 inline bool
 Metrics::was_base_glyph(Code code) const
 {
-    if (code < 0 || code >= _encoding.size())
+    if (code < 0 || code >= _glyph.size())
 	return 0;
+    else if (_glyph[code] == VIRTUAL_GLYPH)
+	return (_flags[code] & BASE_REP) != 0;
     else
-	return _encoding[code].base_glyph();
+	return _glyph[code] != 0;
 }
 
 #endif
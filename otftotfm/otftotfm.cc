@@ -34,6 +34,8 @@
 #include "kpseinterface.h"
 #include "util.hh"
 #include "otftotfm.hh"
+#include "tfm.hh"
+#include "fontcache.hh"
 #include <lcdf/md5.h>
 #include <lcdf/clp.h>
 #include <lcdf/error.hh>
@@ -63,6 +65,9 @@
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 
 using namespace Efont;
 
@@ -117,12 +122,17 @@ using namespace Efont;
 #define NOCREATE_OPT		356
 #define VERBOSE_OPT		357
 #define FORCE_OPT		358
+#define BATCH_OPT		359
 
 #define VIRTUAL_OPT		360
 #define PL_OPT			361
 #define TFM_OPT			362
 #define MAP_FILE_OPT		363
 #define OUTPUT_ENCODING_OPT	364
+#define JOBS_OPT		365
+#define USE_PLTOTF_OPT		366
+#define CACHE_DIR_OPT		367
+#define FACE_OPT		368
 
 #define DIR_OPTS		380
 #define ENCODING_DIR_OPT	(DIR_OPTS + O_ENCODING)
@@ -222,6 +232,11 @@ static Clp_Option options[] = {
     { "force", 0, FORCE_OPT, 0, Clp_Negate },
     { "verbose", 'V', VERBOSE_OPT, 0, Clp_Negate },
     { "kpathsea-debug", 0, KPATHSEA_DEBUG_OPT, Clp_ValInt, 0 },
+    { "batch", 0, BATCH_OPT, Clp_ValString, 0 },
+    { "jobs", 'j', JOBS_OPT, Clp_ValUnsigned, 0 },
+    { "use-pltotf", 0, USE_PLTOTF_OPT, 0, Clp_Negate },
+    { "cache-directory", 0, CACHE_DIR_OPT, Clp_ValString, 0 },
+    { "face", 0, FACE_OPT, Clp_ValUnsigned, 0 },
 
     { "help", 'h', HELP_OPT, 0, 0 },
     { "version", 0, VERSION_OPT, 0, 0 },
@@ -272,6 +287,7 @@ static double design_size;
 static double minimum_kern = 2.0;
 static double space_factor = 1.0;
 static bool math_spacing = false;
+static bool use_pltotf = false;
 static int skew_char = -1;
 static bool override_is_fixed_pitch = false;
 static bool is_fixed_pitch;
@@ -293,6 +309,26 @@ bool force = false;
 
 static String otf_data;
 
+static const char *input_file = 0;
+static Vector<String> glyphlist_files;
+static bool literal_encoding = false;
+static bool have_encoding_file = false;
+static Vector<String> ligkern_commands;
+static Vector<String> position_commands;
+static Vector<String> unicoding_commands;
+static Vector<String> base_encoding_files;
+static bool no_ecommand = false, default_ligkern = true;
+static int warn_missing = -1;
+static String codingscheme;
+static String batch_file;
+static int batch_jobs = 1;
+static String cache_directory;
+static int font_face = 0;
+
+static GlyphFilter current_substitution_filter;
+static GlyphFilter current_alternate_filter;
+static GlyphFilter* current_filter_ptr = &null_filter;
+
 
 void
 usage_error(ErrorHandler *errh, const char *error_message, ...)
@@ -319,8 +355,9 @@ turn on optional OpenType features, and a %<-e ENC%> option to specify a base\n\
 encoding. Output files are written to the current directory (but see\n\
 %<--automatic%> and the %<directory%> options).\n\
 \n\
-Usage: %s [-a] [OPTIONS] OTFFILE FONTNAME\n\n",
-	   program_name);
+Usage: %s [-a] [OPTIONS] OTFFILE FONTNAME\n\
+       %s [-a] [OPTIONS] --batch=FILE\n\n",
+	   program_name, program_name);
     uerrh.message("\
 Font feature and transformation options:\n\
   -s, --script=SCRIPT[.LANG]   Use features for script SCRIPT[.LANG] [latn].\n\
@@ -374,6 +411,7 @@ Automatic mode options:\n\
 Output options:\n\
   -n, --name=NAME              Generated font name is NAME.\n\
   -p, --pl                     Output human-readable PL/VPLs, not TFM/VFs.\n\
+      --use-pltotf             Run pltotf and vptovf to create TFM/VFs.\n\
       --no-virtual             Do not generate VFs or VPLs.\n\
       --no-encoding            Do not generate an encoding file.\n\
       --no-map                 Do not generate a psfonts.map line.\n\
@@ -389,9 +427,13 @@ File location options:\n\
       --type1-directory=DIR    Put Type 1 fonts in DIR [automatic].\n\
       --truetype-directory=DIR Put TrueType fonts in DIR [automatic].\n\
       --map-file=FILE          Update FILE with psfonts.map information [-].\n\
+      --cache-directory=DIR    Cache font analysis results in DIR.\n\
 \n\
 Other options:\n\
       --glyphlist=FILE         Use FILE to map Adobe glyph names to Unicode.\n\
+      --face=N                 Use face N of a font collection [0].\n\
+      --batch=FILE             Run the jobs in FILE, one command line per line.\n\
+  -j, --jobs=N                 Use N processes for jobs and glyph bounds [1].\n\
   -V, --verbose                Print progress information to standard error.\n\
       --no-create              Print messages, don't modify any files.\n\
       --force                  Generate files even if versions already exist.\n"
@@ -472,7 +514,7 @@ get_design_size(const FontInfo &finfo)
 	    throw OpenType::Error();
 
 	ErrorHandler *errh = ErrorHandler::silent_handler();
-	OpenType::Gpos gpos(gpos_table, errh);
+	const OpenType::Gpos &gpos = finfo.gpos(errh);
 
 	// extract 'size' feature(s)
 	int required_fid;
@@ -518,15 +560,14 @@ static double max_printed_real;
 
 namespace {
 struct Printer {
-    Printer(FILE* f, unsigned design_units, unsigned units_per_em)
-        : f_(f), du_((double) design_units / units_per_em),
+    Printer(unsigned design_units, unsigned units_per_em)
+        : du_((double) design_units / units_per_em),
           round_(design_units == 1000) {
     }
     inline double transform(double value) const;
-    void print_transformed(const char* prefix, double value) const;
-    void print(const char* prefix, double value) const;
+    String print_transformed(double value) const;
+    String print(double value) const;
     String render(double value) const;
-    FILE* f_;
     double du_;
     bool round_;
 };
@@ -538,16 +579,18 @@ inline double Printer::transform(double value) const {
     return value;
 }
 
-void Printer::print_transformed(const char* prefix, double value) const {
+String Printer::print_transformed(double value) const {
+    char buf[128];
     if (round_ || value == 0 || (value > 0.01 && value - floor(value) < 0.01))
-        fprintf(f_, "%s R %g)\n", prefix, value);
+        sprintf(buf, "%g", value);
     else
-        fprintf(f_, "%s R %.4f)\n", prefix, value);
+        sprintf(buf, "%.4f", value);
     max_printed_real = std::max(max_printed_real, fabs(value));
+    return String(buf);
 }
 
-void Printer::print(const char* prefix, double value) const {
-    print_transformed(prefix, transform(value));
+String Printer::print(double value) const {
+    return print_transformed(transform(value));
 }
 
 String Printer::render(double value) const {
@@ -560,6 +603,12 @@ String Printer::render(double value) const {
         return String(buf);
     }
 }
+
+struct PlNames {
+    Vector<String> ids;
+    Vector<String> comments;
+    Vector<String> base_comments;
+};
 } // namespace
 
 double
@@ -569,48 +618,40 @@ font_slant(const FontInfo &finfo)
     return -tan(val * M_PI / 180.0) + slant;
 }
 
-static void
-output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
-	  const FontInfo &finfo, bool vpl,
-	  const String &filename, ErrorHandler *errh)
+static String
+pl_real(const char *format, double value)
 {
-    // create file
-    if (no_create) {
-	errh->message("would create %s", filename.c_str());
-	return;
-    }
-
-    if (verbose)
-	errh->message("creating %s", filename.c_str());
-    FILE *f = fopen(filename.c_str(), "w");
-    if (!f) {
-	errh->error("%s: %s", filename.c_str(), strerror(errno));
-	return;
-    }
+    char buf[128];
+    sprintf(buf, format, value);
+    return String(buf);
+}
 
+static void
+build_pl(Metrics &metrics, const String &ps_name, int boundary_char,
+	 const FontInfo &finfo, bool vpl,
+	 PlFont &pl, PlNames &names, ErrorHandler *errh)
+{
     // XXX check DESIGNSIZE and DESIGNUNITS for correctness
 
-    fprintf(f, "(COMMENT Created by '%s'%s)\n", invocation.c_str(), current_time.c_str());
-
     // calculate a TeX FAMILY name using afm2tfm's algorithm
     String family_name = String("TeX-") + ps_name;
     if (family_name.length() > 19)
 	family_name = family_name.substring(0, 9) + family_name.substring(-10);
-    fprintf(f, "(FAMILY %s)\n", family_name.c_str());
+    pl.family = family_name;
 
-    if (metrics.coding_scheme())
-	fprintf(f, "(CODINGSCHEME %.39s)\n", String(metrics.coding_scheme()).c_str());
+    if (metrics.coding_scheme()) {
+	pl.coding_scheme = String(metrics.coding_scheme());
+	if (pl.coding_scheme.length() > 39)
+	    pl.coding_scheme = pl.coding_scheme.substring(0, 39);
+    }
     int design_units = metrics.design_units();
 
     if (design_size <= 0)
 	design_size = get_design_size(finfo);
     max_printed_real = 0;
 
-    fprintf(f, "(DESIGNSIZE R %.1f)\n"
-	    "(DESIGNUNITS R %d.0)\n"
-	    "(COMMENT DESIGNSIZE (1 em) IS IN POINTS)\n"
-	    "(COMMENT OTHER DIMENSIONS ARE MULTIPLES OF DESIGNSIZE/%d)\n"
-	    "(FONTDIMEN\n", design_size, design_units, design_units);
+    pl.design_size = pl_real("%.1f", design_size);
+    pl.design_units = String(design_units) + ".0";
 
     // figure out font dimensions
     Transform font_xform;
@@ -619,37 +660,44 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
     if (slant)
 	font_xform.shear(slant);
     double bounds[4], width;
-    Printer pr(f, design_units, metrics.units_per_em());
+    Printer pr(design_units, metrics.units_per_em());
 
     double actual_slant = font_slant(finfo);
-    if (actual_slant)
-	fprintf(f, "   (SLANT R %g)\n", actual_slant);
+    if (actual_slant) {
+	pl.param_numbers.push_back(1);
+	pl.params.push_back(pl_real("%g", actual_slant));
+    }
 
     if (char_bounds(bounds, width, finfo, font_xform, ' ')) {
 	// advance space width by letterspacing, scale by space_factor
 	double space_width = (width + (vpl ? letterspace : 0)) * space_factor;
-	pr.print("   (SPACE", space_width);
+	pl.param_numbers.push_back(2);
+	pl.params.push_back(pr.print(space_width));
+	pl.param_numbers.push_back(3);
+	pl.param_numbers.push_back(4);
+	pl.param_numbers.push_back(7);
 	if (finfo.is_fixed_pitch()) {
 	    // fixed-pitch: no space stretch or shrink
-	    pr.print("   (STRETCH", 0);
-	    pr.print("   (SHRINK", 0);
-	    pr.print("   (EXTRASPACE", space_width);
+	    pl.params.push_back(pr.print(0));
+	    pl.params.push_back(pr.print(0));
+	    pl.params.push_back(pr.print(space_width));
 	} else {
-	    pr.print("   (STRETCH", space_width / 2.);
-	    pr.print("   (SHRINK", space_width / 3.);
-	    pr.print("   (EXTRASPACE", space_width / 6.);
+	    pl.params.push_back(pr.print(space_width / 2.));
+	    pl.params.push_back(pr.print(space_width / 3.));
+	    pl.params.push_back(pr.print(space_width / 6.));
 	}
     }
 
     double x_height = finfo.x_height(font_xform);
-    if (x_height < finfo.units_per_em())
-	pr.print("   (XHEIGHT", x_height);
+    if (x_height < finfo.units_per_em()) {
+	pl.param_numbers.push_back(5);
+	pl.params.push_back(pr.print(x_height));
+    }
 
-    pr.print("   (QUAD", finfo.units_per_em());
-    fprintf(f, "   )\n");
+    pl.param_numbers.push_back(6);
+    pl.params.push_back(pr.print(finfo.units_per_em()));
 
-    if (boundary_char >= 0)
-	fprintf(f, "(BOUNDARYCHAR D %d)\n", boundary_char);
+    pl.boundary_char = boundary_char;
 
     // figure out font mapping
     int mapped_font0 = 0;
@@ -685,16 +733,19 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
 	    String name = metrics.mapped_font_name(j);
 	    if (!name)
 		name = make_base_font_name(font_name);
-	    fprintf(f, "(MAPFONT D %d\n   (FONTNAME %s)\n   (FONTDSIZE R %.1f)\n   )\n", i, name.c_str(), design_size);
+	    pl.map_font_names.push_back(name);
+	    pl.map_font_dsizes.push_back(pl_real("%.1f", design_size));
 	}
     } else
 	for (int i = 0; i < metrics.n_mapped_fonts(); i++)
 	    font_mapping.push_back(i);
 
     // figure out the proper names and numbers for glyphs
-    Vector<String> glyph_ids;
-    Vector<String> glyph_comments(257, String());
-    Vector<String> glyph_base_comments(257, String());
+    Vector<String> &glyph_ids = names.ids;
+    Vector<String> &glyph_comments = names.comments;
+    Vector<String> &glyph_base_comments = names.base_comments;
+    glyph_comments.assign(257, String());
+    glyph_base_comments.assign(257, String());
     for (int i = 0; i < metrics.encoding_size(); i++) {
 	if (metrics.glyph(i)) {
 	    PermString name = metrics.code_name(i), expected_name;
@@ -733,71 +784,75 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
     glyph_ids.push_back("BOUNDARYCHAR");
 
     // LIGTABLE
-    fprintf(f, "(LIGTABLE\n");
     Vector<int> lig_code2, lig_outcode, lig_context, kern_code2, kern_amt;
+    Vector<PlFont::LigKern> steps;
     // don't print KRN x after printing LIG x
     uint32_t used[8];
-    bool any_ligs = false;
     for (int i = 0; i <= 256; i++)
 	if (metrics.glyph(i) && minimum_kern < 10000) {
 	    int any_lig = metrics.ligatures(i, lig_code2, lig_outcode, lig_context);
 	    int any_kern = metrics.kerns(i, kern_code2, kern_amt);
 	    if (any_lig || any_kern) {
-		StringAccum kern_sa;
+		steps.clear();
 		memset(&used[0], 0, 32);
 		for (int j = 0; j < lig_code2.size(); j++) {
-		    kern_sa << "   (" << lig_context_str(lig_context[j])
-			    << ' ' << glyph_ids[lig_code2[j]]
-			    << ' ' << glyph_ids[lig_outcode[j]]
-			    << ')' << glyph_comments[lig_code2[j]]
-			    << glyph_comments[lig_outcode[j]] << '\n';
+		    int op = (lig_context[j] == 0 ? 0 : (lig_context[j] < 0 ? 2 : 1));
+		    steps.push_back(PlFont::LigKern(PlFont::LigKern::LIG, op, lig_code2[j], lig_outcode[j]));
 		    used[lig_code2[j] >> 5] |= (1 << (lig_code2[j] & 0x1F));
 		}
 		for (Vector<int>::const_iterator k2 = kern_code2.begin(); k2 < kern_code2.end(); k2++)
 		    if (!(used[*k2 >> 5] & (1 << (*k2 & 0x1F)))) {
 			double this_kern = kern_amt[k2 - kern_code2.begin()];
 			if (fabs(this_kern) >= minimum_kern)
-			    kern_sa << "   (KRN " << glyph_ids[*k2]
-				    << " R " << pr.render(this_kern)
-				    << ')' << glyph_comments[*k2] << '\n';
+			    steps.push_back(PlFont::LigKern(PlFont::LigKern::KRN, 0, *k2, 0, pr.render(this_kern)));
 		    }
-		if (kern_sa) {
-		    if (any_ligs)
-			fprintf(f, "\n");
-		    fprintf(f, "   (LABEL %s)%s\n%s   (STOP)\n", glyph_ids[i].c_str(), glyph_comments[i].c_str(), kern_sa.c_str());
-		    any_ligs = true;
+		if (steps.size()) {
+		    pl.lig_kerns.push_back(PlFont::LigKern(PlFont::LigKern::LABEL, 0, i));
+		    for (const PlFont::LigKern *st = steps.begin(); st != steps.end(); st++)
+			pl.lig_kerns.push_back(*st);
+		    pl.lig_kerns.push_back(PlFont::LigKern(PlFont::LigKern::STOP));
 		}
 	    }
 	}
-    fprintf(f, "   )\n");
 
     // CHARACTERs
     Vector<Setting> settings;
-    StringAccum sa;
     Vector<Point> push_stack;
 
+    // compute the bounds of lone glyphs in bulk
+    {
+	Vector<OpenType::Glyph> glyphs;
+	for (int i = 0; i < 256; i++)
+	    if (metrics.setting(i, settings) && settings.size() == 1
+		&& settings[0].op == Setting::SHOW)
+		glyphs.push_back(settings[0].y);
+	finfo.prefetch_glyph_bounds(font_xform, glyphs);
+    }
+
     for (int i = 0; i < 256; i++)
 	if (metrics.setting(i, settings)) {
-	    fprintf(f, "(CHARACTER %s%s\n", glyph_ids[i].c_str(), glyph_comments[i].c_str());
+	    pl.chars.push_back(PlFont::Char(i));
+	    PlFont::Char &pc = pl.chars.back();
 
 	    // unparse settings into DVI commands
-	    sa.clear();
 	    push_stack.clear();
 	    CharstringBounds boundser(font_xform);
+	    bool have_bounds = false;
 	    int program_number = mapped_font0;
 	    const CharstringProgram *program = finfo.program();
 	    for (const Setting *s = settings.begin(); s < settings.end(); s++)
 		switch (s->op) {
 
 		  case Setting::SHOW:
-		    if (vpl || program == finfo.program())
+		    // a lone glyph, the common case, can use cached bounds
+		    if (settings.size() == 1 && program == finfo.program()) {
+			finfo.glyph_bounds(font_xform, s->y, bounds, width);
+			have_bounds = true;
+		    } else if (vpl || program == finfo.program())
 			boundser.char_bounds(program->glyph_context(s->y));
 		    // 3.Aug.2004 -- reported by Marco Kuhlmann: Don't use
 		    // glyph_ids[] array when looking at a different font.
-		    if (program_number == 0)
-			sa << "      (SETCHAR " << glyph_ids[s->x] << ')' << glyph_base_comments[s->x] << "\n";
-		    else
-			sa << "      (SETCHAR D " << s->x << ")\n";
+		    pc.map.push_back(PlFont::Command(PlFont::Command::SETCHAR, s->x, program_number));
 		    break;
 
 		  case Setting::MOVE: {
@@ -807,9 +862,9 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
 		      if (vpl)
 			  boundser.translate(s->x + x, s->y + y);
 		      if (s->x + x)
-			  sa << "      (MOVERIGHT R " << pr.render(s->x + x) << ")\n";
+			  pc.map.push_back(PlFont::Command(PlFont::Command::MOVERIGHT, 0, 0, pr.render(s->x + x)));
 		      if (s->y + y)
-			  sa << "      (MOVEUP R " << pr.render(s->y + y) << ")\n";
+			  pc.map.push_back(PlFont::Command(PlFont::Command::MOVEUP, 0, 0, pr.render(s->y + y)));
 		      break;
 		  }
 
@@ -819,20 +874,20 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
 			boundser.mark(Point(s->x, s->y));
 			boundser.translate(s->x, 0);
 		    }
-		    sa << "      (SETRULE R " << pr.render(s->y) << " R " << pr.render(s->x) << ")\n";
+		    pc.map.push_back(PlFont::Command(PlFont::Command::SETRULE, 0, 0, pr.render(s->y), pr.render(s->x)));
 		    break;
 
 		  case Setting::FONT:
 		    if ((int) s->x != program_number) {
 			program = metrics.mapped_font((int) s->x);
 			program_number = (int) s->x;
-			sa << "      (SELECTFONT D " << font_mapping[program_number] << ")\n";
+			pc.map.push_back(PlFont::Command(PlFont::Command::SELECTFONT, font_mapping[program_number]));
 		    }
 		    break;
 
 		  case Setting::PUSH:
 		    push_stack.push_back(boundser.transform(Point(0, 0)));
-		    sa << "      (PUSH)\n";
+		    pc.map.push_back(PlFont::Command(PlFont::Command::PUSH));
 		    break;
 
 		  case Setting::POP: {
@@ -841,49 +896,31 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
 		      if (vpl)
 			  boundser.translate(p.x, p.y);
 		      push_stack.pop_back();
-		      sa << "      (POP)\n";
+		      pc.map.push_back(PlFont::Command(PlFont::Command::POP));
 		      break;
 		  }
 
-		  case Setting::SPECIAL: {
-		      bool needhex = false;
-		      for (const char *str = s->s.begin(); str < s->s.end() && !needhex; str++)
-			  if (*str < ' ' || *str > '~' || *str == '(' || *str == ')')
-			      needhex = true;
-		      if (needhex) {
-			  sa << "      (SPECIALHEX ";
-			  for (const char *str = s->s.begin(); str < s->s.end(); str++) {
-			      static const char hexdig[] = "0123456789ABCDEF";
-			      int val = (unsigned char) *str;
-			      sa << hexdig[val >> 4] << hexdig[val & 0xF];
-			  }
-			  sa << ")\n";
-		      } else
-			  sa << "      (SPECIAL " << s->s << ")\n";
-		      break;
-		  }
+		  case Setting::SPECIAL:
+		    pc.map.push_back(PlFont::Command(PlFont::Command::SPECIAL, 0, 0, s->s));
+		    break;
 
 		}
 
 	    assert(push_stack.size() == 0);
 
 	    // output information
-	    boundser.output(bounds, width);
-	    pr.print("   (CHARWD", width);
+	    if (!have_bounds)
+		boundser.output(bounds, width);
+	    pc.wd = pr.print(width);
 	    if (bounds[3] > 0)
-		pr.print("   (CHARHT", bounds[3]);
+		pc.ht = pr.print(bounds[3]);
 	    if (bounds[1] < 0)
-		pr.print("   (CHARDP", -bounds[1]);
+		pc.dp = pr.print(-bounds[1]);
 	    if (bounds[2] > width)
-		pr.print_transformed("   (CHARIC", pr.transform(bounds[2]) - pr.transform(width));
-	    if (vpl && (settings.size() > 1 || settings[0].op != Setting::SHOW))
-		fprintf(f, "   (MAP\n%s      )\n", sa.c_str());
-	    fprintf(f, "   )\n");
+		pc.ic = pr.print_transformed(pr.transform(bounds[2]) - pr.transform(width));
+	    pc.has_map = vpl && (settings.size() > 1 || settings[0].op != Setting::SHOW);
 	}
 
-    // at last, close the file
-    fclose(f);
-
     // Did we print a number too big for TeX to handle?  If so, try again.
     if (max_printed_real >= 2047) {
 	if (metrics.design_units() <= 1)
@@ -891,8 +928,161 @@ output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
 	metrics.set_design_units(metrics.design_units() > 200 ? metrics.design_units() - 250 : 1);
 	if (verbose)
 	    errh->message("the font%,s metrics overflow the limits of PL files\n(reducing DESIGNUNITS to %d and trying again)", metrics.design_units());
-	output_pl(metrics, ps_name, boundary_char, finfo, vpl, filename, errh);
+	pl = PlFont();
+	names = PlNames();
+	build_pl(metrics, ps_name, boundary_char, finfo, vpl, pl, names, errh);
+    }
+}
+
+static void
+print_pl(const PlFont &pl, const PlNames &names, int design_units, FILE *f)
+{
+    static const char * const param_names[] = {
+	0, "SLANT", "SPACE", "STRETCH", "SHRINK", "XHEIGHT", "QUAD", "EXTRASPACE"
+    };
+    const Vector<String> &glyph_ids = names.ids;
+    const Vector<String> &glyph_comments = names.comments;
+    const Vector<String> &glyph_base_comments = names.base_comments;
+
+    fprintf(f, "(COMMENT Created by '%s'%s)\n", invocation.c_str(), current_time.c_str());
+    fprintf(f, "(FAMILY %s)\n", pl.family.c_str());
+    if (pl.coding_scheme)
+	fprintf(f, "(CODINGSCHEME %s)\n", pl.coding_scheme.c_str());
+
+    fprintf(f, "(DESIGNSIZE R %s)\n"
+	    "(DESIGNUNITS R %s)\n"
+	    "(COMMENT DESIGNSIZE (1 em) IS IN POINTS)\n"
+	    "(COMMENT OTHER DIMENSIONS ARE MULTIPLES OF DESIGNSIZE/%d)\n"
+	    "(FONTDIMEN\n", pl.design_size.c_str(), pl.design_units.c_str(), design_units);
+    for (int i = 0; i < pl.params.size(); i++)
+	fprintf(f, "   (%s R %s)\n", param_names[pl.param_numbers[i]], pl.params[i].c_str());
+    fprintf(f, "   )\n");
+
+    if (pl.boundary_char >= 0)
+	fprintf(f, "(BOUNDARYCHAR D %d)\n", pl.boundary_char);
+
+    for (int i = 0; i < pl.map_font_names.size(); i++)
+	fprintf(f, "(MAPFONT D %d\n   (FONTNAME %s)\n   (FONTDSIZE R %s)\n   )\n", i, pl.map_font_names[i].c_str(), pl.map_font_dsizes[i].c_str());
+
+    // LIGTABLE
+    fprintf(f, "(LIGTABLE\n");
+    StringAccum sa;
+    for (const PlFont::LigKern *lk = pl.lig_kerns.begin(); lk != pl.lig_kerns.end(); lk++) {
+	sa.clear();
+	switch (lk->type) {
+	  case PlFont::LigKern::LABEL:
+	    if (lk != pl.lig_kerns.begin())
+		sa << '\n';
+	    sa << "   (LABEL " << glyph_ids[lk->c] << ')' << glyph_comments[lk->c] << '\n';
+	    break;
+	  case PlFont::LigKern::LIG:
+	    sa << "   (" << lig_context_str(lk->op == 0 ? 0 : (lk->op == 2 ? -1 : 1))
+	       << ' ' << glyph_ids[lk->c]
+	       << ' ' << glyph_ids[lk->result]
+	       << ')' << glyph_comments[lk->c]
+	       << glyph_comments[lk->result] << '\n';
+	    break;
+	  case PlFont::LigKern::KRN:
+	    sa << "   (KRN " << glyph_ids[lk->c]
+	       << " R " << lk->kern
+	       << ')' << glyph_comments[lk->c] << '\n';
+	    break;
+	  case PlFont::LigKern::STOP:
+	    sa << "   (STOP)\n";
+	    break;
+	}
+	fwrite(sa.data(), 1, sa.length(), f);
+    }
+    fprintf(f, "   )\n");
+
+    // CHARACTERs
+    for (const PlFont::Char *pc = pl.chars.begin(); pc != pl.chars.end(); pc++) {
+	fprintf(f, "(CHARACTER %s%s\n", glyph_ids[pc->code].c_str(), glyph_comments[pc->code].c_str());
+	fprintf(f, "   (CHARWD R %s)\n", pc->wd.c_str());
+	if (pc->ht)
+	    fprintf(f, "   (CHARHT R %s)\n", pc->ht.c_str());
+	if (pc->dp)
+	    fprintf(f, "   (CHARDP R %s)\n", pc->dp.c_str());
+	if (pc->ic)
+	    fprintf(f, "   (CHARIC R %s)\n", pc->ic.c_str());
+	if (pc->has_map) {
+	    sa.clear();
+	    for (const PlFont::Command *cmd = pc->map.begin(); cmd != pc->map.end(); cmd++)
+		switch (cmd->type) {
+		  case PlFont::Command::SETCHAR:
+		    if (cmd->font == 0)
+			sa << "      (SETCHAR " << glyph_ids[cmd->c] << ')' << glyph_base_comments[cmd->c] << "\n";
+		    else
+			sa << "      (SETCHAR D " << cmd->c << ")\n";
+		    break;
+		  case PlFont::Command::MOVERIGHT:
+		    sa << "      (MOVERIGHT R " << cmd->a << ")\n";
+		    break;
+		  case PlFont::Command::MOVEUP:
+		    sa << "      (MOVEUP R " << cmd->a << ")\n";
+		    break;
+		  case PlFont::Command::SETRULE:
+		    sa << "      (SETRULE R " << cmd->a << " R " << cmd->b << ")\n";
+		    break;
+		  case PlFont::Command::SELECTFONT:
+		    sa << "      (SELECTFONT D " << cmd->c << ")\n";
+		    break;
+		  case PlFont::Command::PUSH:
+		    sa << "      (PUSH)\n";
+		    break;
+		  case PlFont::Command::POP:
+		    sa << "      (POP)\n";
+		    break;
+		  case PlFont::Command::SPECIAL: {
+		      bool needhex = false;
+		      for (const char *str = cmd->a.begin(); str < cmd->a.end() && !needhex; str++)
+			  if (*str < ' ' || *str > '~' || *str == '(' || *str == ')')
+			      needhex = true;
+		      if (needhex) {
+			  sa << "      (SPECIALHEX ";
+			  for (const char *str = cmd->a.begin(); str < cmd->a.end(); str++) {
+			      static const char hexdig[] = "0123456789ABCDEF";
+			      int val = (unsigned char) *str;
+			      sa << hexdig[val >> 4] << hexdig[val & 0xF];
+			  }
+			  sa << ")\n";
+		      } else
+			  sa << "      (SPECIAL " << cmd->a << ")\n";
+		      break;
+		  }
+		}
+	    fprintf(f, "   (MAP\n%s      )\n", sa.c_str());
+	}
+	fprintf(f, "   )\n");
+    }
+}
+
+static void
+output_pl(Metrics &metrics, const String &ps_name, int boundary_char,
+	  const FontInfo &finfo, bool vpl,
+	  const String &filename, ErrorHandler *errh)
+{
+    // create file
+    if (no_create) {
+	errh->message("would create %s", filename.c_str());
+	return;
     }
+
+    if (verbose)
+	errh->message("creating %s", filename.c_str());
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f) {
+	errh->error("%s: %s", filename.c_str(), strerror(errno));
+	return;
+    }
+
+    PlFont pl;
+    PlNames names;
+    build_pl(metrics, ps_name, boundary_char, finfo, vpl, pl, names, errh);
+    print_pl(pl, names, metrics.design_units(), f);
+
+    // at last, close the file
+    fclose(f);
 }
 
 struct Lookup {
@@ -1134,9 +1324,9 @@ output_encoding(const Metrics &metrics,
 }
 
 static void
-output_tfm(Metrics &metrics, const String &ps_name, int boundary_char,
-	   const FontInfo &finfo, String tfm_filename, String vf_filename,
-	   ErrorHandler *errh)
+output_tfm_pltotf(Metrics &metrics, const String &ps_name, int boundary_char,
+		  const FontInfo &finfo, String tfm_filename, String vf_filename,
+		  ErrorHandler *errh)
 {
     String pl_filename;
     bool vpl = vf_filename;
@@ -1209,6 +1399,34 @@ output_tfm(Metrics &metrics, const String &ps_name, int boundary_char,
     }
 }
 
+static void
+output_tfm(Metrics &metrics, const String &ps_name, int boundary_char,
+	   const FontInfo &finfo, String tfm_filename, String vf_filename,
+	   ErrorHandler *errh)
+{
+    if (use_pltotf) {
+	output_tfm_pltotf(metrics, ps_name, boundary_char, finfo, tfm_filename, vf_filename, errh);
+	return;
+    }
+
+    bool vpl = vf_filename;
+    if (no_create) {
+	errh->message("would create %s", tfm_filename.c_str());
+	if (vpl)
+	    errh->message("would create %s", vf_filename.c_str());
+    } else {
+	PlFont pl;
+	PlNames names;
+	build_pl(metrics, ps_name, boundary_char, finfo, vpl, pl, names, errh);
+	if (!write_tfm(pl, tfm_filename, vf_filename, errh))
+	    return;
+    }
+
+    update_odir(O_TFM, tfm_filename, errh);
+    if (vpl)
+	update_odir(O_VF, vf_filename, errh);
+}
+
 void
 output_metrics(Metrics &metrics, const String &ps_name, int boundary_char,
 	       const FontInfo &finfo,
@@ -1364,52 +1582,89 @@ static String otf_filename;
 static String
 main_dvips_map(const String &ps_name, const FontInfo &finfo, ErrorHandler *errh)
 {
-    if (String fn = installed_type1(otf_filename, ps_name, (output_flags & G_TYPE1) != 0, errh))
+    if (String fn = installed_type1(finfo.cff, ps_name, (output_flags & G_TYPE1) != 0, errh))
 	return "<" + pathname_filename(fn);
     if (!finfo.cff) {
 	String ttf_fn, t42_fn;
-	ttf_fn = installed_truetype(otf_filename, (output_flags & G_TRUETYPE) != 0, errh);
-	t42_fn = installed_type42(otf_filename, ps_name, (output_flags & G_TYPE42) != 0, errh);
+	// map files can't name a face of a collection, so only Type 42
+	// versions of later faces are useful
+	if (finfo.otf->face() == 0)
+	    ttf_fn = installed_truetype(otf_filename, (output_flags & G_TRUETYPE) != 0, errh);
+	t42_fn = installed_type42(otf_filename, finfo.otf->face(), ps_name, (output_flags & G_TYPE42) != 0, errh);
 	if (t42_fn && (!ttf_fn || (output_flags & G_TYPE42) != 0))
 	    return "<" + pathname_filename(t42_fn);
 	else if (ttf_fn)
 	    return "<" + pathname_filename(ttf_fn);
+	else if (finfo.otf->face() != 0)
+	    errh->warning("font map line refers to a collection, not its face %d", finfo.otf->face());
     }
     return "<" + pathname_filename(otf_filename);
 }
 
+static String
+glyph_set_digest(const OpenType::GlyphSet &gset)
+{
+    StringAccum sa;
+    for (OpenType::GlyphSet::iterator g = gset.begin(); g; ++g)
+	sa << (char) (*g >> 8) << (char) (*g & 0xFF);
+    MD5_CONTEXT md5;
+    md5_init(&md5);
+    md5_update(&md5, (const unsigned char *) sa.data(), sa.length());
+    char text_digest[MD5_TEXT_DIGEST_SIZE + 1];
+    md5_final_text(text_digest, &md5);
+    return String(text_digest);
+}
+
+static bool
+unparse_gsub_lookup(const OpenType::Gsub &gsub, int lookup,
+		    const OpenType::Coverage &limit, const String &limit_digest,
+		    Vector<OpenType::Substitution> &subs, FontCache *cache)
+{
+    // only rules whose inputs are in the limit coverage are unparsed, so
+    // it is part of the cache key
+    String key;
+    bool understood;
+    if (cache) {
+	key = String(lookup) + " " + limit_digest;
+	if (cache->find_substitutions(key, subs, understood))
+	    return understood;
+    }
+    OpenType::GsubLookup l = gsub.lookup(lookup);
+    understood = l.unparse_automatics(gsub, subs, limit);
+    if (cache)
+	cache->add_substitutions(key, subs, understood);
+    return understood;
+}
+
 static void
-do_gsub(Metrics& metrics, const OpenType::Font& otf,
+do_gsub(Metrics& metrics, const FontInfo& finfo,
 	DvipsEncoding& dvipsenc, bool dvipsenc_literal,
 	HashMap<uint32_t, int>& feature_usage,
-	const Vector<PermString>& glyph_names, ErrorHandler* errh)
+	const Vector<PermString>& glyph_names, FontCache *cache,
+	ErrorHandler* errh)
 {
     // find activated GSUB features
-    OpenType::Gsub gsub(otf.table("GSUB"), &otf, errh);
+    const OpenType::Gsub &gsub = finfo.gsub(errh);
     Vector<Lookup> lookups(gsub.nlookups(), Lookup());
     find_lookups(gsub.script_list(), gsub.feature_list(), lookups, errh);
 
     // find all characters that might result
-    Vector<bool> used(glyph_names.size(), false);
-    for (Metrics::Code c = 0; c < metrics.encoding_size(); ++c) {
-	Metrics::Glyph g = metrics.glyph(c);
-	if (g >= 0 && g < used.size())
-	    used[g] = true;
-    }
+    OpenType::GlyphSet used;
+    metrics.encoded_glyphs(used, glyph_names.size());
     for (int i = 0; i < lookups.size(); ++i)
 	if (lookups[i].used) {
 	    OpenType::GsubLookup l = gsub.lookup(i);
 	    l.mark_out_glyphs(gsub, used);
 	}
-    OpenType::Coverage used_coverage(used);
+    OpenType::Coverage used_coverage = used.coverage();
+    String used_digest = (cache ? glyph_set_digest(used) : String());
 
     // apply activated GSUB features
     Vector<OpenType::Substitution> subs;
     for (int i = 0; i < lookups.size(); i++)
 	if (lookups[i].used) {
-	    OpenType::GsubLookup l = gsub.lookup(i);
 	    subs.clear();
-	    bool understood = l.unparse_automatics(gsub, subs, used_coverage);
+	    bool understood = unparse_gsub_lookup(gsub, i, used_coverage, used_digest, subs, cache);
 
 	    // check for -ffina, which should apply only at the ends of words,
 	    // and -finit, which should apply only at the beginnings.
@@ -1446,12 +1701,21 @@ do_gsub(Metrics& metrics, const OpenType::Font& otf,
 	altselector_feature_filters.swap(feature_filters);
 	Vector<Lookup> alt_lookups(gsub.nlookups(), Lookup());
 	find_lookups(gsub.script_list(), gsub.feature_list(), alt_lookups, ErrorHandler::silent_handler());
+
+	// alternates may chain, so their outputs join the limit set
+	for (int i = 0; i < alt_lookups.size(); ++i)
+	    if (alt_lookups[i].used) {
+		OpenType::GsubLookup l = gsub.lookup(i);
+		l.mark_out_glyphs(gsub, used);
+	    }
+	OpenType::Coverage alt_coverage = used.coverage();
+	String alt_digest = (cache ? glyph_set_digest(used) : String());
+
 	Vector<OpenType::Substitution> alt_subs;
 	for (int i = 0; i < alt_lookups.size(); i++)
 	    if (alt_lookups[i].used) {
-		OpenType::GsubLookup l = gsub.lookup(i);
 		alt_subs.clear();
-		(void) l.unparse_automatics(gsub, alt_subs, used_coverage);
+		(void) unparse_gsub_lookup(gsub, i, alt_coverage, alt_digest, alt_subs, cache);
 		metrics.apply_alternates(alt_subs, i, *alt_lookups[i].filter, glyph_names);
 	    }
 	altselector_features.swap(interesting_features);
@@ -1467,15 +1731,20 @@ kern_feature_requested()
 }
 
 static void
-do_try_ttf_kern(Metrics& metrics, const OpenType::Font& otf, HashMap<uint32_t, int>& feature_usage, ErrorHandler* errh)
+do_try_ttf_kern(Metrics& metrics, const OpenType::Font& otf, HashMap<uint32_t, int>& feature_usage, FontCache *cache, ErrorHandler* errh)
 {
     // if no GPOS "kern" lookups and "kern" requested, try "kern" table
     if (!kern_feature_requested())
 	return;
     try {
-	OpenType::KernTable kern(otf.table("kern"), errh);
 	Vector<OpenType::Positioning> poss;
-	bool understood = kern.unparse_automatics(poss, errh);
+	bool understood;
+	if (!cache || !cache->find_positionings("kern", poss, understood)) {
+	    OpenType::KernTable kern(otf.table("kern"), errh);
+	    understood = kern.unparse_automatics(poss, errh);
+	    if (cache)
+		cache->add_positionings("kern", poss, understood);
+	}
 	int nunderstood = metrics.apply(poss);
 
 	// mark as used
@@ -1488,10 +1757,32 @@ do_try_ttf_kern(Metrics& metrics, const OpenType::Font& otf, HashMap<uint32_t, i
     }
 }
 
+static bool
+unparse_gpos_lookup(const OpenType::Gpos &gpos, int lookup,
+		    const OpenType::Coverage &limit, const String &limit_digest,
+		    Vector<OpenType::Positioning> &poss, FontCache *cache,
+		    ErrorHandler *errh)
+{
+    // only positionings among the limit glyphs are unparsed, so the limit
+    // is part of the cache key
+    String key;
+    bool understood;
+    if (cache) {
+	key = String(lookup) + " " + limit_digest;
+	if (cache->find_positionings(key, poss, understood))
+	    return understood;
+    }
+    OpenType::GposLookup l = gpos.lookup(lookup);
+    understood = l.unparse_automatics(poss, limit, errh);
+    if (cache)
+	cache->add_positionings(key, poss, understood);
+    return understood;
+}
+
 static void
-do_gpos(Metrics& metrics, const OpenType::Font& otf, HashMap<uint32_t, int>& feature_usage, ErrorHandler* errh)
+do_gpos(Metrics& metrics, const FontInfo& finfo, HashMap<uint32_t, int>& feature_usage, const Vector<PermString>& glyph_names, FontCache *cache, ErrorHandler* errh)
 {
-    OpenType::Gpos gpos(otf.table("GPOS"), errh);
+    const OpenType::Gpos &gpos = finfo.gpos(errh);
     Vector<Lookup> lookups(gpos.nlookups(), Lookup());
     find_lookups(gpos.script_list(), gpos.feature_list(), lookups, errh);
 
@@ -1502,16 +1793,21 @@ do_gpos(Metrics& metrics, const OpenType::Font& otf, HashMap<uint32_t, int>& fea
 	for (Lookup *l = lookups.begin(); l != lookups.end(); ++l)
 	    if (std::find(l->features.begin(), l->features.end(), kern_tag) != l->features.end())
 		goto skip_ttf_kern;
-	do_try_ttf_kern(metrics, otf, feature_usage, errh);
+	do_try_ttf_kern(metrics, *finfo.otf, feature_usage, cache, errh);
     skip_ttf_kern: ;
     }
 
+    // only positionings between encoded glyphs can affect the metrics
+    OpenType::GlyphSet used;
+    metrics.encoded_glyphs(used, glyph_names.size());
+    OpenType::Coverage used_coverage = used.coverage();
+    String used_digest = (cache ? glyph_set_digest(used) : String());
+
     Vector<OpenType::Positioning> poss;
     for (int i = 0; i < lookups.size(); i++)
 	if (lookups[i].used) {
-	    OpenType::GposLookup l = gpos.lookup(i);
 	    poss.clear();
-	    bool understood = l.unparse_automatics(poss, errh);
+	    bool understood = unparse_gpos_lookup(gpos, i, used_coverage, used_digest, poss, cache, errh);
 	    int nunderstood = metrics.apply(poss);
 
 	    // mark as used
@@ -1556,11 +1852,11 @@ do_math_spacing(Metrics &metrics, const FontInfo &finfo,
 }
 
 static void
-do_file(const String &otf_filename, const OpenType::Font &otf,
+do_file(const String &otf_filename, FontInfo &finfo,
 	const DvipsEncoding &dvipsenc_in, bool dvipsenc_literal,
 	ErrorHandler *errh)
 {
-    FontInfo finfo(&otf, errh);
+    const OpenType::Font &otf = *finfo.otf;
     if (!finfo.ok())
 	return;
     if (!finfo.cff)
@@ -1598,7 +1894,7 @@ do_file(const String &otf_filename, const OpenType::Font &otf,
     if (dvipsenc_literal)
 	dvipsenc.make_metrics(metrics, finfo, 0, true, errh);
     else {
-	T1Secondary secondary(finfo, font_name, otf_filename);
+	T1Secondary secondary(finfo, font_name);
 	dvipsenc.make_metrics(metrics, finfo, &secondary, false, errh);
     }
 
@@ -1607,7 +1903,7 @@ do_file(const String &otf_filename, const OpenType::Font &otf,
 
     // apply activated GSUB features
     try {
-	do_gsub(metrics, otf, dvipsenc, dvipsenc_literal, feature_usage, glyph_names, errh);
+	do_gsub(metrics, finfo, dvipsenc, dvipsenc_literal, feature_usage, glyph_names, finfo.cache, errh);
     } catch (OpenType::BlankTable) {
 	// nada
     } catch (OpenType::Error e) {
@@ -1626,9 +1922,9 @@ do_file(const String &otf_filename, const OpenType::Font &otf,
 
     // apply activated GPOS features
     try {
-	do_gpos(metrics, otf, feature_usage, errh);
+	do_gpos(metrics, finfo, feature_usage, glyph_names, finfo.cache, errh);
     } catch (OpenType::BlankTable) {
-	do_try_ttf_kern(metrics, otf, feature_usage, errh);
+	do_try_ttf_kern(metrics, otf, feature_usage, finfo.cache, errh);
     } catch (OpenType::Error e) {
 	errh->warning("GPOS %<%s%> error, continuing", e.description.c_str());
     }
@@ -1811,46 +2107,9 @@ parse_base_encodings(const String &filename, ErrorHandler *errh)
     }
 }
 
-int
-main(int argc, char *argv[])
+static void
+parse_options(Clp_Parser *clp, ErrorHandler *&errh)
 {
-#ifndef WIN32
-    handle_sigchld();
-#endif
-    Clp_Parser *clp =
-	Clp_NewParser(argc, (const char * const *)argv, sizeof(options) / sizeof(options[0]), options);
-    Clp_AddType(clp, CHAR_OPTTYPE, 0, clp_parse_char, 0);
-    program_name = Clp_ProgramName(clp);
-#if HAVE_KPATHSEA
-    kpsei_init(argv[0], "lcdftools");
-#endif
-#ifdef HAVE_CTIME
-    {
-	time_t t = time(0);
-	char *c = ctime(&t);
-	current_time = " on " + String(c).substring(0, -1); // get rid of \n
-    }
-#endif
-    for (int i = 0; i < argc; i++)
-	invocation << (i ? " " : "") << argv[i];
-
-    ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
-    const char *input_file = 0;
-    Vector<String> glyphlist_files;
-    bool literal_encoding = false;
-    bool have_encoding_file = false;
-    Vector<String> ligkern;
-    Vector<String> pos;
-    Vector<String> unicoding;
-    Vector<String> base_encoding_files;
-    bool no_ecommand = false, default_ligkern = true;
-    int warn_missing = -1;
-    String codingscheme;
-
-    GlyphFilter current_substitution_filter;
-    GlyphFilter current_alternate_filter;
-    GlyphFilter* current_filter_ptr = &null_filter;
-
     while (1) {
 	int opt = Clp_Next(clp);
 	switch (opt) {
@@ -1980,11 +2239,11 @@ main(int argc, char *argv[])
 	    break;
 
 	  case LIGKERN_OPT:
-	    ligkern.push_back(clp->vstr);
+	    ligkern_commands.push_back(clp->vstr);
 	    break;
 
 	  case POSITION_OPT:
-	    pos.push_back(clp->vstr);
+	    position_commands.push_back(clp->vstr);
 	    break;
 
 	  case WARN_MISSING_OPT:
@@ -2000,11 +2259,11 @@ main(int argc, char *argv[])
 	    break;
 
 	  case BOUNDARY_CHAR_OPT:
-	    ligkern.push_back(String("|| = ") + String(clp->val.i));
+	    ligkern_commands.push_back(String("|| = ") + String(clp->val.i));
 	    break;
 
 	  case ALTSELECTOR_CHAR_OPT:
-	    ligkern.push_back(String("^^ = ") + String(clp->val.i));
+	    ligkern_commands.push_back(String("^^ = ") + String(clp->val.i));
 	    break;
 
 	  case ALTSELECTOR_FEATURE_OPT: {
@@ -2037,7 +2296,7 @@ main(int argc, char *argv[])
 	    break;
 
 	  case UNICODING_OPT:
-	    unicoding.push_back(clp->vstr);
+	    unicoding_commands.push_back(clp->vstr);
 	    break;
 
 	  case CODINGSCHEME_OPT:
@@ -2182,6 +2441,28 @@ main(int argc, char *argv[])
 	    force = !clp->negated;
 	    break;
 
+	  case BATCH_OPT:
+	    if (batch_file)
+		usage_error(errh, "batch file specified twice");
+	    batch_file = clp->vstr;
+	    break;
+
+	  case USE_PLTOTF_OPT:
+	    use_pltotf = !clp->negated;
+	    break;
+
+	  case JOBS_OPT:
+	    batch_jobs = (clp->val.u ? clp->val.u : 1);
+	    break;
+
+	  case CACHE_DIR_OPT:
+	    cache_directory = clp->vstr;
+	    break;
+
+	  case FACE_OPT:
+	    font_face = clp->val.u;
+	    break;
+
 	  case KPATHSEA_DEBUG_OPT:
 #if HAVE_KPATHSEA
 	    kpsei_set_debug_flags(clp->val.u);
@@ -2231,7 +2512,7 @@ particular purpose.\n");
 	    break;
 
 	  case Clp_Done:
-	    goto done;
+	    return;
 
 	  case Clp_BadOption:
 	    usage_error(errh, 0);
@@ -2243,7 +2524,11 @@ particular purpose.\n");
 	}
     }
 
-  done:
+}
+
+static void
+finish_options(ErrorHandler *errh)
+{
     // check for odd option combinations
     if (warn_missing > 0 && !(output_flags & G_VMETRICS))
 	errh->warning("%<--warn-missing%> has no effect with %<--no-virtual%>");
@@ -2267,105 +2552,391 @@ particular purpose.\n");
 	errh->message("(--include-*, --exclude-*, and --*-filter options must occur\nbefore the feature options to which they should apply.)");
     }
 
-    try {
-	// read font
-	otf_data = read_file(input_file, errh);
-	if (errh->nerrors())
+    // figure out scripts we care about
+    if (!interesting_scripts.size()) {
+	interesting_scripts.push_back(Efont::OpenType::Tag("latn"));
+	interesting_scripts.push_back(Efont::OpenType::Tag());
+    }
+    std::sort(interesting_features.begin(), interesting_features.end());
+    std::sort(altselector_features.begin(), altselector_features.end());
+}
+
+static void
+read_glyphlists(int first_glyphlist, ErrorHandler *errh)
+{
+    // find glyphlist
+    if (!glyphlist_files.size()) {
+#if HAVE_KPATHSEA
+	if (String g = kpsei_find_file("glyphlist.txt", KPSEI_FMT_MAP)) {
+	    glyphlist_files.push_back(g);
+	    if (verbose)
+		errh->message("glyphlist.txt found with kpathsea at %s", g.c_str());
+	} else
+#endif
+	    glyphlist_files.push_back(GLYPHLISTDIR "/glyphlist.txt");
+#if HAVE_KPATHSEA
+	if (String g = kpsei_find_file("texglyphlist.txt", KPSEI_FMT_MAP)) {
+	    glyphlist_files.push_back(g);
+	    if (verbose)
+		errh->message("texglyphlist.txt found with kpathsea at %s", g.c_str());
+	} else
+#endif
+	    glyphlist_files.push_back(GLYPHLISTDIR "/texglyphlist.txt");
+    }
+
+    // read glyphlist
+    for (String *g = glyphlist_files.begin() + first_glyphlist; g < glyphlist_files.end(); g++)
+	if (String s = read_file(*g, errh, true))
+	    DvipsEncoding::add_glyphlist(s);
+}
+
+static void
+do_job(const OpenType::Font &otf, FontInfo &finfo, ErrorHandler *errh)
+{
+    LandmarkErrorHandler cerrh(errh, printable_filename(input_file));
+    BailErrorHandler bail_errh(&cerrh);
+
+    // read base encodings
+    for (String *s = base_encoding_files.begin(); s < base_encoding_files.end(); s++)
+	parse_base_encodings(*s, errh);
+
+    // read encoding
+    DvipsEncoding dvipsenc;
+    if (encoding_file) {
+	if (String path = locate_encoding(encoding_file, errh))
+	    dvipsenc.parse(path, no_ecommand, no_ecommand, errh);
+	else
+	    errh->fatal("encoding %<%s%> not found", encoding_file.c_str());
+    } else {
+	String cff_data(otf.table("CFF"));
+	if (!cff_data) {
+	    errh->error("explicit encoding required for TrueType fonts");
+	    errh->message("(Use %<-e ENCODING%> to choose an encoding. %<-e texnansx%> often works.)");
 	    exit(1);
+	} else if (!have_encoding_file) {
+	    errh->warning("no encoding provided");
+	    errh->message("(Use %<-e ENCODING%> to choose an encoding. %<-e texnansx%> often works,\nor say %<-e -%> to turn off this warning.)");
+	}
 
-	LandmarkErrorHandler cerrh(errh, printable_filename(input_file));
-	BailErrorHandler bail_errh(&cerrh);
+	// use encoding from font
+	Cff cff(cff_data, otf.units_per_em(), &bail_errh);
+	Cff::FontParent *font = cff.font(PermString(), &bail_errh);
+	assert(cff.ok() && font->ok());
+	if (Type1Encoding *t1e = font->type1_encoding()) {
+	    for (int i = 0; i < 256; i++)
+		dvipsenc.encode(i, (*t1e)[i]);
+	} else
+	    errh->fatal("font has no encoding, specify one explicitly");
+	delete font;
+    }
+
+    // apply default ligkern commands
+    if (default_ligkern)
+	dvipsenc.parse_ligkern(default_ligkerns, 0, ErrorHandler::silent_handler());
+
+    // apply command-line ligkern commands and coding scheme
+    cerrh.set_landmark("--ligkern command");
+    for (int i = 0; i < ligkern_commands.size(); i++)
+	dvipsenc.parse_ligkern(ligkern_commands[i], 1, &cerrh);
+    cerrh.set_landmark("--position command");
+    for (int i = 0; i < position_commands.size(); i++)
+	dvipsenc.parse_position(position_commands[i], 1, &cerrh);
+    cerrh.set_landmark("--unicoding command");
+    for (int i = 0; i < unicoding_commands.size(); i++)
+	dvipsenc.parse_unicoding(unicoding_commands[i], 1, &cerrh);
+    if (codingscheme)
+	dvipsenc.set_coding_scheme(codingscheme);
+    if (warn_missing >= 0)
+	dvipsenc.set_warn_missing(warn_missing);
+
+    // batch jobs already run in parallel
+    finfo.set_bounds_jobs(batch_file ? 1 : batch_jobs);
+
+    FontCache *cache = 0;
+    if (cache_directory)
+	finfo.cache = cache = new FontCache(otf.data_string(), otf.face(), cache_directory, errh);
+
+    do_file(input_file, finfo, dvipsenc, literal_encoding, errh);
+
+    if (cache) {
+	cache->save(errh);
+	finfo.cache = 0;
+	delete cache;
+    }
+}
 
-	OpenType::Font otf(otf_data, &bail_errh);
-	assert(otf.ok());
 
-	// figure out scripts we care about
-	if (!interesting_scripts.size()) {
-	    interesting_scripts.push_back(Efont::OpenType::Tag("latn"));
-	    interesting_scripts.push_back(Efont::OpenType::Tag());
+// BATCH MODE
+
+#if !defined(WIN32) && HAVE_WAITPID && HAVE_SYS_WAIT_H
+struct BatchFont {
+    String data;
+    OpenType::Font *otf;
+    FontInfo *finfo;
+    BatchFont(const String &d, int face, ErrorHandler *errh)
+	: data(d), otf(new OpenType::Font(data, errh, face)), finfo(0) {
+	if (otf->ok())
+	    finfo = new FontInfo(otf, errh);
+	// parse the GSUB and GPOS headers once, so every job's child
+	// inherits them; a bad table is rethrown to each job
+	if (ok()) {
+	    try {
+		(void) finfo->gsub(errh);
+	    } catch (OpenType::Error) {
+	    }
+	    try {
+		(void) finfo->gpos(errh);
+	    } catch (OpenType::Error) {
+	    }
 	}
-	std::sort(interesting_features.begin(), interesting_features.end());
-	std::sort(altselector_features.begin(), altselector_features.end());
+    }
+    bool ok() const {
+	return finfo && finfo->ok();
+    }
+};
 
-	// find glyphlist
-	if (!glyphlist_files.size()) {
-#if HAVE_KPATHSEA
-	    if (String g = kpsei_find_file("glyphlist.txt", KPSEI_FMT_MAP)) {
-		glyphlist_files.push_back(g);
-		if (verbose)
-		    errh->message("glyphlist.txt found with kpathsea at %s", g.c_str());
+extern "C" {
+static void
+clp_ignore_error(Clp_Parser *, const char *)
+{
+}
+}
+
+static void
+split_batch_line(const char *s, const char *end, Vector<String> &args)
+{
+    while (1) {
+	while (s != end && isspace((unsigned char) *s))
+	    ++s;
+	if (s == end || *s == '#' || *s == '%')
+	    return;
+	StringAccum sa;
+	while (s != end && !isspace((unsigned char) *s)) {
+	    if (*s == '\'' || *s == '\"') {
+		char quote = *s++;
+		for (; s != end && *s != quote; ++s)
+		    sa << *s;
+		if (s != end)
+		    ++s;
+	    } else if (*s == '\\' && s + 1 != end) {
+		sa << s[1];
+		s += 2;
 	    } else
+		sa << *s++;
+	}
+	args.push_back(sa.take_string());
+    }
+}
+
+static String
+batch_input_file(const Vector<String> &args, int &face)
+{
+    // Parse the job's arguments without acting on them, just to find the
+    // font file name and face.
+    Vector<const char *> argv;
+    argv.push_back(program_name);
+    for (const String *a = args.begin(); a != args.end(); ++a)
+	argv.push_back(a->c_str());
+    Clp_Parser *clp = Clp_NewParser(argv.size(), argv.begin(), sizeof(options) / sizeof(options[0]), options);
+    Clp_AddType(clp, CHAR_OPTTYPE, 0, clp_parse_char, 0);
+    Clp_SetErrorHandler(clp, clp_ignore_error);
+    String result;
+    int opt;
+    face = font_face;
+    while ((opt = Clp_Next(clp)) != Clp_Done)
+	if (opt == Clp_NotOption && !result)
+	    result = clp->vstr;
+	else if (opt == FACE_OPT)
+	    face = clp->val.u;
+    Clp_DeleteParser(clp);
+    return result;
+}
+
+static int
+run_batch_job(const Vector<String> &args, BatchFont *bf, ErrorHandler *errh)
+{
+    // This runs in a child process, so it can freely modify global state.
+    errh->clear();
+
+    Vector<const char *> argv;
+    argv.push_back(program_name);
+    for (const String *a = args.begin(); a != args.end(); ++a) {
+	argv.push_back(a->c_str());
+	invocation << ' ' << *a;
+    }
+    Clp_Parser *clp = Clp_NewParser(argv.size(), argv.begin(), sizeof(options) / sizeof(options[0]), options);
+    Clp_AddType(clp, CHAR_OPTTYPE, 0, clp_parse_char, 0);
+    int nglyphlists = glyphlist_files.size();
+    parse_options(clp, errh);
+    finish_options(errh);
+    read_glyphlists(nglyphlists, errh);
+
+    try {
+	do_job(*bf->otf, *bf->finfo, errh);
+    } catch (OpenType::Error e) {
+	errh->error("unhandled exception %<%s%>", e.description.c_str());
+    }
+
+    return (errh->nerrors() == 0 ? 0 : 1);
+}
+
+static bool
+wait_batch_job(ErrorHandler *errh)
+{
+    int status;
+    while (1) {
+	pid_t answer = waitpid(-1, &status, 0);
+	if (answer >= 0)
+	    break;
+	else if (errno != EINTR)
+	    errh->fatal("%s during wait", strerror(errno));
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int
+run_batch(ErrorHandler *errh)
+{
+    if (input_file)
+	usage_error(errh, "can%,t give a font filename with %<--batch%>");
+
+    String text = read_file(batch_file, errh);
+    if (errh->nerrors())
+	return 1;
+    read_glyphlists(0, errh);
+
+    // Concurrent jobs serialize font installation and updmap on a lock
+    // file shared by every child.
+    FILE *lock_file = 0;
+    if (batch_jobs > 1 && !(lock_file = tmpfile()))
+	errh->fatal("temporary lock file: %s", strerror(errno));
+    if (lock_file)
+	set_shared_lock_fd(fileno(lock_file));
+
+    // Parsed fonts are shared by later jobs: each job runs in a forked
+    // child, which inherits the parent's fonts, glyph lists, and options.
+    // Faces of one collection share the file's data.
+    HashMap<String, BatchFont *> fonts(0);
+    HashMap<String, String> font_data;
+    int lineno = 0, njobs = 0, nfailed = 0, nrunning = 0;
+    const char *s = text.begin(), *end = text.end();
+    while (s != end) {
+	const char *line = s;
+	while (s != end && *s != '\n' && *s != '\r')
+	    ++s;
+	const char *line_end = s;
+	if (s != end && *s == '\r')
+	    ++s;
+	if (s != end && *s == '\n')
+	    ++s;
+	++lineno;
+
+	Vector<String> args;
+	split_batch_line(line, line_end, args);
+	if (!args.size())
+	    continue;
+	++njobs;
+	LandmarkErrorHandler lerrh(errh, printable_filename(batch_file) + ":" + String(lineno));
+
+	int face;
+	String fn = batch_input_file(args, face);
+	String key = (fn && face ? String(face) + ":" + fn : fn);
+	BatchFont *bf = fonts[key];
+	if (fn && !bf) {
+	    String *data = font_data.findp(fn);
+	    if (!data) {
+		if (verbose)
+		    lerrh.message("loading %s", fn.c_str());
+		font_data.insert(fn, read_file(fn, &lerrh));
+		data = font_data.findp(fn);
+	    }
+	    LandmarkErrorHandler ferrh(&lerrh, printable_filename(fn));
+	    bf = new BatchFont(*data, face, &ferrh);
+	    fonts.insert(key, bf);
+	}
+	if (bf && !bf->ok()) {
+	    ++nfailed;
+	    continue;
+	}
+
+	for (; nrunning >= batch_jobs; --nrunning)
+	    if (!wait_batch_job(errh))
+		++nfailed;
+
+	fflush(stdout);
+	fflush(stderr);
+	pid_t child = fork();
+	if (child < 0)
+	    errh->fatal("%s during fork", strerror(errno));
+	else if (child == 0)
+	    exit(run_batch_job(args, bf, &lerrh));
+	++nrunning;
+    }
+
+    for (; nrunning > 0; --nrunning)
+	if (!wait_batch_job(errh))
+	    ++nfailed;
+    if (lock_file)
+	fclose(lock_file);
+
+    if (nfailed)
+	errh->error("%d of %d batch jobs failed", nfailed, njobs);
+    return (nfailed ? 1 : 0);
+}
 #endif
-		glyphlist_files.push_back(GLYPHLISTDIR "/glyphlist.txt");
+
+int
+main(int argc, char *argv[])
+{
+#ifndef WIN32
+    handle_sigchld();
+#endif
+    Clp_Parser *clp =
+	Clp_NewParser(argc, (const char * const *)argv, sizeof(options) / sizeof(options[0]), options);
+    Clp_AddType(clp, CHAR_OPTTYPE, 0, clp_parse_char, 0);
+    program_name = Clp_ProgramName(clp);
 #if HAVE_KPATHSEA
-	    if (String g = kpsei_find_file("texglyphlist.txt", KPSEI_FMT_MAP)) {
-		glyphlist_files.push_back(g);
-		if (verbose)
-		    errh->message("texglyphlist.txt found with kpathsea at %s", g.c_str());
-	    } else
+    kpsei_init(argv[0], "lcdftools");
 #endif
-		glyphlist_files.push_back(GLYPHLISTDIR "/texglyphlist.txt");
-	}
+#ifdef HAVE_CTIME
+    {
+	time_t t = time(0);
+	char *c = ctime(&t);
+	current_time = " on " + String(c).substring(0, -1); // get rid of \n
+    }
+#endif
+    for (int i = 0; i < argc; i++)
+	invocation << (i ? " " : "") << argv[i];
 
-	// read glyphlist
-	for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++)
-	    if (String s = read_file(*g, errh, true))
-		DvipsEncoding::add_glyphlist(s);
+    ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
+    parse_options(clp, errh);
 
-	// read base encodings
-	for (String *s = base_encoding_files.begin(); s < base_encoding_files.end(); s++)
-	    parse_base_encodings(*s, errh);
+    if (batch_file) {
+#if !defined(WIN32) && HAVE_WAITPID && HAVE_SYS_WAIT_H
+	return run_batch(errh);
+#else
+	errh->fatal("%<--batch%> is not supported on this platform");
+#endif
+    }
 
-	// read encoding
-	DvipsEncoding dvipsenc;
-	if (encoding_file) {
-	    if (String path = locate_encoding(encoding_file, errh))
-		dvipsenc.parse(path, no_ecommand, no_ecommand, errh);
-	    else
-		errh->fatal("encoding %<%s%> not found", encoding_file.c_str());
-	} else {
-            String cff_data(otf.table("CFF"));
-            if (!cff_data) {
-                errh->error("explicit encoding required for TrueType fonts");
-                errh->message("(Use %<-e ENCODING%> to choose an encoding. %<-e texnansx%> often works.)");
-                exit(1);
-            } else if (!have_encoding_file) {
-                errh->warning("no encoding provided");
-                errh->message("(Use %<-e ENCODING%> to choose an encoding. %<-e texnansx%> often works,\nor say %<-e -%> to turn off this warning.)");
-            }
+    finish_options(errh);
 
-	    // use encoding from font
-	    Cff cff(cff_data, otf.units_per_em(), &bail_errh);
-	    Cff::FontParent *font = cff.font(PermString(), &bail_errh);
-	    assert(cff.ok() && font->ok());
-	    if (Type1Encoding *t1e = font->type1_encoding()) {
-		for (int i = 0; i < 256; i++)
-		    dvipsenc.encode(i, (*t1e)[i]);
-	    } else
-		errh->fatal("font has no encoding, specify one explicitly");
-	    delete font;
-	}
+    try {
+	// read font
+	otf_data = read_file(input_file, errh);
+	if (errh->nerrors())
+	    exit(1);
+
+	LandmarkErrorHandler cerrh(errh, printable_filename(input_file));
+	BailErrorHandler bail_errh(&cerrh);
+
+	OpenType::Font otf(otf_data, &bail_errh, font_face);
+	assert(otf.ok());
+
+	read_glyphlists(0, errh);
 
-	// apply default ligkern commands
-	if (default_ligkern)
-	    dvipsenc.parse_ligkern(default_ligkerns, 0, ErrorHandler::silent_handler());
-
-	// apply command-line ligkern commands and coding scheme
-	cerrh.set_landmark("--ligkern command");
-	for (int i = 0; i < ligkern.size(); i++)
-	    dvipsenc.parse_ligkern(ligkern[i], 1, &cerrh);
-	cerrh.set_landmark("--position command");
-	for (int i = 0; i < pos.size(); i++)
-	    dvipsenc.parse_position(pos[i], 1, &cerrh);
-	cerrh.set_landmark("--unicoding command");
-	for (int i = 0; i < unicoding.size(); i++)
-	    dvipsenc.parse_unicoding(unicoding[i], 1, &cerrh);
-	if (codingscheme)
-	    dvipsenc.set_coding_scheme(codingscheme);
-	if (warn_missing >= 0)
-	    dvipsenc.set_warn_missing(warn_missing);
-
-	do_file(input_file, otf, dvipsenc, literal_encoding, errh);
+	FontInfo finfo(&otf, errh);
+	do_job(otf, finfo, errh);
 
     } catch (OpenType::Error e) {
 	errh->error("unhandled exception %<%s%>", e.description.c_str());
@@ -17,12 +17,15 @@
 #include "automatic.hh"
 #include "otftotfm.hh"
 #include "util.hh"
+#include "fontcache.hh"
 #include <efont/t1bounds.hh>
 #include <efont/t1font.hh>
 #include <efont/t1rw.hh>
 #include <efont/otfname.hh>
 #include <efont/otfos2.hh>
 #include <efont/otfpost.hh>
+#include <efont/otfgsub.hh>
+#include <efont/otfgpos.hh>
 #include <efont/t1csgen.hh>
 #include <efont/t1unparser.hh>
 #include <efont/ttfcs.hh>
@@ -87,8 +90,10 @@ enum {
 
 
 FontInfo::FontInfo(const Efont::OpenType::Font *otf_, ErrorHandler *errh)
-    : otf(otf_), cmap(0), cff_file(0), cff(0), post(0), name(0), _nglyphs(-1),
-      _got_glyph_names(false), _ttb_program(0), _override_is_fixed_pitch(false),
+    : otf(otf_), cmap(0), cff_file(0), cff(0), post(0), name(0), cache(0),
+      _nglyphs(-1), _got_glyph_names(false), _unicode_map(0),
+      _got_unicode_map(false), _ttb_program(0), _gsub(0), _gpos(0),
+      _got_gsub(false), _got_gpos(false), _bounds_jobs(1), _override_is_fixed_pitch(false),
       _override_italic_angle(false), _override_x_height(x_height_auto)
 {
     cmap = new Efont::OpenType::Cmap(otf->table("cmap"), errh);
@@ -128,7 +133,11 @@ FontInfo::~FontInfo()
     delete cff;
     delete post;
     delete name;
+    for (Efont::GlyphBoundsTable **t = _bounds_tables.begin(); t != _bounds_tables.end(); ++t)
+	delete *t;
     delete _ttb_program;
+    delete _gsub;
+    delete _gpos;
 }
 
 bool
@@ -140,10 +149,59 @@ FontInfo::ok() const
 	return post && post->ok() && name && name->ok();
 }
 
+static void
+throw_table_error(const char *table, const String &error)
+{
+    // an empty error means the table was blank
+    if (!error)
+	throw Efont::OpenType::BlankTable(table);
+    throw Efont::OpenType::Error(error);
+}
+
+const Efont::OpenType::Gsub &
+FontInfo::gsub(ErrorHandler *errh) const
+{
+    // Parse the GSUB header once per font, so batch jobs on the same font
+    // share it.  A table that fails to parse fails the same way every time.
+    if (!_got_gsub) {
+	try {
+	    _gsub = new Efont::OpenType::Gsub(otf->table("GSUB"), otf, errh);
+	} catch (Efont::OpenType::BlankTable) {
+	} catch (Efont::OpenType::Error e) {
+	    _gsub_error = e.description;
+	}
+	_got_gsub = true;
+    }
+    if (!_gsub)
+	throw_table_error("GSUB", _gsub_error);
+    return *_gsub;
+}
+
+const Efont::OpenType::Gpos &
+FontInfo::gpos(ErrorHandler *errh) const
+{
+    if (!_got_gpos) {
+	try {
+	    _gpos = new Efont::OpenType::Gpos(otf->table("GPOS"), errh);
+	} catch (Efont::OpenType::BlankTable) {
+	} catch (Efont::OpenType::Error e) {
+	    _gpos_error = e.description;
+	}
+	_got_gpos = true;
+    }
+    if (!_gpos)
+	throw_table_error("GPOS", _gpos_error);
+    return *_gpos;
+}
+
 bool
 FontInfo::glyph_names(Vector<PermString> &glyph_names) const
 {
+    if (cache && cache->find_glyph_names(glyph_names))
+	return true;
     program()->glyph_names(glyph_names);
+    if (cache)
+	cache->add_glyph_names(glyph_names);
     return true;
 }
 
@@ -164,6 +222,84 @@ FontInfo::glyphid(PermString name) const
     }
 }
 
+Efont::OpenType::Glyph
+FontInfo::map_uni(uint32_t uni) const
+{
+    if (!cache || uni == 0)
+	return cmap->map_uni(uni);
+    if (!_got_unicode_map) {
+	Vector<std::pair<uint32_t, Efont::OpenType::Glyph> > ugp;
+	if (!cache->find_unicode_map(ugp)) {
+	    cmap->unmap_all(ugp);
+	    cache->add_unicode_map(ugp);
+	}
+	// like map_uni, prefer the first mapping for a code point
+	for (const std::pair<uint32_t, Efont::OpenType::Glyph> *p = ugp.begin(); p != ugp.end(); ++p)
+	    if (p->first && p->second)
+		_unicode_map.find_force(p->first, p->second);
+	_got_unicode_map = true;
+    }
+    return _unicode_map[uni];
+}
+
+Efont::GlyphBoundsTable *
+FontInfo::bounds_table(const Transform &transform) const
+{
+    // otftotfm uses only a handful of different transforms
+    for (Efont::GlyphBoundsTable **t = _bounds_tables.begin(); t != _bounds_tables.end(); ++t) {
+	const Transform &xf = (*t)->transform();
+	int i = 0;
+	while (i < 6 && xf[i] == transform[i])
+	    ++i;
+	if (i == 6)
+	    return *t;
+    }
+    _bounds_tables.push_back(new Efont::GlyphBoundsTable(program(), transform));
+    return _bounds_tables.back();
+}
+
+bool
+FontInfo::glyph_bounds(const Transform &transform, Efont::OpenType::Glyph g,
+		       double bounds[4], double &width) const
+{
+    Efont::GlyphBoundsTable *table = bounds_table(transform);
+    bool ok;
+    if (!table->known(g) && cache
+	&& cache->find_bounds(transform, g, bounds, width, ok)) {
+	table->set(g, bounds, width, ok);
+	return ok;
+    }
+    bool computed = !table->known(g);
+    ok = table->get(g, bounds, width);
+    if (computed && cache)
+	cache->add_bounds(transform, g, bounds, width, ok);
+    return ok;
+}
+
+void
+FontInfo::prefetch_glyph_bounds(const Transform &transform,
+				const Vector<Efont::OpenType::Glyph> &glyphs) const
+{
+    Efont::GlyphBoundsTable *table = bounds_table(transform);
+    Vector<int> todo;
+    double bounds[4], width;
+    bool ok;
+    for (const Efont::OpenType::Glyph *g = glyphs.begin(); g != glyphs.end(); ++g)
+	if (!table->known(*g)) {
+	    if (cache && cache->find_bounds(transform, *g, bounds, width, ok))
+		table->set(*g, bounds, width, ok);
+	    else
+		todo.push_back(*g);
+	}
+    table->compute(todo, _bounds_jobs);
+    if (cache)
+	for (const int *g = todo.begin(); g != todo.end(); ++g)
+	    if (table->known(*g)) {
+		ok = table->get(*g, bounds, width);
+		cache->add_bounds(transform, *g, bounds, width, ok);
+	    }
+}
+
 String
 FontInfo::family_name() const
 {
@@ -295,9 +431,8 @@ Secondary::encode_uni(int code, PermString name, uint32_t uni, Metrics &metrics,
 	return false;
 }
 
-T1Secondary::T1Secondary(const FontInfo &finfo, const String &font_name,
-			 const String &otf_file_name)
-    : _finfo(finfo), _font_name(font_name), _otf_file_name(otf_file_name),
+T1Secondary::T1Secondary(const FontInfo &finfo, const String &font_name)
+    : _finfo(finfo), _font_name(font_name),
       _units_per_em(finfo.units_per_em()),
       _xheight((int) ceil(finfo.x_height(Transform()))),
       _spacewidth(_units_per_em)
@@ -334,7 +469,7 @@ T1Secondary::char_setting(Vector<Setting> &v, Metrics &metrics, int uni, ...)
     for (; uni; uni = va_arg(val, int)) {
 	int code = metrics.unicode_encoding(uni);
 	if (code < 0) {
-	    Glyph glyph = _finfo.cmap->map_uni(uni);
+	    Glyph glyph = _finfo.map_uni(uni);
 	    if (glyph == 0 || (code = metrics.force_encoding(glyph)) < 0)
 		return false;
 	}
@@ -397,7 +532,7 @@ T1Secondary::dotlessj_font(Metrics &metrics, ErrorHandler *errh, Glyph &dj_glyph
 	if (metrics.mapped_font_name(i) == dj_name)
 	    return i;
 
-    if (String filename = installed_type1_dotlessj(_otf_file_name, _finfo.cff->font_name(), (output_flags & G_DOTLESSJ), errh)) {
+    if (String filename = installed_type1_dotlessj(_finfo.cff, _finfo.cff->font_name(), (output_flags & G_DOTLESSJ), errh)) {
 
 	// check for special case: "\0" means the font's "j" is already
 	// dotless
@@ -711,8 +846,8 @@ bool
 char_bounds(double bounds[4], double& width, const FontInfo &finfo,
 	    const Transform &transform, uint32_t uni)
 {
-    if (Efont::OpenType::Glyph g = finfo.cmap->map_uni(uni))
-	return Efont::CharstringBounds::bounds(transform, finfo.program()->glyph_context(g), bounds, width);
+    if (Efont::OpenType::Glyph g = finfo.map_uni(uni))
+	return finfo.glyph_bounds(transform, g, bounds, width);
     else
 	return false;
 }
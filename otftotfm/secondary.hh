@@ -2,10 +2,13 @@
 #define OTFTOTFM_SECONDARY_HH
 #include <efont/otfcmap.hh>
 #include <efont/cff.hh>
+#include <lcdf/hashmap.hh>
 class Metrics;
 class Transform;
 struct Setting;
-namespace Efont { class TrueTypeBoundsCharstringProgram; }
+class FontCache;
+namespace Efont { class TrueTypeBoundsCharstringProgram; class GlyphBoundsTable;
+    namespace OpenType { class Gsub; class Gpos; } }
 
 struct FontInfo {
 
@@ -18,6 +21,8 @@ struct FontInfo {
     const Efont::OpenType::Post *post;
     const Efont::OpenType::Name *name;
 
+    FontCache *cache;
+
     FontInfo(const Efont::OpenType::Font *otf, ErrorHandler *);
     ~FontInfo();
 
@@ -26,7 +31,15 @@ struct FontInfo {
     int nglyphs() const			{ return _nglyphs; }
     bool glyph_names(Vector<PermString> &) const;
     int glyphid(PermString) const;
+    Efont::OpenType::Glyph map_uni(uint32_t uni) const;
+    bool glyph_bounds(const Transform &, Efont::OpenType::Glyph,
+		      double bounds[4], double &width) const;
+    void prefetch_glyph_bounds(const Transform &,
+			       const Vector<Efont::OpenType::Glyph> &) const;
+    void set_bounds_jobs(int n)		{ _bounds_jobs = n; }
     const Efont::CharstringProgram *program() const;
+    const Efont::OpenType::Gsub &gsub(ErrorHandler *) const;
+    const Efont::OpenType::Gpos &gpos(ErrorHandler *) const;
     int units_per_em() const {
 	return program()->units_per_em();
     }
@@ -58,8 +71,18 @@ struct FontInfo {
     int _nglyphs;
     mutable Vector<PermString> _glyph_names;
     mutable bool _got_glyph_names;
+    mutable HashMap<uint32_t, int> _unicode_map;
+    mutable bool _got_unicode_map;
     mutable Vector<uint32_t> _unicodes;
     mutable Efont::TrueTypeBoundsCharstringProgram *_ttb_program;
+    mutable Vector<Efont::GlyphBoundsTable *> _bounds_tables;
+    mutable Efont::OpenType::Gsub *_gsub;
+    mutable Efont::OpenType::Gpos *_gpos;
+    mutable bool _got_gsub;
+    mutable bool _got_gpos;
+    mutable String _gsub_error;
+    mutable String _gpos_error;
+    int _bounds_jobs;
     bool _override_is_fixed_pitch;
     bool _override_italic_angle;
     bool _is_fixed_pitch;
@@ -67,6 +90,8 @@ struct FontInfo {
     double _italic_angle;
     double _x_height;
 
+    Efont::GlyphBoundsTable *bounds_table(const Transform &) const;
+
 };
 
 class Secondary { public:
@@ -82,13 +107,12 @@ class Secondary { public:
 };
 
 class T1Secondary : public Secondary { public:
-    T1Secondary(const FontInfo &, const String &font_name, const String &otf_file_name);
+    T1Secondary(const FontInfo &, const String &font_name);
     bool encode_uni(int code, PermString name, uint32_t uni, Metrics &, ErrorHandler *);
     int setting(uint32_t uni, Vector<Setting> &, Metrics &, ErrorHandler *);
   private:
     const FontInfo &_finfo;
     String _font_name;
-    String _otf_file_name;
     int _units_per_em;
     int _xheight;
     int _spacewidth;
@@ -0,0 +1,771 @@
+// -*- related-file-name: "tfm.hh" -*-
+
+/* tfm.{cc,hh} -- write TFM and VF files
+ *
+ * Copyright (c) 2016 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include "tfm.hh"
+#include "util.hh"
+#include <lcdf/error.hh>
+#include <lcdf/straccum.hh>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+
+// The algorithms here follow pltotf and vptovf, down to the order in
+// which list nodes are merged, so that the files are the same as theirs.
+
+namespace {
+
+enum { unity = 1 << 20, max_fix = 0x7FFFFFFF };
+enum { width = 1, height = 2, depth = 3, italic = 4 };
+enum { no_tag = 0, lig_tag = 1 };
+enum { stop_flag = 128, kern_flag = 128, no_label = 0x7FFF };
+
+struct LigKernWord {
+    unsigned char b0, b1, b2, b3;
+    LigKernWord(int b0_, int b1_, int b2_, int b3_)
+	: b0(b0_), b1(b1_), b2(b2_), b3(b3_) { }
+};
+
+struct Label {
+    int cc;
+    int rr;
+};
+
+class TfmCompiler { public:
+
+    TfmCompiler(const PlFont &pl, ErrorHandler *errh);
+
+    String tfm() const;
+    String vf() const;
+
+  private:
+
+    const PlFont &_pl;
+    ErrorHandler *_errh;
+
+    int _design_size;
+    int _design_units;
+
+    // dimension lists: node 0 is a sentinel, nodes 1-4 head the lists
+    Vector<int> _memory;
+    Vector<int> _link;
+    Vector<int> _index;
+    int _next_d;
+    int _excess;
+
+    int _char_wd[256];
+    int _char_ht[256];
+    int _char_dp[256];
+    int _char_ic[256];
+    int _char_tag[256];
+    int _char_remainder[256];
+    int _char_pl[256];
+
+    int _bchar;
+    int _bchar_label;
+    int _min_nl;
+    Vector<LigKernWord> _lig_kern;
+    Vector<int> _kern;
+    int _lk_offset;
+    bool _extra_loc_needed;
+    Vector<Label> _label_table;
+    int _label_ptr;
+
+    Vector<int> _param;
+    int _bc;
+    int _ec;
+    unsigned char _check_sum[4];
+
+    int scan_fix(const String &str) const;
+    int scaled(int x) const;
+    void out_scaled(StringAccum &sa, int x) const;
+    void out_fix(StringAccum &sa, int opcode, int x) const;
+    int char_code(int c) const;
+
+    int sort_in(int h, int d);
+    int min_cover(int h, int d);
+    int shorten(int h, int m);
+    void set_indices(int h, int d);
+
+    void read_lig_kerns();
+    void finish_lig_kerns();
+    void pack_dimensions(int h, int m, const char *name);
+    void compute_lk_offset();
+    void compute_check_sum();
+    void store_packet(StringAccum &sa, int c) const;
+
+};
+
+inline void
+out_two(StringAccum &sa, int x)
+{
+    sa << (char) ((x >> 8) & 255) << (char) (x & 255);
+}
+
+inline void
+out_four(StringAccum &sa, int x)
+{
+    sa << (char) ((x >> 24) & 255) << (char) ((x >> 16) & 255)
+       << (char) ((x >> 8) & 255) << (char) (x & 255);
+}
+
+TfmCompiler::TfmCompiler(const PlFont &pl, ErrorHandler *errh)
+    : _pl(pl), _errh(errh), _next_d(0), _excess(0),
+      _bchar(256), _bchar_label(no_label), _min_nl(0), _lk_offset(0),
+      _extra_loc_needed(false), _label_ptr(0), _bc(0), _ec(0)
+{
+    _design_size = (pl.design_size ? scan_fix(pl.design_size) : 10 * unity);
+    if (_design_size < unity) {
+	_errh->error("the design size must be at least 1");
+	_design_size = 10 * unity;
+    }
+    _design_units = (pl.design_units ? scan_fix(pl.design_units) : unity);
+    if (_design_units <= 0) {
+	_errh->error("the number of units per design size must be positive");
+	_design_units = unity;
+    }
+
+    for (int i = 0; i <= italic; i++) {
+	_memory.push_back(i == 0 ? max_fix : 0);
+	_link.push_back(0);
+    }
+    for (int c = 0; c < 256; c++)
+	_char_wd[c] = _char_ht[c] = _char_dp[c] = _char_ic[c] =
+	    _char_tag[c] = _char_remainder[c] = 0;
+    for (int c = 0; c < 256; c++)
+	_char_pl[c] = -1;
+
+    for (int i = 0; i < pl.param_numbers.size(); i++) {
+	int n = pl.param_numbers[i];
+	if (n >= _param.size())
+	    _param.resize(n + 1, 0);
+	_param[n] = scan_fix(pl.params[i]);
+    }
+    if (pl.boundary_char >= 0 && pl.boundary_char < 256)
+	_bchar = pl.boundary_char;
+
+    read_lig_kerns();
+
+    for (int i = 0; i < pl.chars.size(); i++) {
+	const PlFont::Char &ch = pl.chars[i];
+	int c = ch.code;
+	if (c < 0 || c >= 256)
+	    continue;
+	if (_char_wd[c])
+	    _errh->warning("character %d appears twice", c);
+	_char_pl[c] = i;
+	_char_wd[c] = sort_in(width, 0);
+	if (ch.wd)
+	    _char_wd[c] = sort_in(width, scan_fix(ch.wd));
+	if (ch.ht)
+	    _char_ht[c] = sort_in(height, scan_fix(ch.ht));
+	if (ch.dp)
+	    _char_dp[c] = sort_in(depth, scan_fix(ch.dp));
+	if (ch.ic)
+	    _char_ic[c] = sort_in(italic, scan_fix(ch.ic));
+    }
+
+    finish_lig_kerns();
+    _index.resize(_memory.size(), 0);
+    pack_dimensions(width, 255, "widths");
+    pack_dimensions(height, 15, "heights");
+    pack_dimensions(depth, 15, "depths");
+    pack_dimensions(italic, 63, "italic corrections");
+
+    for (_bc = 0; _bc < 255 && !_char_wd[_bc]; _bc++)
+	/* nada */;
+    for (_ec = 255; _ec > 0 && !_char_wd[_ec]; _ec--)
+	/* nada */;
+    if (_bc > _ec)
+	_bc = 1;
+    for (int h = width; h <= italic; h++)
+	_memory[h]++;
+
+    compute_lk_offset();
+    compute_check_sum();
+}
+
+// Scan a real number the way pltotf does: at most 7 fraction digits,
+// rounded to the nearest multiple of 2^-20.
+int
+TfmCompiler::scan_fix(const String &str) const
+{
+    const char *s = str.begin(), *end = str.end();
+    bool negative = false;
+    for (; s != end && (*s == '-' || *s == '+' || *s == ' '); s++)
+	if (*s == '-')
+	    negative = !negative;
+
+    int acc = 0;
+    for (; s != end && isdigit((unsigned char) *s); s++) {
+	acc = acc * 10 + *s - '0';
+	if (acc >= 2048) {
+	    _errh->error("real constants must be less than 2048");
+	    return 0;
+	}
+    }
+
+    int int_part = acc;
+    acc = 0;
+    if (s != end && *s == '.') {
+	int fraction_digits[8];
+	int j = 0;
+	for (s++; s != end && isdigit((unsigned char) *s); s++)
+	    if (j < 7)
+		fraction_digits[++j] = (1 << 21) * (*s - '0');
+	for (; j > 0; j--)
+	    acc = fraction_digits[j] + acc / 10;
+	acc = (acc + 10) / 20;
+    }
+
+    if (acc >= unity && int_part == 2047) {
+	_errh->error("real constants must be less than 2048");
+	return 0;
+    }
+    acc += int_part * unity;
+    return negative ? -acc : acc;
+}
+
+// Convert from design units to multiples of the design size.
+int
+TfmCompiler::scaled(int x) const
+{
+    if (_design_units != unity) {
+	double v = ((double) x / _design_units) * 1048576.0;
+	x = (int) (v >= 0 ? floor(v + 0.5) : -floor(-v + 0.5));
+    }
+    return x;
+}
+
+void
+TfmCompiler::out_scaled(StringAccum &sa, int x) const
+{
+    if (fabs((double) x / _design_units) >= 16.0) {
+	_errh->warning("the relative dimension %.3f is too large", (double) x / unity);
+	x = 0;
+    }
+    x = scaled(x);
+    if (x < 0) {
+	sa << (char) 255;
+	x += 1 << 24;
+	if (x <= 0)
+	    x = 1;
+    } else {
+	sa << (char) 0;
+	if (x >= (1 << 24))
+	    x = (1 << 24) - 1;
+    }
+    sa << (char) (x >> 16) << (char) ((x >> 8) & 255) << (char) (x & 255);
+}
+
+// Store a DVI movement, using the shortest form of OPCODE.
+void
+TfmCompiler::out_fix(StringAccum &sa, int opcode, int x) const
+{
+    x = scaled(x);
+    if (abs(x) >= (1 << 23)) {
+	sa << (char) (opcode + 3);
+	out_four(sa, x);
+    } else if (abs(x) >= (1 << 15)) {
+	sa << (char) (opcode + 2) << (char) ((x >> 16) & 255);
+	out_two(sa, x);
+    } else if (abs(x) >= (1 << 7)) {
+	sa << (char) (opcode + 1);
+	out_two(sa, x);
+    } else
+	sa << (char) opcode << (char) (x & 255);
+}
+
+int
+TfmCompiler::char_code(int c) const
+{
+    if (c == PlFont::BOUNDARY_CHAR)
+	return (_bchar < 256 ? _bchar : 0);
+    else
+	return c & 255;
+}
+
+int
+TfmCompiler::sort_in(int h, int d)
+{
+    if (d == 0 && h != width)
+	return 0;
+    int p = h;
+    while (d >= _memory[_link[p]])
+	p = _link[p];
+    if (d == _memory[p] && p != h)
+	return p;
+    _memory.push_back(d);
+    _link.push_back(_link[p]);
+    _link[p] = _memory.size() - 1;
+    _memory[h]++;
+    return _memory.size() - 1;
+}
+
+// Return the number of intervals of length D needed to cover list H, and
+// set _next_d to the smallest D that would need fewer.
+int
+TfmCompiler::min_cover(int h, int d)
+{
+    int m = 0;
+    int p = _link[h];
+    _next_d = _memory[0];
+    while (p != 0) {
+	m++;
+	int l = _memory[p];
+	while ((long long) _memory[_link[p]] <= (long long) l + d)
+	    p = _link[p];
+	p = _link[p];
+	if ((long long) _memory[p] - l < _next_d)
+	    _next_d = _memory[p] - l;
+    }
+    return m;
+}
+
+int
+TfmCompiler::shorten(int h, int m)
+{
+    if (_memory[h] <= m)
+	return 0;
+    _excess = _memory[h] - m;
+    int k = min_cover(h, 0);
+    int d = _next_d;
+    do {
+	d += d;
+	k = min_cover(h, d);
+    } while (k > m);
+    d /= 2;
+    k = min_cover(h, d);
+    while (k > m) {
+	d = _next_d;
+	k = min_cover(h, d);
+    }
+    return d;
+}
+
+void
+TfmCompiler::set_indices(int h, int d)
+{
+    int q = h, p = _link[q], m = 0;
+    while (p != 0) {
+	m++;
+	int l = _memory[p];
+	_index[p] = m;
+	while ((long long) _memory[_link[p]] <= (long long) l + d) {
+	    p = _link[p];
+	    _index[p] = m;
+	    if (--_excess == 0)
+		d = 0;
+	}
+	_link[q] = p;
+	_memory[p] = l + (_memory[p] - l) / 2;
+	q = p;
+	p = _link[p];
+    }
+    _memory[h] = m;
+}
+
+void
+TfmCompiler::pack_dimensions(int h, int m, const char *name)
+{
+    int delta = shorten(h, m);
+    set_indices(h, delta);
+    if (delta > 0)
+	_errh->message("I had to round some %s by %.7f units.", name, ((delta + 1) / 2) / (double) unity);
+}
+
+void
+TfmCompiler::read_lig_kerns()
+{
+    bool lk_step_ended = false;
+    for (const PlFont::LigKern *lk = _pl.lig_kerns.begin();
+	 lk != _pl.lig_kerns.end(); lk++)
+	switch (lk->type) {
+
+	  case PlFont::LigKern::LABEL:
+	    if (lk->c == PlFont::BOUNDARY_CHAR)
+		_bchar_label = _lig_kern.size();
+	    else {
+		_char_tag[lk->c & 255] = lig_tag;
+		_char_remainder[lk->c & 255] = _lig_kern.size();
+	    }
+	    if (_min_nl <= _lig_kern.size())
+		_min_nl = _lig_kern.size() + 1;
+	    lk_step_ended = false;
+	    break;
+
+	  case PlFont::LigKern::STOP:
+	    if (!lk_step_ended)
+		_errh->error("STOP must follow LIG or KRN");
+	    else {
+		_lig_kern.back().b0 = stop_flag;
+		lk_step_ended = false;
+	    }
+	    break;
+
+	  case PlFont::LigKern::KRN: {
+	      int k = scan_fix(lk->kern), krn_ptr = 0;
+	      while (krn_ptr < _kern.size() && _kern[krn_ptr] != k)
+		  krn_ptr++;
+	      if (krn_ptr == _kern.size())
+		  _kern.push_back(k);
+	      _lig_kern.push_back(LigKernWord(0, char_code(lk->c), kern_flag + krn_ptr / 256, krn_ptr % 256));
+	      lk_step_ended = true;
+	      break;
+	  }
+
+	  case PlFont::LigKern::LIG:
+	    _lig_kern.push_back(LigKernWord(0, char_code(lk->c), lk->op, char_code(lk->result)));
+	    lk_step_ended = true;
+	    break;
+
+	}
+}
+
+void
+TfmCompiler::finish_lig_kerns()
+{
+    // check for steps that mention nonexistent characters
+    for (const LigKernWord *lk = _lig_kern.begin(); lk != _lig_kern.end(); lk++) {
+	if (!_char_wd[lk->b1] && lk->b1 != _bchar)
+	    _errh->warning("lig/kern step mentions nonexistent character %d", lk->b1);
+	if (lk->b2 < kern_flag && !_char_wd[lk->b3])
+	    _errh->warning("ligature step produces nonexistent character %d", lk->b3);
+    }
+
+    if (_lig_kern.size() > 0) {
+	if (_bchar_label < no_label)
+	    _lig_kern.push_back(LigKernWord(255, 0, 0, 0));
+	while (_min_nl > _lig_kern.size())
+	    _lig_kern.push_back(LigKernWord(255, 0, 0, 0));
+	if (_lig_kern.back().b0 == 0)
+	    _lig_kern.back().b0 = stop_flag;
+    }
+}
+
+void
+TfmCompiler::compute_lk_offset()
+{
+    // insert all labels into the label table, sorted by position
+    Label sentinel;
+    sentinel.cc = 0;
+    sentinel.rr = -1;
+    _label_table.push_back(sentinel);
+    _label_ptr = 0;
+    for (int c = _bc; c <= _ec; c++)
+	if (_char_tag[c] == lig_tag) {
+	    _label_table.push_back(sentinel);
+	    int sort_ptr = _label_ptr;
+	    while (_label_table[sort_ptr].rr > _char_remainder[c]) {
+		_label_table[sort_ptr + 1] = _label_table[sort_ptr];
+		sort_ptr--;
+	    }
+	    _label_table[sort_ptr + 1].cc = c;
+	    _label_table[sort_ptr + 1].rr = _char_remainder[c];
+	    _label_ptr++;
+	}
+
+    if (_bchar < 256) {
+	_extra_loc_needed = true;
+	_lk_offset = 1;
+    } else {
+	_extra_loc_needed = false;
+	_lk_offset = 0;
+    }
+
+    // labels beyond 255 are reached through extra instructions at the
+    // start of the program
+    int sort_ptr = _label_ptr;
+    if (_label_table[sort_ptr].rr + _lk_offset > 255) {
+	_lk_offset = 0;
+	_extra_loc_needed = false; // location 0 can do double duty
+	do {
+	    _char_remainder[_label_table[sort_ptr].cc] = _lk_offset;
+	    while (_label_table[sort_ptr - 1].rr == _label_table[sort_ptr].rr) {
+		sort_ptr--;
+		_char_remainder[_label_table[sort_ptr].cc] = _lk_offset;
+	    }
+	    _lk_offset++;
+	    sort_ptr--;
+	} while (_lk_offset + _label_table[sort_ptr].rr >= 256);
+    }
+    if (_lk_offset > 0)
+	for (; sort_ptr > 0; sort_ptr--)
+	    _char_remainder[_label_table[sort_ptr].cc] += _lk_offset;
+
+    if (_bchar_label < no_label) {
+	_lig_kern.back().b2 = (_bchar_label + _lk_offset) / 256;
+	_lig_kern.back().b3 = (_bchar_label + _lk_offset) % 256;
+    }
+}
+
+void
+TfmCompiler::compute_check_sum()
+{
+    long long c0 = _bc, c1 = _ec, c2 = _bc, c3 = _ec;
+    for (int c = _bc; c <= _ec; c++)
+	if (_char_wd[c] > 0) {
+	    long long x = scaled(_memory[_char_wd[c]]) + (c + 4) * (1LL << 22);
+	    c0 = (c0 + c0 + x) % 255;
+	    c1 = (c1 + c1 + x) % 253;
+	    c2 = (c2 + c2 + x) % 251;
+	    c3 = (c3 + c3 + x) % 247;
+	}
+    long long value = ((c0 * 256 + c1) * 256 + c2) * 256 + c3;
+    for (int i = 0; i < 4; i++)
+	_check_sum[i] = (value >> (24 - 8 * i)) & 255;
+}
+
+static void
+store_bcpl(unsigned char *header, const String &s, int size)
+{
+    int n = 0;
+    for (const char *x = s.begin(); x != s.end() && n < size - 1; x++, n++)
+	header[n + 1] = toupper((unsigned char) *x);
+    header[0] = n;
+}
+
+String
+TfmCompiler::tfm() const
+{
+    int lh = 18;
+    int nw = _memory[width], nh = _memory[height], nd = _memory[depth],
+	ni = _memory[italic];
+    int nl = _lig_kern.size(), nk = _kern.size(), ne = 0;
+    int np = (_param.size() ? _param.size() - 1 : 0);
+    int lf = 6 + lh + (_ec - _bc + 1) + nw + nh + nd + ni + nl + _lk_offset
+	+ nk + ne + np;
+
+    StringAccum sa(lf * 4);
+    out_two(sa, lf);
+    out_two(sa, lh);
+    out_two(sa, _bc);
+    out_two(sa, _ec);
+    out_two(sa, nw);
+    out_two(sa, nh);
+    out_two(sa, nd);
+    out_two(sa, ni);
+    out_two(sa, nl + _lk_offset);
+    out_two(sa, nk);
+    out_two(sa, ne);
+    out_two(sa, np);
+
+    // header
+    unsigned char header[18 * 4];
+    memset(header, 0, sizeof(header));
+    memcpy(&header[0], _check_sum, 4);
+    for (int i = 0; i < 4; i++)
+	header[4 + i] = (_design_size >> (24 - 8 * i)) & 255;
+    store_bcpl(&header[8], (_pl.coding_scheme ? _pl.coding_scheme : String("UNSPECIFIED")), 40);
+    store_bcpl(&header[48], (_pl.family ? _pl.family : String("UNSPECIFIED")), 20);
+    sa.append((const char *) header, sizeof(header));
+
+    // character info
+    for (int c = _bc; c <= _ec; c++) {
+	sa << (char) _index[_char_wd[c]]
+	   << (char) (_index[_char_ht[c]] * 16 + _index[_char_dp[c]])
+	   << (char) (_index[_char_ic[c]] * 4 + _char_tag[c])
+	   << (char) _char_remainder[c];
+    }
+
+    // dimensions
+    for (int q = width; q <= italic; q++) {
+	out_four(sa, 0);
+	for (int p = _link[q]; p > 0; p = _link[p])
+	    out_scaled(sa, _memory[p]);
+    }
+
+    // ligature/kern program
+    if (_extra_loc_needed)
+	sa << (char) 255 << (char) _bchar << (char) 0 << (char) 0;
+    else {
+	int label_ptr = _label_ptr;
+	for (int sort_ptr = 1; sort_ptr <= _lk_offset; sort_ptr++) {
+	    int t = _label_table[label_ptr].rr;
+	    if (_bchar < 256)
+		sa << (char) 255 << (char) _bchar;
+	    else
+		sa << (char) 254 << (char) 0;
+	    out_two(sa, t + _lk_offset);
+	    do {
+		label_ptr--;
+	    } while (_label_table[label_ptr].rr >= t);
+	}
+    }
+    for (const LigKernWord *lk = _lig_kern.begin(); lk != _lig_kern.end(); lk++)
+	sa << (char) lk->b0 << (char) lk->b1 << (char) lk->b2 << (char) lk->b3;
+    for (const int *k = _kern.begin(); k != _kern.end(); k++)
+	out_scaled(sa, *k);
+
+    // parameters; the slant is not scaled
+    for (int k = 1; k <= np; k++)
+	if (k == 1)
+	    out_four(sa, _param[1]);
+	else
+	    out_scaled(sa, _param[k]);
+
+    return sa.take_string();
+}
+
+void
+TfmCompiler::store_packet(StringAccum &sa, int c) const
+{
+    const PlFont::Char &ch = _pl.chars[_char_pl[c]];
+    if (!ch.has_map) {
+	if (c >= 128)
+	    sa << (char) 128;
+	sa << (char) c;
+	return;
+    }
+
+    for (const PlFont::Command *cmd = ch.map.begin(); cmd != ch.map.end(); cmd++)
+	switch (cmd->type) {
+
+	  case PlFont::Command::SETCHAR:
+	    if (cmd->c >= 128)
+		sa << (char) 128;
+	    sa << (char) cmd->c;
+	    break;
+
+	  case PlFont::Command::MOVERIGHT:
+	    out_fix(sa, 143, scan_fix(cmd->a));
+	    break;
+
+	  case PlFont::Command::MOVEUP:
+	    out_fix(sa, 157, -scan_fix(cmd->a));
+	    break;
+
+	  case PlFont::Command::SETRULE:
+	    sa << (char) 132;
+	    out_four(sa, scaled(scan_fix(cmd->a)));
+	    out_four(sa, scaled(scan_fix(cmd->b)));
+	    break;
+
+	  case PlFont::Command::SELECTFONT:
+	    if (cmd->c < 64)
+		sa << (char) (171 + cmd->c);
+	    else
+		sa << (char) 235 << (char) cmd->c;
+	    break;
+
+	  case PlFont::Command::PUSH:
+	    sa << (char) 141;
+	    break;
+
+	  case PlFont::Command::POP:
+	    sa << (char) 142;
+	    break;
+
+	  case PlFont::Command::SPECIAL: {
+	      const char *s = cmd->a.begin();
+	      while (s != cmd->a.end() && *s == ' ')
+		  s++;
+	      int len = cmd->a.end() - s;
+	      if (len < 256)
+		  sa << (char) 239 << (char) len;
+	      else {
+		  sa << (char) 242;
+		  out_four(sa, len);
+	      }
+	      sa.append(s, len);
+	      break;
+	  }
+
+	}
+}
+
+String
+TfmCompiler::vf() const
+{
+    StringAccum sa;
+
+    // preamble
+    sa << (char) 247 << (char) 202 << (char) 0;
+    sa.append((const char *) _check_sum, 4);
+    out_four(sa, _design_size);
+
+    // font definitions
+    for (int i = 0; i < _pl.map_font_names.size(); i++) {
+	const String &name = _pl.map_font_names[i];
+	sa << (char) 243 << (char) i;
+	out_four(sa, 0);
+	out_four(sa, unity);
+	out_four(sa, scan_fix(_pl.map_font_dsizes[i]));
+	sa << (char) 0 << (char) name.length() << name;
+    }
+
+    // character packets
+    StringAccum packet;
+    for (int c = _bc; c <= _ec; c++)
+	if (_char_wd[c] > 0) {
+	    packet.clear();
+	    store_packet(packet, c);
+	    int x = scaled(_memory[_char_wd[c]]);
+	    if (packet.length() < 242 && x >= 0 && x < (1 << 24)) {
+		sa << (char) packet.length() << (char) c
+		   << (char) (x >> 16) << (char) ((x >> 8) & 255) << (char) (x & 255);
+	    } else {
+		sa << (char) 242;
+		out_four(sa, packet.length());
+		out_four(sa, c);
+		out_four(sa, x);
+	    }
+	    sa << packet;
+	}
+
+    // postamble
+    do {
+	sa << (char) 248;
+    } while (sa.length() % 4 != 0);
+
+    return sa.take_string();
+}
+
+bool
+write_binary_file(const String &filename, const String &data, ErrorHandler *errh)
+{
+    if (verbose)
+	errh->message("creating %s", filename.c_str());
+    FILE *f = fopen(filename.c_str(), "wb");
+    if (!f) {
+	errh->error("%s: %s", filename.c_str(), strerror(errno));
+	return false;
+    }
+    ignore_result(fwrite(data.data(), 1, data.length(), f));
+    if (ferror(f) || fclose(f) != 0) {
+	errh->error("%s: %s", filename.c_str(), strerror(errno));
+	return false;
+    }
+    return true;
+}
+
+}
+
+bool
+write_tfm(const PlFont &pl, const String &tfm_filename,
+	  const String &vf_filename, ErrorHandler *errh)
+{
+    TfmCompiler tfmc(pl, errh);
+    if (!write_binary_file(tfm_filename, tfmc.tfm(), errh))
+	return false;
+    if (vf_filename && !write_binary_file(vf_filename, tfmc.vf(), errh))
+	return false;
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef OTFTOTFM_TFM_HH
+#define OTFTOTFM_TFM_HH
+#include <lcdf/string.hh>
+#include <lcdf/vector.hh>
+class ErrorHandler;
+
+// The contents of a PL or VPL file.  Real numbers are kept as the decimal
+// strings written to the file, so binary output matches what pltotf or
+// vptovf would produce from that file.
+
+struct PlFont {
+
+    enum { BOUNDARY_CHAR = 256 };
+
+    struct LigKern {
+	enum { LABEL, LIG, KRN, STOP };
+	int type;
+	int op;			// LIG: TFM op byte (0 LIG, 1 LIG/, 2 /LIG)
+	int c;			// LABEL: labeled char; LIG, KRN: next char
+	int result;		// LIG: ligature char
+	String kern;		// KRN: amount
+	LigKern(int type_, int op_ = 0, int c_ = 0, int result_ = 0,
+		const String &kern_ = String())
+	    : type(type_), op(op_), c(c_), result(result_), kern(kern_) { }
+    };
+
+    struct Command {
+	enum { SETCHAR, MOVERIGHT, MOVEUP, SETRULE, SELECTFONT, PUSH, POP,
+	       SPECIAL };
+	int type;
+	int c;			// SETCHAR: char; SELECTFONT: font number
+	int font;		// SETCHAR: metrics font number
+	String a;		// MOVERIGHT, MOVEUP: amount; SETRULE: height;
+				// SPECIAL: text
+	String b;		// SETRULE: width
+	Command(int type_, int c_ = 0, int font_ = 0,
+		const String &a_ = String(), const String &b_ = String())
+	    : type(type_), c(c_), font(font_), a(a_), b(b_) { }
+    };
+
+    struct Char {
+	int code;
+	String wd, ht, dp, ic;	// empty if not present
+	bool has_map;
+	Vector<Command> map;
+	Char(int code_)		: code(code_), has_map(false) { }
+    };
+
+    String family;
+    String coding_scheme;
+    String design_size;
+    String design_units;
+    Vector<int> param_numbers;	// FONTDIMEN, in file order
+    Vector<String> params;
+    int boundary_char;		// -1 if none
+    Vector<String> map_font_names; // MAPFONT D 0, 1, ...
+    Vector<String> map_font_dsizes;
+    Vector<LigKern> lig_kerns;
+    Vector<Char> chars;
+
+    PlFont()			: boundary_char(-1) { }
+
+};
+
+bool write_tfm(const PlFont &pl, const String &tfm_filename,
+	       const String &vf_filename, ErrorHandler *errh);
+
+#endif
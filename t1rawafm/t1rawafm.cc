@@ -46,15 +46,18 @@ using namespace Efont;
 #define HELP_OPT        302
 #define OUTPUT_OPT      303
 #define SMOKE_OPT       305
+#define JOBS_OPT        306
 
 const Clp_Option options[] = {
     { "help", 'h', HELP_OPT, 0, 0 },
     { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
+    { "jobs", 'j', JOBS_OPT, Clp_ValUnsigned, 0 },
     { "version", 0, VERSION_OPT, 0, 0 },
 };
 
 
 static const char *program_name;
+static int jobs = 1;
 static PermString::Initializer initializer;
 
 
@@ -86,6 +89,7 @@ font file from the standard input.\n\
 \n\
 Options:\n\
   -o, --output=FILE            Write output to FILE instead of standard output.\n\
+  -j, --jobs=N                 Use N processes to compute glyph bounds [1].\n\
   -h, --help                   Print this message and exit.\n\
       --version                Print version number and exit.\n\
 \n\
@@ -179,10 +183,10 @@ strip_newlines(const String &str)
 }
 
 static void
-write_char(FILE *outf, int c, PermString n, Type1Charstring *g, const Transform &font_transform, Type1Font *font)
+write_char(FILE *outf, int c, PermString n, int gid, GlyphBoundsTable &bounds)
 {
     double bb[4], wx;
-    CharstringBounds::bounds(font_transform, CharstringContext(font, g), bb, wx);
+    bounds.get(gid, bb, wx);
     fprintf(outf, "C %d ; WX %d ; N %s ; B %d %d %d %d ;\n",
             c, (int) ceil(wx), n.c_str(),
             (int) floor(bb[0]), (int) floor(bb[1]),
@@ -215,24 +219,29 @@ Comment Generated by t1rawafm\n");
         font_transform.scale(1000);
     }
 
+    // every glyph's bounds are needed for FontBBox and the char metrics
+    GlyphBoundsTable bounds(font, font_transform);
+    bounds.compute_all(jobs);
+
     double bb[4], wx;
-    if (Type1Charstring *t1cs = font->glyph("H")) {
-        CharstringBounds::bounds(font_transform, CharstringContext(font, t1cs), bb, wx);
+    int gid;
+    if ((gid = font->glyphid("H")) >= 0) {
+        bounds.get(gid, bb, wx);
         if (bb[3])
             fprintf(outf, "CapHeight %d\n", (int) ceil(bb[3]));
     }
-    if (Type1Charstring *t1cs = font->glyph("x")) {
-        CharstringBounds::bounds(font_transform, CharstringContext(font, t1cs), bb, wx);
+    if ((gid = font->glyphid("x")) >= 0) {
+        bounds.get(gid, bb, wx);
         if (bb[3])
             fprintf(outf, "XHeight %d\n", (int) ceil(bb[3]));
     }
-    if (Type1Charstring *t1cs = font->glyph("d")) {
-        CharstringBounds::bounds(font_transform, CharstringContext(font, t1cs), bb, wx);
+    if ((gid = font->glyphid("d")) >= 0) {
+        bounds.get(gid, bb, wx);
         if (bb[3])
             fprintf(outf, "Ascender %d\n", (int) ceil(bb[3]));
     }
-    if (Type1Charstring *t1cs = font->glyph("p")) {
-        CharstringBounds::bounds(font_transform, CharstringContext(font, t1cs), bb, wx);
+    if ((gid = font->glyphid("p")) >= 0) {
+        bounds.get(gid, bb, wx);
         if (bb[1])
             fprintf(outf, "Descender %d\n", (int) floor(bb[1]));
     }
@@ -247,7 +256,7 @@ Comment Generated by t1rawafm\n");
 
     double fontbb[4] = { 1000000, 1000000, -1000000, -1000000 };
     for (int i = 0; i < font->nglyphs(); ++i) {
-        CharstringBounds::bounds(font_transform, CharstringContext(font, font->glyph(i)), bb, wx);
+        bounds.get(i, bb, wx);
         fontbb[0] = std::min(fontbb[0], bb[0]);
         fontbb[1] = std::min(fontbb[1], bb[1]);
         fontbb[2] = std::max(fontbb[2], bb[2]);
@@ -272,8 +281,8 @@ Comment Generated by t1rawafm\n");
         for (int i = 0; i < 256; ++i) {
             PermString n = enc->elt(i);
             if (!done_yet[n])
-                if (Type1Charstring *g = font->glyph(n)) {
-                    write_char(outf, i, n, g, font_transform, font);
+                if ((gid = font->glyphid(n)) >= 0) {
+                    write_char(outf, i, n, gid, bounds);
                     done_yet.insert(n, true);
                 }
         }
@@ -281,7 +290,7 @@ Comment Generated by t1rawafm\n");
     for (int i = 0; i < font->nglyphs(); ++i) {
         PermString n = font->glyph_name(i);
         if (!done_yet[n])
-            write_char(outf, -1, n, font->glyph(i), font_transform, font);
+            write_char(outf, -1, n, i, bounds);
     }
     fprintf(outf, "EndCharMetrics\n");
 
@@ -313,6 +322,10 @@ main(int argc, char *argv[])
             output_file = clp->vstr;
             break;
 
+        case JOBS_OPT:
+            jobs = (clp->val.u ? clp->val.u : 1);
+            break;
+
           case VERSION_OPT:
             printf("t1rawafm (LCDF typetools) %s\n", VERSION);
             printf("Copyright (C) 2008-2016 Eddie Kohler\n\
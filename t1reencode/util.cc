@@ -16,6 +16,7 @@
 #endif
 #include "util.hh"
 #include <lcdf/error.hh>
+#include <lcdf/mapfile.hh>
 #include <lcdf/straccum.hh>
 #include <lcdf/vector.hh>
 #include <stdio.h>
@@ -42,20 +43,13 @@ read_file(String filename, ErrorHandler *errh, bool warning)
 	return String();
     }
 
-    StringAccum sa;
-    int amt;
-    do {
-	if (char *x = sa.reserve(8192)) {
-	    amt = fread(x, 1, 8192, f);
-	    sa.adjust_length(amt);
-	} else
-	    amt = 0;
-    } while (amt != 0);
-    if (!feof(f) || ferror(f))
-	errh->xmessage((warning ? errh->e_warning : errh->e_error) + ErrorHandler::make_landmark_anno(filename), strerror(errno));
+    int f_errno;
+    String s = read_file_data(f, &f_errno);
+    if (f_errno)
+	errh->xmessage((warning ? errh->e_warning : errh->e_error) + ErrorHandler::make_landmark_anno(filename), strerror(f_errno));
     if (f != stdin)
 	fclose(f);
-    return sa.take_string();
+    return s;
 }
 
 String
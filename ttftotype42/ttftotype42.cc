@@ -19,6 +19,7 @@
 #include <efont/t1item.hh>
 #include <lcdf/clp.h>
 #include <lcdf/error.hh>
+#include <lcdf/mapfile.hh>
 #include <efont/cff.hh>
 #include <efont/otf.hh>
 #include <efont/otfname.hh>
@@ -47,8 +48,10 @@ using namespace Efont;
 #define HELP_OPT	302
 #define QUIET_OPT	303
 #define OUTPUT_OPT	306
+#define FACE_OPT	307
 
 const Clp_Option options[] = {
+    { "face", 0, FACE_OPT, Clp_ValUnsigned, 0 },
     { "help", 'h', HELP_OPT, 0, 0 },
     { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
     { "quiet", 'q', QUIET_OPT, 0, Clp_Negate },
@@ -85,6 +88,7 @@ Usage: %s [OPTIONS] [FONTFILE [OUTPUTFILE]]\n\
 \n\
 Options:\n\
   -o, --output=FILE            Write output to FILE.\n\
+      --face=N                 Use face N of a font collection [0].\n\
   -q, --quiet                  Do not generate any error messages.\n\
   -h, --help                   Print this message and exit.\n\
   -v, --version                Print version number and exit.\n\
@@ -161,7 +165,7 @@ fprint_sfnts(FILE *f, const String &data, bool glyf, const OpenType::Font &font)
 }
 
 static void
-do_file(const char *infn, const char *outfn, ErrorHandler *errh)
+do_file(const char *infn, const char *outfn, int face, ErrorHandler *errh)
 {
     FILE *f;
     if (!infn || strcmp(infn, "-") == 0) {
@@ -179,22 +183,15 @@ do_file(const char *infn, const char *outfn, ErrorHandler *errh)
     if (c == EOF)
 	errh->fatal("%s: empty file", infn);
 
-    StringAccum sa(150000);
-    int amt;
-    do {
-	if (char *x = sa.reserve(32768)) {
-	    amt = fread(x, 1, 32768, f);
-	    sa.adjust_length(amt);
-	} else
-	    amt = 0;
-    } while (amt != 0);
-    if (!feof(f) || ferror(f))
-	errh->error("%s: %s", infn, strerror(errno));
+    int f_errno;
+    String data = read_file_data(f, &f_errno);
+    if (f_errno)
+	errh->error("%s: %s", infn, strerror(f_errno));
     if (f != stdin)
 	fclose(f);
 
     LandmarkErrorHandler cerrh(errh, infn);
-    OpenType::Font otf(sa.take_string(), &cerrh);
+    OpenType::Font otf(data, &cerrh, face);
     if (!otf.ok() || !otf.check_checksums(&cerrh))
 	return;
     if (otf.table("CFF"))
@@ -341,6 +338,7 @@ main(int argc, char *argv[])
     ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
     const char *input_file = 0;
     const char *output_file = 0;
+    int face = 0;
 
     while (1) {
 	int opt = Clp_Next(clp);
@@ -367,6 +365,10 @@ particular purpose.\n");
 	    exit(0);
 	    break;
 
+	  case FACE_OPT:
+	    face = clp->val.u;
+	    break;
+
 	  case OUTPUT_OPT:
 	  output_file:
 	    if (output_file)
@@ -397,7 +399,7 @@ particular purpose.\n");
     }
 
   done:
-    do_file(input_file, output_file, errh);
+    do_file(input_file, output_file, face, errh);
 
     return (errh->nerrors() == 0 ? 0 : 1);
 }